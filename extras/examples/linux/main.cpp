@@ -16,6 +16,11 @@
 
 #include <supla-common/tools.h>
 #include <linux_network.h>
+#include <linux_client.h>
+#include <linux_event_loop.h>
+#include <linux_storage.h>
+#include <linux_timers.h>
+#include <linux_worker_pool.h>
 #include <unistd.h>
 #include <fstream>
 #include <iostream>
@@ -156,6 +161,8 @@ int main(int argc, char* argv[]) {
     if (result.count("verbose") || config->isVerbose()) {
       logLevel = LOG_VERBOSE;
     }
+    // logs above selected level are dropped before formatting
+    supla_log_set_level(logLevel);
 
     SUPLA_LOG_INFO(" *** Starting supla-device ***");
     SUPLA_LOG_INFO("Using config file %s", cfgFile.c_str());
@@ -169,12 +176,26 @@ int main(int argc, char* argv[]) {
 
     SuplaDevice.setLastStateLogger(
         new Supla::Device::FileStateLogger(config->getStateFilesPath()));
+    // elements state (i.e. impulse counters, relays) is kept in
+    // storage.bin and storage.journal files in state files folder
+    auto storage = new Supla::LinuxStorage(config->getStateFilesPath());
     Supla::LinuxNetwork network;
+    if (config->isTlsSessionPersistenceEnabled()) {
+      Supla::LinuxClient::setSessionCachePath(config->getStateFilesPath());
+    }
 
     // configure defualt Supla CA certificate
     SuplaDevice.setSuplaCACert(suplaCACert);
     SuplaDevice.setSupla3rdPartyCACert(supla3rdCACert);
 
+    // Elements created from YAML config don't use onTimer/onFastTimer
+    Supla::Linux::Timers::setEnabled(false);
+    Supla::Linux::EventLoop::init();
+    // sources are read and parsed in background threads (optional)
+    if (config->getWorkerThreads() > 0) {
+      Supla::Linux::WorkerPool::start(config->getWorkerThreads());
+    }
+
     SuplaDevice.begin();
 
     if (SuplaDevice.getCurrentStatus() != STATUS_INITIALIZED) {
@@ -185,8 +206,11 @@ int main(int argc, char* argv[]) {
 
     while (st_app_terminate == 0) {
       SuplaDevice.iterate();
-      delay(10);
+      Supla::Linux::EventLoop::wait(100);
     }
+    Supla::Linux::WorkerPool::stop();
+    SuplaDevice.saveStateToStorage();
+    storage->waitForCompaction();
     SUPLA_LOG_INFO("Exit");
 
     exit(0);
@@ -16,25 +16,86 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <ctype.h>
 #include <string.h>
 #include <supla/log_wrapper.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <openssl/pem.h>
 #include <stdio.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <sys/ioctl.h>
+#include <supla/time.h>
 #include <unistd.h>
 
+#include <ctime>
+#include <filesystem>
+#include <mutex>   // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
 
 #include "linux_client.h"
+#include "linux_event_loop.h"
+
+namespace Supla {
+namespace Linux {
+struct ResolveRequest {
+  std::mutex mutex;
+  bool done = false;
+  bool abandoned = false;
+  int status = 0;
+  struct addrinfo *result = nullptr;
+};
+};  // namespace Linux
+};  // namespace Supla
+
+namespace {
+std::string sessionCachePath;
+uint32_t fullHandshakeCount = 0;
+uint32_t resumedHandshakeCount = 0;
+
+// getaddrinfo is blocking, so it is called from short living helper thread.
+// Request may be abandoned (i.e. on stop()) before thread finishes - in such
+// case result is released by the thread.
+void resolve(std::shared_ptr<Supla::Linux::ResolveRequest> request,
+             std::string host,
+             std::string port) {
+  struct addrinfo hints = {};
+  struct addrinfo *result = nullptr;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_protocol = IPPROTO_TCP;
+
+  int status = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+
+  {
+    std::lock_guard<std::mutex> lock(request->mutex);
+    if (request->abandoned) {
+      if (status == 0) {
+        freeaddrinfo(result);
+      }
+      return;
+    }
+    request->status = status;
+    request->result = status == 0 ? result : nullptr;
+    request->done = true;
+  }
+  Supla::Linux::EventLoop::wakeUp();
+}
+}  // namespace
 
 Supla::LinuxClient::LinuxClient() {
 }
 
 Supla::LinuxClient::~LinuxClient() {
+  stop();
+  if (session) {
+    SSL_SESSION_free(session);
+    session = nullptr;
+  }
   if (ctx) {
     SSL_CTX_free(ctx);
     ctx = nullptr;
@@ -42,114 +103,384 @@ Supla::LinuxClient::~LinuxClient() {
 }
 
 int Supla::LinuxClient::connectImp(const char *server, uint16_t port) {
-  struct addrinfo hints = {};
-  struct addrinfo *addresses = {};
-  hints.ai_family = AF_UNSPEC;
-  hints.ai_socktype = SOCK_STREAM;
-  hints.ai_protocol = IPPROTO_TCP;
+  if (state != ConnectState::Idle &&
+      (strncmp(server, host, sizeof(host)) != 0 || port != this->port)) {
+    // connection parameters changed during connect
+    stop();
+  }
+
+  if (state == ConnectState::Idle) {
+    startResolving(server, port);
+  }
+
+  while (iterateConnect()) {
+    if (state == ConnectState::Connected) {
+      return 1;
+    }
+    if (nonBlockingConnect) {
+      return 0;
+    }
+    waitForConnectEvent();
+  }
+
+  stop();
+  return 0;
+}
+
+bool Supla::LinuxClient::iterateConnect() {
+  bool result = true;
+  if (state == ConnectState::Resolving) {
+    result = iterateResolving();
+  }
+  if (result && state == ConnectState::TcpConnecting) {
+    result = iterateTcpConnect();
+  }
+  if (result && state == ConnectState::TlsHandshake) {
+    result = iterateTlsHandshake();
+  }
+  return result;
+}
+
+void Supla::LinuxClient::waitForConnectEvent() {
+  if (connectionFd < 0) {
+    delay(1);
+    return;
+  }
+  struct pollfd pfd = {};
+  pfd.fd = connectionFd;
+  pfd.events = state == ConnectState::TcpConnecting ? POLLOUT : POLLIN;
+  poll(&pfd, 1, 10);
+}
+
+bool Supla::LinuxClient::isConnecting() {
+  return state != ConnectState::Idle && state != ConnectState::Connected;
+}
+
+void Supla::LinuxClient::startResolving(const char *server, uint16_t port) {
+  strncpy(host, server, sizeof(host) - 1);
+  this->port = port;
 
   char portStr[10] = {};
   snprintf(portStr, sizeof(portStr), "%d", port);
 
-  const int status = getaddrinfo(server, portStr, &hints, &addresses);
-  if (status != 0) {
-    SUPLA_LOG_ERROR("%s: %s", server, gai_strerror(status));
-    return 0;
+  resolveRequest = std::make_shared<Supla::Linux::ResolveRequest>();
+  std::thread resolver(
+      resolve, resolveRequest, std::string(host), std::string(portStr));
+  resolver.detach();
+
+  state = ConnectState::Resolving;
+  stepStartMs = millis();
+}
+
+bool Supla::LinuxClient::iterateResolving() {
+  {
+    std::lock_guard<std::mutex> lock(resolveRequest->mutex);
+    if (!resolveRequest->done) {
+      // DNS timeouts are handled by resolver
+      return true;
+    }
+    if (resolveRequest->status != 0) {
+      SUPLA_LOG_ERROR("%s: %s", host, gai_strerror(resolveRequest->status));
+      return false;
+    }
+    addresses = resolveRequest->result;
+    resolveRequest->result = nullptr;
   }
+  resolveRequest.reset();
 
-  int err = 0;
-  int flagsCopy = 0;
-  for (struct addrinfo *addr = addresses; addr != nullptr;
-       addr = addr->ai_next) {
-    connectionFd = socket(
-        addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+  nextAddress = addresses;
+  return startTcpConnect(0);
+}
+
+bool Supla::LinuxClient::startTcpConnect(int err) {
+  while (nextAddress != nullptr) {
+    struct addrinfo *addr = nextAddress;
+    nextAddress = nextAddress->ai_next;
+
+    connectionFd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
     if (connectionFd == -1) {
       err = errno;
       continue;
     }
 
-    flagsCopy = fcntl(connectionFd, F_GETFL, 0);
     fcntl(connectionFd, F_SETFL, O_NONBLOCK);
+    Supla::Linux::EventLoop::addFd(connectionFd);
+    stepStartMs = millis();
     if (::connect(connectionFd, addr->ai_addr, addr->ai_addrlen) == 0) {
-      break;
+      clearAddresses();
+      return startTlsHandshake();
     }
 
     err = errno;
-    bool isConnected = false;
+    if (err == EWOULDBLOCK || err == EINPROGRESS) {
+      // wake up main loop when connect is finished
+      Supla::Linux::EventLoop::watchFdWrite(connectionFd, true);
+      state = ConnectState::TcpConnecting;
+      return true;
+    }
 
-    if (errno == EWOULDBLOCK || errno == EINPROGRESS) {
-      struct pollfd pfd = {};
-      pfd.fd = connectionFd;
-      pfd.events = POLLOUT;
+    closeConnection();
+  }
 
-      int result = poll(&pfd, 1, timeoutMs);
-      if (result > 0) {
-        socklen_t len = sizeof(err);
-        int retval = getsockopt(connectionFd, SOL_SOCKET, SO_ERROR, &err, &len);
+  SUPLA_LOG_ERROR("%s: %s", host, strerror(err));
+  return false;
+}
 
-        if (retval == 0 && err == 0) {
-          isConnected = true;
-        }
-      }
+bool Supla::LinuxClient::iterateTcpConnect() {
+  struct pollfd pfd = {};
+  pfd.fd = connectionFd;
+  pfd.events = POLLOUT;
+
+  int err = ETIMEDOUT;
+  if (poll(&pfd, 1, 0) > 0) {
+    socklen_t len = sizeof(err);
+    if (getsockopt(connectionFd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 &&
+        err == 0) {
+      Supla::Linux::EventLoop::watchFdWrite(connectionFd, false);
+      clearAddresses();
+      return startTlsHandshake();
+    }
+  } else if (millis() - stepStartMs < timeoutMs) {
+    return true;
+  }
+
+  closeConnection();
+  return startTcpConnect(err);
+}
+
+bool Supla::LinuxClient::startTlsHandshake() {
+  if (!sslEnabled) {
+    // TODO(klew): implement non ssl connection handling for Linux
+    onConnected();
+    return true;
+  }
+
+  if (ctx == nullptr) {
+    const SSL_METHOD *method = TLS_client_method();
+    ctx = SSL_CTX_new(method);
+
+    if (ctx == nullptr) {
+      SUPLA_LOG_ERROR("SSL_CTX_new failed");
+      return false;
+    }
+    if (rootCACert) {
+      SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+      // TODO(klew): add custom root CA verification
     }
+    // TLS 1.3 session tickets are received after handshake, so sessions are
+    // collected by callback instead of SSL_get1_session()
+    SSL_CTX_set_session_cache_mode(
+        ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, &Supla::LinuxClient::newSessionCallback);
+  }
+  ssl = SSL_new(ctx);
+  if (ssl == nullptr) {
+    SUPLA_LOG_ERROR("SSL_new() failed");
+    return false;
+  }
+  SSL_set_fd(ssl, connectionFd);
+  SSL_set_app_data(ssl, this);
+  SSL_set_tlsext_host_name(ssl, host);
+
+  if (session == nullptr || port != sessionPort ||
+      strncmp(host, sessionHost, sizeof(host)) != 0) {
+    loadSessionFromFile();
+  }
+  if (session && port == sessionPort &&
+      strncmp(host, sessionHost, sizeof(host)) == 0) {
+    SSL_set_session(ssl, session);
+  }
+
+  state = ConnectState::TlsHandshake;
+  stepStartMs = millis();
+  return true;
+}
 
-    if (isConnected) {
+bool Supla::LinuxClient::iterateTlsHandshake() {
+  int result = SSL_connect(ssl);
+  if (result == 1) {
+    if (SSL_session_reused(ssl)) {
+      resumedHandshakeCount++;
+    } else {
+      fullHandshakeCount++;
+    }
+    SUPLA_LOG_DEBUG("Connected with %s encryption%s (handshakes: %u full, "
+                    "%u resumed)",
+                    SSL_get_cipher(ssl),
+                    SSL_session_reused(ssl) ? ", session resumed" : "",
+                    fullHandshakeCount,
+                    resumedHandshakeCount);
+    if (!checkSslCerts(ssl)) {
+      return false;
+    }
+    Supla::Linux::EventLoop::watchFdWrite(connectionFd, false);
+    onConnected();
+    return true;
+  }
+
+  switch (SSL_get_error(ssl, result)) {
+    case SSL_ERROR_WANT_READ: {
+      Supla::Linux::EventLoop::watchFdWrite(connectionFd, false);
       break;
     }
-    close(connectionFd);
-    connectionFd = -1;
+    case SSL_ERROR_WANT_WRITE: {
+      Supla::Linux::EventLoop::watchFdWrite(connectionFd, true);
+      break;
+    }
+    default: {
+      printSslError(ssl, result);
+      return false;
+    }
+  }
+
+  if (millis() - stepStartMs >= timeoutMs) {
+    SUPLA_LOG_ERROR("%s: TLS handshake timeout", host);
+    return false;
   }
+  return true;
+}
 
-  freeaddrinfo(addresses);
+void Supla::LinuxClient::onConnected() {
+  state = ConnectState::Connected;
+}
 
-  if (connectionFd == -1) {
-    SUPLA_LOG_ERROR("%s: %s", server, strerror(err));
-    return 0;
+void Supla::LinuxClient::storeSession(SSL_SESSION *newSession) {
+  if (session) {
+    SSL_SESSION_free(session);
   }
+  session = newSession;
+  strncpy(sessionHost, host, sizeof(sessionHost) - 1);
+  sessionPort = port;
+  saveSessionToFile();
+}
 
-  fcntl(connectionFd, F_SETFL, flagsCopy);
+std::string Supla::LinuxClient::getSessionFileName() const {
+  std::string name = sessionCachePath + "/tls_session_";
+  for (const char *c = host; *c; c++) {
+    name += isalnum(*c) || *c == '.' || *c == '-' ? *c : '_';
+  }
+  name += "_" + std::to_string(port) + ".pem";
+  return name;
+}
 
-  if (sslEnabled) {
-    if (ctx == nullptr) {
-      const SSL_METHOD *method = TLS_client_method();
-      ctx = SSL_CTX_new(method);
+void Supla::LinuxClient::loadSessionFromFile() {
+  if (sessionCachePath.empty()) {
+    return;
+  }
 
-      if (ctx == nullptr) {
-        SUPLA_LOG_ERROR("SSL_CTX_new failed");
-        stop();
-        return 0;
-      }
-      if (rootCACert) {
-        SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
-        // TODO(klew): add custom root CA verification
-      }
-    }
-    ssl = SSL_new(ctx);
-    if (ssl == nullptr) {
-      SUPLA_LOG_ERROR("SSL_new() failed");
-      stop();
-      return 0;
+  std::string file = getSessionFileName();
+  FILE *fp = fopen(file.c_str(), "r");
+  if (fp == nullptr) {
+    return;
+  }
+  SSL_SESSION *loaded = PEM_read_SSL_SESSION(fp, nullptr, nullptr, nullptr);
+  fclose(fp);
+  if (loaded == nullptr) {
+    SUPLA_LOG_WARNING("TLS: invalid session file %s", file.c_str());
+    return;
+  }
+
+  uint64_t expiresAt =
+      SSL_SESSION_get_time(loaded) + SSL_SESSION_get_timeout(loaded);
+  if (!SSL_SESSION_is_resumable(loaded) ||
+      expiresAt <= static_cast<uint64_t>(time(nullptr))) {
+    SSL_SESSION_free(loaded);
+    return;
+  }
+
+  if (session) {
+    SSL_SESSION_free(session);
+  }
+  session = loaded;
+  strncpy(sessionHost, host, sizeof(sessionHost) - 1);
+  sessionPort = port;
+  SUPLA_LOG_DEBUG("TLS: loaded session from %s", file.c_str());
+}
+
+void Supla::LinuxClient::saveSessionToFile() {
+  if (sessionCachePath.empty() || session == nullptr) {
+    return;
+  }
+
+  if (!std::filesystem::exists(sessionCachePath)) {
+    std::error_code err;
+    if (!std::filesystem::create_directories(sessionCachePath, err)) {
+      SUPLA_LOG_WARNING("TLS: failed to create folder for session file");
+      return;
     }
-    SSL_set_fd(ssl, connectionFd);
-    SSL_connect(ssl);
+  }
 
-    SUPLA_LOG_DEBUG("Connected with %s encryption", SSL_get_cipher(ssl));
-    SSL_get_cipher(ssl);
-    if (!checkSslCerts(ssl)) {
-      stop();
-      return 0;
+  // session contains secrets, so file is readable only by owner. It is
+  // written to temporary file first, so it is never left partially written
+  std::string file = getSessionFileName();
+  std::string tmpFile = file + ".tmp";
+  int fd = open(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  FILE *fp = fd >= 0 ? fdopen(fd, "w") : nullptr;
+  if (fp == nullptr) {
+    if (fd >= 0) {
+      close(fd);
     }
-  } else {
-    // TODO(klew): implement non ssl connection handling for Linux
+    SUPLA_LOG_WARNING("TLS: failed to write session file %s", file.c_str());
+    return;
   }
+  bool result = PEM_write_SSL_SESSION(fp, session) == 1;
+  if (fclose(fp) != 0) {
+    result = false;
+  }
+  if (!result || rename(tmpFile.c_str(), file.c_str()) != 0) {
+    SUPLA_LOG_WARNING("TLS: failed to write session file %s", file.c_str());
+    unlink(tmpFile.c_str());
+  }
+}
+
+void Supla::LinuxClient::setSessionCachePath(const std::string &path) {
+  sessionCachePath = path;
+}
 
-  fcntl(connectionFd, F_SETFL, O_NONBLOCK);
+uint32_t Supla::LinuxClient::getFullHandshakeCount() {
+  return fullHandshakeCount;
+}
+
+uint32_t Supla::LinuxClient::getResumedHandshakeCount() {
+  return resumedHandshakeCount;
+}
 
+int Supla::LinuxClient::newSessionCallback(SSL *ssl, SSL_SESSION *session) {
+  auto client = reinterpret_cast<Supla::LinuxClient *>(SSL_get_app_data(ssl));
+  if (client == nullptr || !SSL_SESSION_is_resumable(session)) {
+    return 0;
+  }
+  client->storeSession(session);
+  // session ownership is taken by client
   return 1;
 }
 
+void Supla::LinuxClient::closeConnection() {
+  if (ssl) {
+    if (state == ConnectState::Connected) {
+      // session which wasn't shut down is removed from cache by SSL_free
+      SSL_shutdown(ssl);
+    }
+    SSL_free(ssl);
+  }
+  if (connectionFd >= 0) {
+    Supla::Linux::EventLoop::removeFd(connectionFd);
+    close(connectionFd);
+  }
+  connectionFd = -1;
+  ssl = nullptr;
+}
+
+void Supla::LinuxClient::clearAddresses() {
+  if (addresses) {
+    freeaddrinfo(addresses);
+  }
+  addresses = nullptr;
+  nextAddress = nullptr;
+}
+
 size_t Supla::LinuxClient::writeImp(const uint8_t *buf, size_t size) {
-  if (connectionFd == -1) {
+  if (connectionFd == -1 || state != ConnectState::Connected) {
     return 0;
   }
 
@@ -171,7 +502,7 @@ size_t Supla::LinuxClient::writeImp(const uint8_t *buf, size_t size) {
 }
 
 int Supla::LinuxClient::available() {
-  if (connectionFd < 0) {
+  if (connectionFd < 0 || state != ConnectState::Connected) {
     return 0;
   }
 
@@ -192,7 +523,7 @@ int Supla::LinuxClient::readImp(uint8_t *buf, size_t size) {
     return -1;
   }
 
-  if (connectionFd < 0) {
+  if (connectionFd < 0 || state != ConnectState::Connected) {
     return 0;
   }
 
@@ -202,6 +533,10 @@ int Supla::LinuxClient::readImp(uint8_t *buf, size_t size) {
     }
     response = SSL_read(ssl, buf, size);
     if (response > 0) {
+      if (SSL_pending(ssl) > 0) {
+        // decrypted data is buffered in SSL, so socket may not be readable
+        Supla::Linux::EventLoop::wakeUpIn(0);
+      }
       return response;
     } else {
       int sslError = SSL_get_error(ssl, response);
@@ -244,18 +579,22 @@ int Supla::LinuxClient::readImp(uint8_t *buf, size_t size) {
 }
 
 void Supla::LinuxClient::stop() {
-  if (ssl) {
-    SSL_free(ssl);
-  }
-  if (connectionFd >= 0) {
-    close(connectionFd);
+  if (resolveRequest) {
+    std::lock_guard<std::mutex> lock(resolveRequest->mutex);
+    if (resolveRequest->result) {
+      freeaddrinfo(resolveRequest->result);
+      resolveRequest->result = nullptr;
+    }
+    resolveRequest->abandoned = true;
   }
-  connectionFd = -1;
-  ssl = nullptr;
+  resolveRequest.reset();
+  clearAddresses();
+  closeConnection();
+  state = ConnectState::Idle;
 }
 
 uint8_t Supla::LinuxClient::connected() {
-  if (connectionFd == -1) {
+  if (connectionFd == -1 || state != ConnectState::Connected) {
     return false;
   }
 
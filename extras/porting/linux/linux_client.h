@@ -19,11 +19,29 @@
 #ifndef EXTRAS_PORTING_LINUX_LINUX_CLIENT_H_
 #define EXTRAS_PORTING_LINUX_LINUX_CLIENT_H_
 
+#include <netdb.h>
 #include <openssl/ssl.h>
 #include <supla/network/client.h>
+
+#include <memory>
+#include <string>
+
 #include "supla/network/network.h"
 
 namespace Supla {
+
+namespace Linux {
+struct ResolveRequest;
+};  // namespace Linux
+
+// Connection is established by state machine: DNS resolution in a helper
+// thread, non-blocking TCP connect and non-blocking TLS handshake.
+// With setNonBlockingConnect(true), connect() returns 0 with
+// isConnecting() == true while connection is in progress, and following
+// connect() calls (with the same host and port) advance it until 1 is
+// returned. Otherwise connect() blocks until the state machine finishes.
+// TLS session is cached (and optionally stored in file), so reconnect to the
+// same server is done with abbreviated handshake.
 class LinuxClient : public Client {
  public:
   LinuxClient();
@@ -32,21 +50,71 @@ class LinuxClient : public Client {
   int available() override;
   void stop() override;
   uint8_t connected() override;
+  bool isConnecting() override;
 
   void setTimeoutMs(uint16_t timeoutMs) override;
 
+  // Enables storing of TLS sessions in given folder, so they can be resumed
+  // after application restart. Empty path disables it.
+  static void setSessionCachePath(const std::string &path);
+  // Counters of TLS handshakes done by all clients
+  static uint32_t getFullHandshakeCount();
+  static uint32_t getResumedHandshakeCount();
+
  protected:
   int readImp(uint8_t *buf, size_t size) override;
   size_t writeImp(const uint8_t *buf, size_t size) override;
   int connectImp(const char *host, uint16_t port) override;
 
+  enum class ConnectState {
+    Idle,
+    Resolving,
+    TcpConnecting,
+    TlsHandshake,
+    Connected
+  };
+
   bool checkSslCerts(SSL *ssl);
   int32_t printSslError(SSL *ssl, int ret_code);
 
+  // Advances connection state machine. Returns false on failure
+  bool iterateConnect();
+  // Used by blocking connect, waits for progress on connection
+  void waitForConnectEvent();
+  void startResolving(const char *host, uint16_t port);
+  bool iterateResolving();
+  // Starts connect to next address from resolved list. err is reported
+  // when there are no more addresses to try.
+  bool startTcpConnect(int err);
+  bool iterateTcpConnect();
+  bool startTlsHandshake();
+  bool iterateTlsHandshake();
+  void onConnected();
+  void storeSession(SSL_SESSION *newSession);
+  void loadSessionFromFile();
+  void saveSessionToFile();
+  std::string getSessionFileName() const;
+  static int newSessionCallback(SSL *ssl, SSL_SESSION *session);
+  void closeConnection();
+  void clearAddresses();
+
   int connectionFd = -1;
   SSL_CTX *ctx = nullptr;
   SSL *ssl = nullptr;
   uint16_t timeoutMs = 3000;
+
+  ConnectState state = ConnectState::Idle;
+  std::shared_ptr<Supla::Linux::ResolveRequest> resolveRequest;
+  struct addrinfo *addresses = nullptr;
+  struct addrinfo *nextAddress = nullptr;
+  uint64_t stepStartMs = 0;
+  char host[SUPLA_SERVER_NAME_MAXSIZE] = {};
+  uint16_t port = 0;
+
+  // Last TLS session, used for resumption on reconnect to the same server
+  SSL_SESSION *session = nullptr;
+  char sessionHost[SUPLA_SERVER_NAME_MAXSIZE] = {};
+  uint16_t sessionPort = 0;
 };
 };  // namespace Supla
 
@@ -0,0 +1,217 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <SuplaDevice.h>
+#include <errno.h>
+#include <string.h>
+#include <supla/element.h>
+#include <supla/log_wrapper.h>
+#include <supla/protocol/supla_srpc.h>
+#include <supla/time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "linux_event_loop.h"
+
+namespace {
+int epollFd = -1;
+int timerFd = -1;
+int wakeUpFd = -1;
+uint64_t deadlineMs = 0;
+bool deadlineSet = false;
+uint32_t wakeUpCount = 0;
+
+const int MaxEvents = 8;
+
+bool addToEpoll(int fd, uint32_t events = EPOLLIN) {
+  struct epoll_event event = {};
+  event.events = events;
+  event.data.fd = fd;
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+    SUPLA_LOG_ERROR("EventLoop: epoll_ctl(ADD, %d) failed: %s",
+                    fd,
+                    strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+void drain(int fd) {
+  uint64_t value = 0;
+  while (::read(fd, &value, sizeof(value)) > 0) {
+  }
+}
+
+bool isSrpcInputPending() {
+  auto srpcLayer = SuplaDevice.getSrpcLayer();
+  return srpcLayer && srpcLayer->hasPendingInput();
+}
+}  // namespace
+
+bool Supla::Linux::EventLoop::init() {
+  if (epollFd >= 0) {
+    return true;
+  }
+
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  wakeUpFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (epollFd < 0 || timerFd < 0 || wakeUpFd < 0 || !addToEpoll(timerFd) ||
+      !addToEpoll(wakeUpFd)) {
+    SUPLA_LOG_ERROR("EventLoop: init failed, fallback to delay()");
+    deinit();
+    return false;
+  }
+
+  SUPLA_LOG_DEBUG("EventLoop: initialized");
+  return true;
+}
+
+void Supla::Linux::EventLoop::deinit() {
+  int *fds[] = {&epollFd, &timerFd, &wakeUpFd};
+  for (auto fd : fds) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
+void Supla::Linux::EventLoop::addFd(int fd, bool edgeTriggered) {
+  if (epollFd < 0 || fd < 0) {
+    return;
+  }
+  uint32_t events = EPOLLIN;
+  if (edgeTriggered) {
+    events |= EPOLLET;
+  }
+  addToEpoll(fd, events);
+}
+
+void Supla::Linux::EventLoop::removeFd(int fd) {
+  if (epollFd < 0 || fd < 0) {
+    return;
+  }
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void Supla::Linux::EventLoop::watchFdWrite(int fd, bool enabled) {
+  if (epollFd < 0 || fd < 0) {
+    return;
+  }
+  uint32_t events = EPOLLIN;
+  if (enabled) {
+    events |= EPOLLOUT;
+  }
+  struct epoll_event event = {};
+  event.events = events;
+  event.data.fd = fd;
+  if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == -1) {
+    SUPLA_LOG_ERROR("EventLoop: epoll_ctl(MOD, %d) failed: %s",
+                    fd,
+                    strerror(errno));
+  }
+}
+
+void Supla::Linux::EventLoop::wakeUpIn(uint32_t delayMs) {
+  uint64_t newDeadline = millis() + delayMs;
+  if (!deadlineSet || newDeadline < deadlineMs) {
+    deadlineMs = newDeadline;
+    deadlineSet = true;
+  }
+}
+
+void Supla::Linux::EventLoop::wakeUp() {
+  if (wakeUpFd >= 0) {
+    uint64_t value = 1;
+    if (::write(wakeUpFd, &value, sizeof(value)) < 0) {
+      SUPLA_LOG_DEBUG("EventLoop: wake up failed");
+    }
+  }
+}
+
+void Supla::Linux::EventLoop::wait(uint32_t maxWaitMs) {
+  uint64_t elementDeadline = 0;
+  if (Supla::Element::getNextDeadline(&elementDeadline)) {
+    uint64_t now = millis();
+    // at least 1 ms, so elements which poll on each iteration (i.e. PV
+    // inverters reading response) don't cause busy loop
+    wakeUpIn(elementDeadline > now ? elementDeadline - now : 1);
+  }
+
+  uint32_t timeoutMs = maxWaitMs;
+  if (deadlineSet) {
+    uint64_t now = millis();
+    timeoutMs = now >= deadlineMs ? 0 : deadlineMs - now;
+    if (timeoutMs > maxWaitMs) {
+      timeoutMs = maxWaitMs;
+    }
+    deadlineSet = false;
+  }
+
+  // packets already received from server, but not yet processed
+  if (isSrpcInputPending()) {
+    timeoutMs = 0;
+  }
+
+  if (epollFd < 0) {
+    if (timeoutMs > 0) {
+      delay(timeoutMs);
+    }
+    return;
+  }
+
+  int epollTimeout = 0;
+  if (timeoutMs > 0) {
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = timeoutMs / 1000;
+    spec.it_value.tv_nsec = (timeoutMs % 1000) * 1000000;
+    timerfd_settime(timerFd, 0, &spec, nullptr);
+    epollTimeout = -1;
+  }
+
+  struct epoll_event events[MaxEvents] = {};
+  int count = epoll_wait(epollFd, events, MaxEvents, epollTimeout);
+  if (count < 0 && errno != EINTR) {
+    SUPLA_LOG_ERROR("EventLoop: epoll_wait failed: %s", strerror(errno));
+    // avoid busy loop on persistent error
+    delay(timeoutMs);
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (events[i].data.fd == timerFd || events[i].data.fd == wakeUpFd) {
+      drain(events[i].data.fd);
+    }
+  }
+
+  if (timeoutMs > 0) {
+    struct itimerspec disarm = {};
+    timerfd_settime(timerFd, 0, &disarm, nullptr);
+  }
+
+  if (count > 0) {
+    wakeUpCount++;
+  }
+}
+
+uint32_t Supla::Linux::EventLoop::getWakeUpCount() {
+  return wakeUpCount;
+}
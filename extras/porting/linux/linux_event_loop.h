@@ -0,0 +1,68 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#ifndef EXTRAS_PORTING_LINUX_LINUX_EVENT_LOOP_H_
+#define EXTRAS_PORTING_LINUX_LINUX_EVENT_LOOP_H_
+
+#include <stdint.h>
+
+// epoll based replacement for "iterate(); delay(10);" main loop. Main thread
+// sleeps until one of registered file descriptors (i.e. connection with
+// Supla server) is readable, requested deadline (or element's
+// iterateAlways() deadline) passes, or wakeUp() is called from another
+// thread.
+//
+// Usage:
+//   Supla::Linux::EventLoop::init();
+//   while (...) {
+//     SuplaDevice.iterate();
+//     Supla::Linux::EventLoop::wait(100);
+//   }
+namespace Supla {
+namespace Linux {
+namespace EventLoop {
+// Returns false if epoll can't be used. In such case wait() falls back
+// to delay().
+bool init();
+void deinit();
+
+// Edge triggered fd wakes up loop only when new data arrives, so it doesn't
+// have to be read before next wait() (i.e. inotify fd read on parser refresh).
+void addFd(int fd, bool edgeTriggered = false);
+void removeFd(int fd);
+// Enables/disables wake up on fd being writable (i.e. during non-blocking
+// connect). Fd has to be added with addFd() first.
+void watchFdWrite(int fd, bool enabled);
+
+// Requests next wake up not later than delayMs from now. Earliest request
+// wins. Requests are cleared by wait().
+// Should be called from main thread.
+void wakeUpIn(uint32_t delayMs);
+
+// Interrupts wait(). Can be called from any thread.
+void wakeUp();
+
+// Blocks for up to maxWaitMs
+void wait(uint32_t maxWaitMs);
+
+uint32_t getWakeUpCount();
+};  // namespace EventLoop
+};  // namespace Linux
+};  // namespace Supla
+
+#endif  // EXTRAS_PORTING_LINUX_LINUX_EVENT_LOOP_H_
@@ -0,0 +1,435 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <supla/crc16.h>
+#include <supla/log_wrapper.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+
+#include "linux_storage.h"
+
+namespace {
+
+const char SnapshotTag[8] = {'S', 'U', 'P', 'L', 'A', 'S', 'T', '1'};
+const uint32_t JournalRecordMagic = 0x4C4E524A;  // "JRNL"
+
+#pragma pack(push, 1)
+struct SnapshotHeader {
+  char tag[8];
+  uint32_t sequence;
+  uint32_t size;
+  uint16_t crc;
+};
+
+struct JournalRecord {
+  uint32_t magic;
+  uint32_t sequence;
+  uint32_t offset;
+  uint16_t size;
+  uint16_t crc;
+};
+#pragma pack(pop)
+
+uint16_t recordCrc(const JournalRecord &record, const unsigned char *data) {
+  uint16_t crc =
+      crc16_update_buf(0xFFFF, &record, offsetof(JournalRecord, crc));
+  return crc16_update_buf(crc, data, record.size);
+}
+
+uint16_t snapshotCrc(const SnapshotHeader &header, const unsigned char *data) {
+  uint16_t crc =
+      crc16_update_buf(0xFFFF, &header.sequence, sizeof(header.sequence));
+  crc = crc16_update_buf(crc, &header.size, sizeof(header.size));
+  return crc16_update_buf(crc, data, header.size);
+}
+
+bool writeAll(int fd, const void *data, size_t size) {
+  auto ptr = reinterpret_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t written = ::write(fd, ptr, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    ptr += written;
+    size -= written;
+  }
+  return true;
+}
+
+void syncDirectory(const std::string &fileName) {
+  std::string dir = ".";
+  auto pos = fileName.find_last_of('/');
+  if (pos != std::string::npos) {
+    dir = fileName.substr(0, pos);
+  }
+  int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd >= 0) {
+    fsync(fd);
+    close(fd);
+  }
+}
+
+// Maps file read only. Returns nullptr for missing or empty file.
+const unsigned char *mapFile(const std::string &fileName, size_t *size) {
+  *size = 0;
+  int fd = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st = {};
+  void *data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  *size = st.st_size;
+  return reinterpret_cast<const unsigned char *>(data);
+}
+
+}  // namespace
+
+Supla::LinuxStorage::LinuxStorage(const std::string &path)
+    : Storage(0),
+      snapshotFile(path + "/storage.bin"),
+      journalFile(path + "/storage.journal"),
+      oldJournalFile(path + "/storage.journal.old"),
+      compactionDone(false) {
+  std::error_code err;
+  if (!std::filesystem::exists(path, err)) {
+    if (!std::filesystem::create_directories(path, err)) {
+      SUPLA_LOG_WARNING("Storage: failed to create folder %s", path.c_str());
+    }
+  }
+}
+
+Supla::LinuxStorage::~LinuxStorage() {
+  commit();
+  joinCompactionThread(true);
+  if (journalFd >= 0) {
+    close(journalFd);
+    journalFd = -1;
+  }
+}
+
+bool Supla::LinuxStorage::init() {
+  image.clear();
+  pendingRecords.clear();
+  sequence = 0;
+
+  loadSnapshot();
+
+  // old journal exists only when compaction was interrupted
+  bool compactionInterrupted = (access(oldJournalFile.c_str(), F_OK) == 0);
+  if (compactionInterrupted) {
+    replayJournal(oldJournalFile);
+  }
+
+  size_t validSize = replayJournal(journalFile);
+  struct stat st = {};
+  if (stat(journalFile.c_str(), &st) == 0 &&
+      static_cast<size_t>(st.st_size) > validSize) {
+    SUPLA_LOG_WARNING(
+        "Storage: dropping %d bytes of incomplete journal records",
+        static_cast<int>(st.st_size - validSize));
+    if (truncate(journalFile.c_str(), validSize) != 0) {
+      SUPLA_LOG_ERROR("Storage: journal truncate failed: %s", strerror(errno));
+    }
+  }
+
+  if (!openJournal()) {
+    SUPLA_LOG_ERROR("Storage: can't open journal %s: %s",
+                    journalFile.c_str(),
+                    strerror(errno));
+  }
+  journalSize = validSize;
+
+  if (compactionInterrupted &&
+      writeSnapshot(snapshotFile, image, sequence)) {
+    unlink(oldJournalFile.c_str());
+    if (journalFd >= 0 && ftruncate(journalFd, 0) == 0) {
+      journalSize = 0;
+    }
+  }
+
+  SUPLA_LOG_DEBUG("Storage: loaded %d bytes, journal %d bytes, seq %d",
+                  static_cast<int>(image.size()),
+                  static_cast<int>(journalSize),
+                  sequence);
+
+  return Storage::init();
+}
+
+void Supla::LinuxStorage::commit() {
+  joinCompactionThread(false);
+  if (pendingRecords.empty()) {
+    return;
+  }
+
+  if (journalFd < 0 ||
+      !writeJournal(pendingRecords.data(), pendingRecords.size())) {
+    SUPLA_LOG_ERROR("Storage: journal write failed: %s", strerror(errno));
+    // Partially written record would stop journal replay, so all following
+    // records would be lost. Journal is truncated to the last valid record
+    // and pending records are written again with next commit.
+    if (journalFd >= 0 && ftruncate(journalFd, journalSize) != 0) {
+      SUPLA_LOG_ERROR("Storage: journal truncate failed: %s",
+                      strerror(errno));
+    }
+    return;
+  }
+  journalSize += pendingRecords.size();
+  pendingRecords.clear();
+
+  if (journalSize >= compactionThreshold && !compactionThread.joinable()) {
+    startCompaction();
+  }
+}
+
+bool Supla::LinuxStorage::writeJournal(const unsigned char *data,
+                                       size_t size) {
+  return writeAll(journalFd, data, size) && fdatasync(journalFd) == 0;
+}
+
+void Supla::LinuxStorage::setCompactionThreshold(size_t bytes) {
+  compactionThreshold = bytes;
+}
+
+size_t Supla::LinuxStorage::getJournalSize() const {
+  return journalSize;
+}
+
+uint32_t Supla::LinuxStorage::getCompactionCount() const {
+  return compactionCount;
+}
+
+void Supla::LinuxStorage::waitForCompaction() {
+  joinCompactionThread(true);
+}
+
+int Supla::LinuxStorage::readStorage(unsigned int offset,
+                                     unsigned char *buf,
+                                     int size,
+                                     bool) {
+  if (size <= 0) {
+    return 0;
+  }
+  memset(buf, 0, size);
+  if (offset < image.size()) {
+    size_t available = image.size() - offset;
+    memcpy(buf,
+           image.data() + offset,
+           available < static_cast<size_t>(size) ? available : size);
+  }
+  return size;
+}
+
+int Supla::LinuxStorage::writeStorage(unsigned int offset,
+                                      const unsigned char *buf,
+                                      int size) {
+  if (size <= 0) {
+    return 0;
+  }
+  if (offset + size > image.size()) {
+    image.resize(offset + size, 0);
+  }
+  memcpy(image.data() + offset, buf, size);
+
+  for (int written = 0; written < size;) {
+    int chunk = size - written;
+    if (chunk > 0xFFFF) {
+      chunk = 0xFFFF;
+    }
+    JournalRecord record = {};
+    record.magic = JournalRecordMagic;
+    record.sequence = ++sequence;
+    record.offset = offset + written;
+    record.size = chunk;
+    record.crc = recordCrc(record, buf + written);
+
+    auto recordPtr = reinterpret_cast<const unsigned char *>(&record);
+    pendingRecords.insert(
+        pendingRecords.end(), recordPtr, recordPtr + sizeof(record));
+    pendingRecords.insert(
+        pendingRecords.end(), buf + written, buf + written + chunk);
+    written += chunk;
+  }
+  return size;
+}
+
+bool Supla::LinuxStorage::loadSnapshot() {
+  size_t fileSize = 0;
+  auto data = mapFile(snapshotFile, &fileSize);
+  if (data == nullptr) {
+    SUPLA_LOG_DEBUG("Storage: snapshot %s not found", snapshotFile.c_str());
+    return false;
+  }
+
+  bool valid = false;
+  SnapshotHeader header = {};
+  if (fileSize >= sizeof(header)) {
+    memcpy(&header, data, sizeof(header));
+    const unsigned char *content = data + sizeof(header);
+    valid = memcmp(header.tag, SnapshotTag, sizeof(SnapshotTag)) == 0 &&
+            header.size <= fileSize - sizeof(header) &&
+            header.crc == snapshotCrc(header, content);
+    if (valid) {
+      image.assign(content, content + header.size);
+      sequence = header.sequence;
+    }
+  }
+  munmap(const_cast<unsigned char *>(data), fileSize);
+
+  if (!valid) {
+    SUPLA_LOG_ERROR("Storage: snapshot %s is corrupted",
+                    snapshotFile.c_str());
+  }
+  return valid;
+}
+
+size_t Supla::LinuxStorage::replayJournal(const std::string &fileName) {
+  size_t fileSize = 0;
+  auto data = mapFile(fileName, &fileSize);
+  if (data == nullptr) {
+    return 0;
+  }
+
+  size_t position = 0;
+  int applied = 0;
+  while (position + sizeof(JournalRecord) <= fileSize) {
+    JournalRecord record = {};
+    memcpy(&record, data + position, sizeof(record));
+    const unsigned char *content = data + position + sizeof(record);
+    if (record.magic != JournalRecordMagic ||
+        position + sizeof(record) + record.size > fileSize ||
+        record.crc != recordCrc(record, content)) {
+      break;
+    }
+    // records older than snapshot are already included in it
+    if (record.sequence > sequence) {
+      if (record.offset + record.size > image.size()) {
+        image.resize(record.offset + record.size, 0);
+      }
+      memcpy(image.data() + record.offset, content, record.size);
+      sequence = record.sequence;
+      applied++;
+    }
+    position += sizeof(record) + record.size;
+  }
+  munmap(const_cast<unsigned char *>(data), fileSize);
+
+  SUPLA_LOG_DEBUG("Storage: %d records applied from %s",
+                  applied,
+                  fileName.c_str());
+  return position;
+}
+
+bool Supla::LinuxStorage::openJournal() {
+  journalFd = open(journalFile.c_str(),
+                   O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                   0600);
+  return journalFd >= 0;
+}
+
+void Supla::LinuxStorage::startCompaction() {
+  // If old journal still exists, then previous compaction failed. In such
+  // case current journal is not rotated and new snapshot will include both.
+  if (access(oldJournalFile.c_str(), F_OK) != 0) {
+    close(journalFd);
+    journalFd = -1;
+    if (rename(journalFile.c_str(), oldJournalFile.c_str()) != 0) {
+      SUPLA_LOG_ERROR("Storage: journal rotation failed: %s",
+                      strerror(errno));
+      openJournal();
+      return;
+    }
+    if (!openJournal()) {
+      SUPLA_LOG_ERROR("Storage: can't open journal %s: %s",
+                      journalFile.c_str(),
+                      strerror(errno));
+    }
+    syncDirectory(journalFile);
+    journalSize = 0;
+  }
+
+  SUPLA_LOG_DEBUG("Storage: starting compaction (seq %d)", sequence);
+  compactionCount++;
+  compactionDone = false;
+  compactionThread = std::thread([snapshotFile = snapshotFile,
+                                  oldJournalFile = oldJournalFile,
+                                  data = image,
+                                  sequence = sequence,
+                                  done = &compactionDone]() {
+    if (writeSnapshot(snapshotFile, data, sequence)) {
+      unlink(oldJournalFile.c_str());
+    } else {
+      SUPLA_LOG_ERROR("Storage: compaction failed");
+    }
+    *done = true;
+  });
+}
+
+void Supla::LinuxStorage::joinCompactionThread(bool wait) {
+  if (compactionThread.joinable() && (wait || compactionDone)) {
+    compactionThread.join();
+  }
+}
+
+bool Supla::LinuxStorage::writeSnapshot(const std::string &fileName,
+                                        const std::vector<unsigned char> &data,
+                                        uint32_t sequence) {
+  std::string tmpFileName = fileName + ".tmp";
+  int fd = open(tmpFileName.c_str(),
+                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0600);
+  if (fd < 0) {
+    SUPLA_LOG_ERROR("Storage: can't open %s: %s",
+                    tmpFileName.c_str(),
+                    strerror(errno));
+    return false;
+  }
+
+  SnapshotHeader header = {};
+  memcpy(header.tag, SnapshotTag, sizeof(SnapshotTag));
+  header.sequence = sequence;
+  header.size = data.size();
+  header.crc = snapshotCrc(header, data.data());
+
+  bool result = writeAll(fd, &header, sizeof(header)) &&
+                writeAll(fd, data.data(), data.size()) && fsync(fd) == 0;
+  close(fd);
+
+  if (!result || rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+    SUPLA_LOG_ERROR("Storage: writing snapshot failed: %s", strerror(errno));
+    unlink(tmpFileName.c_str());
+    return false;
+  }
+  syncDirectory(fileName);
+  return true;
+}
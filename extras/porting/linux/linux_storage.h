@@ -0,0 +1,97 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#ifndef EXTRAS_PORTING_LINUX_LINUX_STORAGE_H_
+#define EXTRAS_PORTING_LINUX_LINUX_STORAGE_H_
+
+#include <supla/storage/storage.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Supla {
+
+// File based Storage for Linux. Storage content is kept in memory and
+// persisted in two files in state files folder:
+// - storage.bin - snapshot of whole storage, loaded with mmap on startup,
+// - storage.journal - append only log of writes done after snapshot. Each
+//   record has sequence number and CRC, so record which was partially
+//   written during crash is dropped on load.
+// Each commit() appends only changed bytes to journal. When journal grows
+// above compaction threshold, it is rotated (storage.journal.old) and new
+// snapshot is written in background thread (to temporary file, which is then
+// renamed). Old journal is removed when snapshot is ready.
+// When journal write fails, journal is truncated to its last valid record and
+// not saved data is written again with next commit().
+class LinuxStorage : public Storage {
+ public:
+  explicit LinuxStorage(const std::string &path);
+  ~LinuxStorage();
+
+  bool init() override;
+  void commit() override;
+
+  void setCompactionThreshold(size_t bytes);
+  size_t getJournalSize() const;
+  uint32_t getCompactionCount() const;
+  // Waits for background compaction to finish
+  void waitForCompaction();
+
+ protected:
+  int readStorage(unsigned int offset,
+                  unsigned char *buf,
+                  int size,
+                  bool logs) override;
+  int writeStorage(unsigned int offset,
+                   const unsigned char *buf,
+                   int size) override;
+
+  bool loadSnapshot();
+  // Applies journal records with sequence number higher than current one.
+  // Returns number of valid bytes in journal file.
+  size_t replayJournal(const std::string &fileName);
+  bool openJournal();
+  // Appends data to journal file and flushes it to disk
+  virtual bool writeJournal(const unsigned char *data, size_t size);
+  void startCompaction();
+  void joinCompactionThread(bool wait);
+  static bool writeSnapshot(const std::string &fileName,
+                            const std::vector<unsigned char> &data,
+                            uint32_t sequence);
+
+  std::string snapshotFile;
+  std::string journalFile;
+  std::string oldJournalFile;
+
+  std::vector<unsigned char> image;
+  std::vector<unsigned char> pendingRecords;
+  int journalFd = -1;
+  size_t journalSize = 0;
+  size_t compactionThreshold = 64 * 1024;
+  uint32_t sequence = 0;
+
+  std::thread compactionThread;
+  std::atomic<bool> compactionDone;
+  uint32_t compactionCount = 0;
+};
+
+};  // namespace Supla
+
+#endif  // EXTRAS_PORTING_LINUX_LINUX_STORAGE_H_
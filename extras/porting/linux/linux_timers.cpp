@@ -17,32 +17,84 @@
 */
 
 #include <SuplaDevice.h>
+#include <errno.h>
+#include <string.h>
 #include <supla/log_wrapper.h>
-#include <supla/time.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
+#include <atomic>
 #include <thread>  // NOLINT(build/c++11)
 
 #include "linux_timers.h"
 
-void supla10msTimer() {
-  while (1) {
-    SuplaDevice.onTimer();
-    delay(10);
-  }
-}
+namespace {
+bool timersEnabled = true;
+std::atomic<bool> timersRunning(false);
+// not destroyed on exit, so running thread doesn't terminate process
+std::thread *timersThread = nullptr;
 
-void supla1msTimer() {
-  while (1) {
+// Single thread driven by periodic 1 ms timerfd. Contrary to delay() based
+// loops, timer period doesn't drift with callback execution time.
+void suplaTimers(int timerFd) {
+  uint64_t ticks = 0;
+  while (timersRunning) {
+    uint64_t expirations = 0;
+    if (::read(timerFd, &expirations, sizeof(expirations)) !=
+        sizeof(expirations)) {
+      continue;
+    }
+    // missed fast timer ticks are not repeated
     SuplaDevice.onFastTimer();
-    delay(1);
+    ticks += expirations;
+    if (ticks >= 10) {
+      ticks %= 10;
+      SuplaDevice.onTimer();
+    }
   }
+  close(timerFd);
+}
+}  // namespace
+
+void Supla::Linux::Timers::setEnabled(bool enabled) {
+  timersEnabled = enabled;
 }
 
 void Supla::Linux::Timers::init() {
+  if (!timersEnabled) {
+    SUPLA_LOG_DEBUG("Linux timers are disabled");
+    return;
+  }
+  if (timersThread) {
+    return;
+  }
+
   SUPLA_LOG_DEBUG("Starting linux timers...");
-  std::thread standardTimer(supla10msTimer);
-  standardTimer.detach();
+  int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  if (timerFd < 0) {
+    SUPLA_LOG_ERROR("Timers: timerfd_create failed: %s", strerror(errno));
+    return;
+  }
+
+  struct itimerspec spec = {};
+  spec.it_interval.tv_nsec = 1000000;
+  spec.it_value.tv_nsec = 1000000;
+  if (timerfd_settime(timerFd, 0, &spec, nullptr) != 0) {
+    SUPLA_LOG_ERROR("Timers: timerfd_settime failed: %s", strerror(errno));
+    close(timerFd);
+    return;
+  }
 
-  std::thread fastTimer(supla1msTimer);
-  fastTimer.detach();
+  timersRunning = true;
+  timersThread = new std::thread(suplaTimers, timerFd);
+}
+
+void Supla::Linux::Timers::deinit() {
+  if (timersThread == nullptr) {
+    return;
+  }
+  timersRunning = false;
+  timersThread->join();
+  delete timersThread;
+  timersThread = nullptr;
 }
@@ -23,6 +23,13 @@ namespace Supla {
 namespace Linux {
 namespace Timers {
 void init();
+// Stops timers thread started by init()
+void deinit();
+// Timers are enabled by default. Elements which don't use onTimer() and
+// onFastTimer() (i.e. all elements created from Linux YAML config) can work
+// with disabled timers, so process doesn't wake up every 1 ms.
+// It has to be called before SuplaDevice.begin().
+void setEnabled(bool enabled);
 };
 };      // namespace Linux
 };      // namespace Supla
@@ -0,0 +1,131 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <supla/log_wrapper.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <mutex>               // NOLINT(build/c++11)
+#include <thread>              // NOLINT(build/c++11)
+#include <vector>
+
+#include "linux_event_loop.h"
+#include "linux_worker_pool.h"
+
+namespace {
+std::vector<std::thread> workers;
+std::mutex jobsMutex;
+std::condition_variable jobsCondition;
+std::deque<Supla::Linux::WorkerPool::Job *> jobs;
+bool stopping = false;
+bool running = false;
+
+// Lock-free stack of finished jobs (multiple producers, single consumer)
+std::atomic<Supla::Linux::WorkerPool::Job *> finishedJobs(nullptr);
+
+void pushFinishedJob(Supla::Linux::WorkerPool::Job *job) {
+  job->nextFinished = finishedJobs.load(std::memory_order_relaxed);
+  while (!finishedJobs.compare_exchange_weak(job->nextFinished,
+                                             job,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+  }
+}
+
+void workerLoop() {
+  while (true) {
+    Supla::Linux::WorkerPool::Job *job = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(jobsMutex);
+      jobsCondition.wait(lock, [] { return stopping || !jobs.empty(); });
+      if (jobs.empty()) {
+        return;
+      }
+      job = jobs.front();
+      jobs.pop_front();
+    }
+    job->run();
+    pushFinishedJob(job);
+    Supla::Linux::EventLoop::wakeUp();
+  }
+}
+}  // namespace
+
+bool Supla::Linux::WorkerPool::start(int threadCount) {
+  if (running || threadCount < 1) {
+    return false;
+  }
+  stopping = false;
+  for (int i = 0; i < threadCount; i++) {
+    workers.emplace_back(workerLoop);
+  }
+  running = true;
+  SUPLA_LOG_INFO("WorkerPool: started %d threads", threadCount);
+  return true;
+}
+
+void Supla::Linux::WorkerPool::stop() {
+  if (!running) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    stopping = true;
+  }
+  jobsCondition.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+  running = false;
+}
+
+bool Supla::Linux::WorkerPool::isRunning() {
+  return running;
+}
+
+bool Supla::Linux::WorkerPool::submit(Job *job) {
+  if (!running || job == nullptr) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    jobs.push_back(job);
+  }
+  jobsCondition.notify_one();
+  return true;
+}
+
+void Supla::Linux::WorkerPool::processFinishedJobs() {
+  Job *stack = finishedJobs.exchange(nullptr, std::memory_order_acquire);
+  // reverse stack, so jobs are finished in order of completion
+  Job *ordered = nullptr;
+  while (stack) {
+    Job *next = stack->nextFinished;
+    stack->nextFinished = ordered;
+    ordered = stack;
+    stack = next;
+  }
+  while (ordered) {
+    Job *next = ordered->nextFinished;
+    ordered->nextFinished = nullptr;
+    ordered->finish();
+    ordered = next;
+  }
+}
@@ -0,0 +1,67 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#ifndef EXTRAS_PORTING_LINUX_LINUX_WORKER_POOL_H_
+#define EXTRAS_PORTING_LINUX_LINUX_WORKER_POOL_H_
+
+// Optional pool of background threads for slow work (i.e. reading sources
+// and parsing) which shouldn't block main loop. Job's run() is called on
+// worker thread. When it returns, job is passed back to main thread through
+// lock-free queue and main loop is woken up. Main thread calls
+// processFinishedJobs(), which calls finish() of each finished job, so
+// results are applied to elements on main thread only.
+//
+// Usage:
+//   Supla::Linux::WorkerPool::start(2);
+//   ...
+//   Supla::Linux::WorkerPool::stop();
+namespace Supla {
+namespace Linux {
+namespace WorkerPool {
+
+class Job {
+ public:
+  virtual ~Job() {}
+  // Called on worker thread
+  virtual void run() = 0;
+  // Called on main thread from processFinishedJobs()
+  virtual void finish() = 0;
+
+  // used internally by WorkerPool
+  Job *nextFinished = nullptr;
+};
+
+bool start(int threadCount);
+// Waits for already submitted jobs and stops worker threads. Jobs which
+// finished are not processed.
+void stop();
+bool isRunning();
+
+// Queues job for execution on worker thread. Returns false when pool isn't
+// running - then caller should do the work by itself. Job object has to be
+// valid until its finish() is called.
+bool submit(Job *job);
+
+// Calls finish() of jobs finished since last call. Should be called from
+// main thread.
+void processFinishedJobs();
+};  // namespace WorkerPool
+};  // namespace Linux
+};  // namespace Supla
+
+#endif  // EXTRAS_PORTING_LINUX_LINUX_WORKER_POOL_H_
@@ -19,7 +19,9 @@
 #include <supla/network/ip_address.h>
 #include <supla/log_wrapper.h>
 #include <supla-common/proto.h>
+#include <supla/channel.h>
 #include <supla/control/virtual_relay.h>
+#include <supla/element.h>
 #include <supla/parser/json.h>
 #include <supla/parser/parser.h>
 #include <supla/parser/simple.h>
@@ -183,6 +185,14 @@ bool Supla::LinuxYamlConfig::getInt32(const char* key, int32_t* result) {
   return false;
 }
 bool Supla::LinuxYamlConfig::getUInt32(const char* key, uint32_t* result) {
+  try {
+    if (config[key]) {
+      *result = config[key].as<uint32_t>();
+      return true;
+    }
+  } catch (const YAML::Exception& ex) {
+    SUPLA_LOG_ERROR("Config file YAML error: %s", ex.what());
+  }
   return false;
 }
 
@@ -272,6 +282,28 @@ int32_t Supla::LinuxYamlConfig::getSuplaServerPort() {
   return 2016;
 }
 
+bool Supla::LinuxYamlConfig::isTlsSessionPersistenceEnabled() {
+  try {
+    if (config["supla"] && config["supla"]["persist_tls_session"]) {
+      return config["supla"]["persist_tls_session"].as<bool>();
+    }
+  } catch (const YAML::Exception& ex) {
+    SUPLA_LOG_ERROR("Config file YAML error: %s", ex.what());
+  }
+  return false;
+}
+
+int Supla::LinuxYamlConfig::getWorkerThreads() {
+  try {
+    if (config["worker_threads"]) {
+      return config["worker_threads"].as<int>();
+    }
+  } catch (const YAML::Exception& ex) {
+    SUPLA_LOG_ERROR("Config file YAML error: %s", ex.what());
+  }
+  return 0;
+}
+
 bool Supla::LinuxYamlConfig::getEmail(char* result) {
   try {
     if (config["supla"] && config["supla"]["mail"]) {
@@ -325,6 +357,11 @@ bool Supla::LinuxYamlConfig::loadChannels() {
           SUPLA_LOG_ERROR("Config: parsing channel %d failed", channelCount);
           return false;
         }
+        if (it["uplink_filter"] &&
+            !parseUplinkFilter(it["uplink_filter"], channelCount)) {
+          SUPLA_LOG_ERROR("Config: parsing channel %d failed", channelCount);
+          return false;
+        }
         channelCount++;
       }
       if (channelCount == 0) {
@@ -431,6 +468,52 @@ bool Supla::LinuxYamlConfig::parseChannel(const YAML::Node& ch,
   return false;
 }
 
+bool Supla::LinuxYamlConfig::parseUplinkFilter(const YAML::Node& filter,
+                                               int channelNumber) {
+  auto element = Supla::Element::getOwnerOfChannel(channelNumber);
+  Supla::Channel* channel = element ? element->getChannel() : nullptr;
+  if (channel == nullptr) {
+    SUPLA_LOG_ERROR("Channel[%d] config: uplink_filter not supported",
+                    channelNumber);
+    return false;
+  }
+
+  if (filter["deadband"] && filter["deadband_percent"]) {
+    SUPLA_LOG_ERROR(
+        "Channel[%d] config: \"deadband\" and \"deadband_percent\" can't be "
+        "used together",
+        channelNumber);
+    return false;
+  }
+  if (filter["deadband"]) {
+    double deadband = filter["deadband"].as<double>();
+    channel->setUplinkDeadband(deadband);
+    SUPLA_LOG_INFO(
+        "Channel[%d] config: uplink deadband %f", channelNumber, deadband);
+  }
+  if (filter["deadband_percent"]) {
+    double deadband = filter["deadband_percent"].as<double>();
+    channel->setUplinkDeadband(deadband, true);
+    SUPLA_LOG_INFO(
+        "Channel[%d] config: uplink deadband %f %%", channelNumber, deadband);
+  }
+  if (filter["min_interval_ms"]) {
+    uint32_t interval = filter["min_interval_ms"].as<uint32_t>();
+    channel->setUplinkMinIntervalMs(interval);
+    SUPLA_LOG_INFO(
+        "Channel[%d] config: uplink min interval %d ms",
+        channelNumber,
+        interval);
+  }
+  if (filter["heartbeat_sec"]) {
+    uint32_t interval = filter["heartbeat_sec"].as<uint32_t>();
+    channel->setUplinkHeartbeatMs(interval * 1000);
+    SUPLA_LOG_INFO(
+        "Channel[%d] config: uplink heartbeat %d s", channelNumber, interval);
+  }
+  return true;
+}
+
 bool Supla::LinuxYamlConfig::addVirtualRelay(const YAML::Node& ch,
                                              int channelNumber) {
   SUPLA_LOG_INFO("Channel[%d] config: adding VirtualRelay", channelNumber);
@@ -476,13 +559,10 @@ bool Supla::LinuxYamlConfig::addThermometerParsed(
   auto therm = new Supla::Sensor::ThermometerParsed(parser);
   if (ch[Supla::Parser::Temperature]) {
     paramCount++;
-    if (parser->isBasedOnIndex()) {
-      int index = ch[Supla::Parser::Temperature].as<int>();
-      therm->setMapping(Supla::Parser::Temperature, index);
-    } else {
-      std::string key = ch[Supla::Parser::Temperature].as<std::string>();
-      therm->setMapping(Supla::Parser::Temperature, key);
-    }
+    setParsedMapping(therm,
+                     Supla::Parser::Temperature,
+                     ch[Supla::Parser::Temperature],
+                     parser);
   } else {
     SUPLA_LOG_ERROR(
               "Channel[%d] config: missing \"%s\" parameter",
@@ -495,6 +575,7 @@ bool Supla::LinuxYamlConfig::addThermometerParsed(
     double multiplier = ch[Supla::Multiplier].as<double>();
     therm->setMultiplier(Supla::Parser::Temperature, multiplier);
   }
+  therm->resolveParameters();
 
   return true;
 }
@@ -507,13 +588,8 @@ bool Supla::LinuxYamlConfig::addImpulseCounterParsed(
   auto ic = new Supla::Sensor::ImpulseCounterParsed(parser);
   if (ch[Supla::Parser::Counter]) {
     paramCount++;
-    if (parser->isBasedOnIndex()) {
-      int index = ch[Supla::Parser::Counter].as<int>();
-      ic->setMapping(Supla::Parser::Counter, index);
-    } else {
-      std::string key = ch[Supla::Parser::Counter].as<std::string>();
-      ic->setMapping(Supla::Parser::Counter, key);
-    }
+    setParsedMapping(
+        ic, Supla::Parser::Counter, ch[Supla::Parser::Counter], parser);
   } else {
     SUPLA_LOG_ERROR(
               "Channel[%d] config: missing \"%s\" parameter",
@@ -526,6 +602,7 @@ bool Supla::LinuxYamlConfig::addImpulseCounterParsed(
     double multiplier = ch[Supla::Multiplier].as<double>();
     ic->setMultiplier(Supla::Parser::Counter, multiplier);
   }
+  ic->resolveParameters();
 
   return true;
 }
@@ -540,13 +617,8 @@ bool Supla::LinuxYamlConfig::addElectricityMeterParsed(
   // set not phase releated parameters (currently only frequency)
   if (ch[Supla::Parser::Frequency]) {
     paramCount++;
-    if (parser->isBasedOnIndex()) {
-      int index = ch[Supla::Parser::Frequency].as<int>();
-      em->setMapping(Supla::Parser::Frequency, index);
-    } else {
-      std::string key = ch[Supla::Parser::Frequency].as<std::string>();
-      em->setMapping(Supla::Parser::Frequency, key);
-    }
+    setParsedMapping(
+        em, Supla::Parser::Frequency, ch[Supla::Parser::Frequency], parser);
     if (ch[Supla::Multiplier]) {
       double multiplier = ch[Supla::Multiplier].as<double>();
       em->setMultiplier(Supla::Parser::Frequency, multiplier);
@@ -578,13 +650,7 @@ bool Supla::LinuxYamlConfig::addElectricityMeterParsed(
                                         "power_factor"}) {
           if (param[name]) {
             paramName = name + "_" + std::to_string(phaseId);
-            if (parser->isBasedOnIndex()) {
-              int index = param[name].as<int>();
-              em->setMapping(paramName, index);
-            } else {
-              std::string key = param[name].as<std::string>();
-              em->setMapping(paramName, key);
-            }
+            setParsedMapping(em, paramName, param[name], parser);
             if (param[Supla::Multiplier]) {
               double multiplier = param[Supla::Multiplier].as<double>();
               em->setMultiplier(paramName, multiplier);
@@ -594,6 +660,7 @@ bool Supla::LinuxYamlConfig::addElectricityMeterParsed(
       }
     }
   }
+  em->resolveParameters();
 
   return true;
 }
@@ -605,13 +672,8 @@ bool Supla::LinuxYamlConfig::addBinaryParsed(const YAML::Node& ch,
   auto binary = new Supla::Sensor::BinaryParsed(parser);
   if (ch[Supla::Parser::State]) {
     paramCount++;
-    if (parser->isBasedOnIndex()) {
-      int index = ch[Supla::Parser::State].as<int>();
-      binary->setMapping(Supla::Parser::State, index);
-    } else {
-      std::string key = ch[Supla::Parser::State].as<std::string>();
-      binary->setMapping(Supla::Parser::State, key);
-    }
+    setParsedMapping(
+        binary, Supla::Parser::State, ch[Supla::Parser::State], parser);
   } else {
     SUPLA_LOG_ERROR(
               "Channel[%d] config: missing \"%s\" parameter",
@@ -619,10 +681,25 @@ bool Supla::LinuxYamlConfig::addBinaryParsed(const YAML::Node& ch,
               Supla::Parser::State);
     return false;
   }
+  binary->resolveParameters();
 
   return true;
 }
 
+void Supla::LinuxYamlConfig::setParsedMapping(
+    Supla::Sensor::SensorParsed* sensor,
+    const std::string& parameter,
+    const YAML::Node& value,
+    Supla::Parser::Parser* parser) {
+  if (!parser->isBasedOnIndex()) {
+    sensor->setMapping(parameter, value.as<std::string>());
+  } else if (value.IsSequence() && value.size() == 2) {
+    sensor->setMapping(parameter, value[0].as<int>(), value[1].as<int>());
+  } else {
+    sensor->setMapping(parameter, value.as<int>());
+  }
+}
+
 Supla::Parser::Parser* Supla::LinuxYamlConfig::addParser(
     const YAML::Node& parser, Supla::Source::Source* src) {
   Supla::Parser::Parser* prs = nullptr;
@@ -658,9 +735,23 @@ Supla::Parser::Parser* Supla::LinuxYamlConfig::addParser(
   if (parser["type"]) {
     std::string type = parser["type"].as<std::string>();
     if (type == "Simple") {
-      prs = new Supla::Parser::Simple(src);
+      auto simple = new Supla::Parser::Simple(src);
+      if (parser["separator"]) {
+        std::string separator = parser["separator"].as<std::string>();
+        if (separator.length() != 1) {
+          SUPLA_LOG_ERROR("Config: parser separator should be one character");
+          delete simple;
+          return nullptr;
+        }
+        simple->setSeparator(separator[0]);
+      }
+      prs = simple;
     } else if (type == "Json") {
-      prs = new Supla::Parser::Json(src);
+      auto json = new Supla::Parser::Json(src);
+      if (parser["streaming"]) {
+        json->setStreamingMode(parser["streaming"].as<bool>());
+      }
+      prs = json;
     } else {
       SUPLA_LOG_ERROR("Config: unknown parser type \"%s\"", type.c_str());
       return nullptr;
@@ -714,10 +805,28 @@ Supla::Source::Source* Supla::LinuxYamlConfig::addSource(
       if (source["expiration_time_sec"]) {
         expirationTimeSec = source["expiration_time_sec"].as<int>();
       }
-      src = new Supla::Source::File(fileName.c_str(), expirationTimeSec);
+      auto fileSrc =
+          new Supla::Source::File(fileName.c_str(), expirationTimeSec);
+      if (source["cache"]) {
+        fileSrc->setCacheMode(source["cache"].as<bool>());
+      } else if (source["mmap"]) {
+        // previous name of "cache" parameter
+        fileSrc->setCacheMode(source["mmap"].as<bool>());
+      }
+      if (source["inotify"]) {
+        fileSrc->setInotify(source["inotify"].as<bool>());
+      }
+      src = fileSrc;
     } else if (type == "Cmd") {
       std::string cmd = source["command"].as<std::string>();
-      src = new Supla::Source::Cmd(cmd.c_str());
+      auto cmdSrc = new Supla::Source::Cmd(cmd.c_str());
+      if (source["async"]) {
+        cmdSrc->setAsync(source["async"].as<bool>());
+      }
+      if (source["timeout_sec"]) {
+        cmdSrc->setTimeoutMs(source["timeout_sec"].as<int>() * 1000);
+      }
+      src = cmdSrc;
     } else {
       SUPLA_LOG_ERROR("Config: unknown source type \"%s\"", type.c_str());
       return nullptr;
@@ -34,6 +34,11 @@
 name: Device name
 # log_level - optional, values: info (default), debug, verbose
 log_level: debug
+# uplink_batch_window_ms - optional, enables batching of channel updates sent
+# to server (see SuplaSrpc::setUplinkBatching)
+uplink_batch_window_ms: 20
+# uplink_batch_channels - optional, max channels in one batch (default 10)
+uplink_batch_channels: 10
 
 supla:
   server: svrXYZ.supla.org
@@ -129,9 +134,12 @@ class LinuxYamlConfig : public Config {
   bool getEmail(char* result) override;
 
   std::string getStateFilesPath();
+  bool isTlsSessionPersistenceEnabled();
+  int getWorkerThreads();
 
  protected:
   bool parseChannel(const YAML::Node& ch, int channelNumber);
+  bool parseUplinkFilter(const YAML::Node& filter, int channelNumber);
   Supla::Parser::Parser* addParser(const YAML::Node& parser,
                                    Supla::Source::Source* src);
   Supla::Source::Source* addSource(const YAML::Node& ch);
@@ -150,6 +158,11 @@ class LinuxYamlConfig : public Config {
   bool addBinaryParsed(const YAML::Node& ch,
                        int channelNumber,
                        Supla::Parser::Parser* parser);
+  // Maps parameter to parser key, line index or [line, column] pair
+  void setParsedMapping(Supla::Sensor::SensorParsed* sensor,
+                        const std::string& parameter,
+                        const YAML::Node& value,
+                        Supla::Parser::Parser* parser);
   void loadGuidAuthFromPath(const std::string& path);
   bool saveGuidAuth(const std::string& path);
 
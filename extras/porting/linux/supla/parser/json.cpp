@@ -20,6 +20,174 @@
 
 #include "json.h"
 
+namespace {
+
+// SAX handler for nlohmann::json::sax_parse. It tracks JSON pointer of
+// current value only inside containers which lead to wanted values.
+class KeyExtractor {
+ public:
+  using json = nlohmann::json;
+
+  KeyExtractor(const std::unordered_set<std::string> &wantedPointers,
+               const std::unordered_set<std::string> &wantedParents,
+               std::unordered_map<std::string, double> *values)
+      : wantedPointers(wantedPointers),
+        wantedParents(wantedParents),
+        values(values) {
+  }
+
+  bool null() {
+    return scalar(false, 0);
+  }
+
+  bool boolean(bool value) {
+    return scalar(true, value ? 1 : 0);
+  }
+
+  bool number_integer(json::number_integer_t value) {
+    return scalar(true, static_cast<double>(value));
+  }
+
+  bool number_unsigned(json::number_unsigned_t value) {
+    return scalar(true, static_cast<double>(value));
+  }
+
+  bool number_float(json::number_float_t value, const json::string_t &) {
+    return scalar(true, value);
+  }
+
+  bool string(json::string_t &) {
+    return scalar(false, 0);
+  }
+
+  bool binary(json::binary_t &) {
+    return scalar(false, 0);
+  }
+
+  bool start_object(std::size_t) {
+    return startContainer(false);
+  }
+
+  bool key(json::string_t &key) {
+    if (skipDepth == 0) {
+      path.resize(frames.back().pathLength);
+      path += '/';
+      appendEscaped(key);
+    }
+    return true;
+  }
+
+  bool end_object() {
+    return endContainer();
+  }
+
+  bool start_array(std::size_t) {
+    return startContainer(true);
+  }
+
+  bool end_array() {
+    return endContainer();
+  }
+
+  bool parse_error(std::size_t position,
+                   const std::string &,
+                   const nlohmann::detail::exception &) {
+    errorPosition = position;
+    return false;
+  }
+
+  bool isCompleted() const {
+    return completed;
+  }
+
+  std::size_t getErrorPosition() const {
+    return errorPosition;
+  }
+
+ protected:
+  struct Frame {
+    bool isArray;
+    std::size_t index;
+    std::size_t pathLength;
+  };
+
+  // Sets path to JSON pointer of value which is being started
+  void enterValue() {
+    if (frames.empty()) {
+      path.clear();
+      return;
+    }
+    Frame &frame = frames.back();
+    if (frame.isArray) {
+      path.resize(frame.pathLength);
+      path += '/';
+      path += std::to_string(frame.index++);
+    }
+  }
+
+  void appendEscaped(const std::string &key) {
+    for (char c : key) {
+      if (c == '~') {
+        path += "~0";
+      } else if (c == '/') {
+        path += "~1";
+      } else {
+        path += c;
+      }
+    }
+  }
+
+  bool scalar(bool isNumber, double value) {
+    if (skipDepth > 0) {
+      return true;
+    }
+    enterValue();
+    if (isNumber && wantedPointers.count(path) &&
+        values->emplace(path, value).second &&
+        values->size() == wantedPointers.size()) {
+      // all values found, stop parsing
+      completed = true;
+      return false;
+    }
+    return true;
+  }
+
+  bool startContainer(bool isArray) {
+    if (skipDepth > 0) {
+      skipDepth++;
+      return true;
+    }
+    enterValue();
+    if (wantedParents.count(path) == 0) {
+      skipDepth = 1;
+      return true;
+    }
+    frames.push_back({isArray, 0, path.size()});
+    return true;
+  }
+
+  bool endContainer() {
+    if (skipDepth > 0) {
+      skipDepth--;
+    } else if (!frames.empty()) {
+      frames.pop_back();
+    }
+    return true;
+  }
+
+  const std::unordered_set<std::string> &wantedPointers;
+  const std::unordered_set<std::string> &wantedParents;
+  std::unordered_map<std::string, double> *values = nullptr;
+
+  std::vector<Frame> frames;
+  std::string path;
+  int skipDepth = 0;
+  bool completed = false;
+  std::size_t errorPosition = 0;
+};
+
+}  // namespace
+
 Supla::Parser::Json::Json(Supla::Source::Source* src)
     : Supla::Parser::Parser(src) {
 }
@@ -27,42 +195,150 @@ Supla::Parser::Json::Json(Supla::Source::Source* src)
 Supla::Parser::Json::~Json() {
 }
 
+std::string Supla::Parser::Json::keyToPointer(const std::string& key) {
+  if (!key.empty() && key[0] == '/') {
+    return key;
+  }
+  // plain key name refers to top level object member
+  std::string pointer = "/";
+  for (char c : key) {
+    if (c == '~') {
+      pointer += "~0";
+    } else if (c == '/') {
+      pointer += "~1";
+    } else {
+      pointer += c;
+    }
+  }
+  return pointer;
+}
+
+void Supla::Parser::Json::addKey(const std::string& key, int index) {
+  Supla::Parser::Parser::addKey(key, index);
+
+  std::string pointer = keyToPointer(key);
+  wantedPointers.insert(pointer);
+  for (std::size_t pos = pointer.find('/'); pos != std::string::npos;
+       pos = pointer.find('/', pos + 1)) {
+    wantedParents.insert(pointer.substr(0, pos));
+  }
+}
+
+void Supla::Parser::Json::setStreamingMode(bool enabled) {
+  streamingMode = enabled;
+  json.clear();
+  values.clear();
+}
+
 bool Supla::Parser::Json::refreshSource() {
   valid = false;
   if (source) {
-    std::string sourceContent = source->getContent();
+    std::string_view sourceContent = source->getCachedContentView();
 
     if (sourceContent.length() == 0) {
       return valid;
     }
 
-    SUPLA_LOG_VERBOSE("Source: %s", sourceContent.c_str());
-    try {
-      json = nlohmann::json::parse(sourceContent);
-    } catch (nlohmann::json::parse_error& ex) {
-      SUPLA_LOG_ERROR("JSON parsing error at byte %d", ex.byte);
-      return valid;
+    SUPLA_LOG_VERBOSE("Source: %.*s",
+                      static_cast<int>(sourceContent.length()),
+                      sourceContent.data());
+    if (streamingMode) {
+      valid = parseStreaming(sourceContent);
+    } else {
+      valid = parseDom(sourceContent);
     }
-
-    valid = true;
   }
   return valid;
 }
 
+bool Supla::Parser::Json::parseDom(std::string_view content) {
+  try {
+    json = nlohmann::json::parse(content.begin(), content.end());
+  } catch (nlohmann::json::parse_error& ex) {
+    SUPLA_LOG_ERROR("JSON parsing error at byte %d", ex.byte);
+    return false;
+  }
+  return true;
+}
+
+bool Supla::Parser::Json::parseStreaming(std::string_view content) {
+  values.clear();
+  if (wantedPointers.empty()) {
+    return true;
+  }
+
+  KeyExtractor extractor(wantedPointers, wantedParents, &values);
+  if (nlohmann::json::sax_parse(
+          content.begin(), content.end(), &extractor) ||
+      extractor.isCompleted()) {
+    return true;
+  }
+
+  SUPLA_LOG_ERROR("JSON parsing error at byte %d",
+                  extractor.getErrorPosition());
+  values.clear();
+  return false;
+}
+
 bool Supla::Parser::Json::isValid() {
   return valid;
 }
 
 double Supla::Parser::Json::getValue(const std::string& key) {
+  if (streamingMode) {
+    auto value = values.find(keyToPointer(key));
+    if (value != values.end()) {
+      return value->second;
+    }
+    SUPLA_LOG_ERROR("JSON key \"%s\" not found", key.c_str());
+    valid = false;
+    return 0;
+  }
+
   try {
-    return json[key].get<double>();
-  } catch (nlohmann::json::type_error& ex) {
+    auto &value = json.at(nlohmann::json::json_pointer(keyToPointer(key)));
+    if (value.is_boolean()) {
+      return value.get<bool>() ? 1 : 0;
+    }
+    return value.get<double>();
+  } catch (nlohmann::json::exception& ex) {
     SUPLA_LOG_ERROR("JSON key \"%s\" not found", key.c_str());
     valid = false;
   }
   return 0;
 }
 
+void Supla::Parser::Json::fillSlots(Snapshot *snapshot) {
+  while (slotPointers.size() < slotKeys.size()) {
+    slotPointers.emplace_back(keyToPointer(slotKeys[slotPointers.size()]));
+  }
+
+  for (size_t i = 0; i < slotKeys.size(); i++) {
+    if (streamingMode) {
+      auto value = values.find(slotPointers[i]);
+      if (value != values.end()) {
+        snapshot->found[i] = 1;
+        snapshot->values[i] = value->second;
+      }
+    } else {
+      nlohmann::json::json_pointer pointer(slotPointers[i]);
+      if (json.contains(pointer)) {
+        auto &value = json.at(pointer);
+        if (value.is_number()) {
+          snapshot->found[i] = 1;
+          snapshot->values[i] = value.get<double>();
+        } else if (value.is_boolean()) {
+          snapshot->found[i] = 1;
+          snapshot->values[i] = value.get<bool>() ? 1 : 0;
+        }
+      }
+    }
+    if (!snapshot->found[i]) {
+      SUPLA_LOG_ERROR("JSON key \"%s\" not found", slotKeys[i].c_str());
+    }
+  }
+}
+
 bool Supla::Parser::Json::isBasedOnIndex() {
   return false;
 }
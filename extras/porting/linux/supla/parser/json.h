@@ -23,6 +23,9 @@
 
 #include <map>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <nlohmann/json.hpp>
 
@@ -30,6 +33,16 @@
 
 namespace Supla {
 namespace Parser {
+// Key may be a top level key name (i.e. "voltage"), or JSON pointer to
+// nested value (i.e. "/inverter/phases/0/voltage").
+//
+// In DOM mode (default) whole document is parsed and kept, so also keys which
+// weren't registered can be read. In streaming mode source is parsed with
+// SAX parser and only values of keys registered with addKey() are extracted.
+// Subtrees which don't lead to any registered key are skipped and parsing
+// stops as soon as all keys are found. Because of that, in streaming mode
+// first value of duplicated key is used (last one in DOM mode) and errors
+// after last registered key are not detected.
 class Json : public Parser {
  public:
   explicit Json(Supla::Source::Source *);
@@ -37,16 +50,32 @@ class Json : public Parser {
 
   bool refreshSource() override;
 
+  void addKey(const std::string &key, int index) override;
   double getValue(const std::string &key) override;
 
   bool isBasedOnIndex() override;
   bool isValid() override;
 
+  void setStreamingMode(bool enabled);
+
+  // Converts key to JSON pointer
+  static std::string keyToPointer(const std::string &key);
+
  protected:
-  bool valid = false;
-  std::map<std::string, int> keys;
+  bool parseDom(std::string_view content);
+  bool parseStreaming(std::string_view content);
+  void fillSlots(Snapshot *snapshot) override;
 
+  bool streamingMode = false;
   nlohmann::json json;
+
+  // JSON pointers of registered keys and of all their parent containers
+  std::unordered_set<std::string> wantedPointers;
+  std::unordered_set<std::string> wantedParents;
+  // values extracted in streaming mode, by JSON pointer
+  std::unordered_map<std::string, double> values;
+  // JSON pointers of slot keys
+  std::vector<std::string> slotPointers;
 };
 };      // namespace Parser
 };      // namespace Supla
@@ -17,28 +17,172 @@
 #include "parser.h"
 #include <supla/time.h>
 #include <supla-common/log.h>
+#include <linux_event_loop.h>
 
-Supla::Parser::Parser::Parser(Supla::Source::Source *src) : source(src) {}
+#include <algorithm>
+#include <mutex>  // NOLINT(build/c++11)
+
+Supla::Parser::Parser::Parser(Supla::Source::Source *src)
+    : source(src), snapshot(std::make_shared<Snapshot>()), refreshJob(this) {
+}
 
 void Supla::Parser::Parser::addKey(const std::string& key, int index) {
   keys[key] = index;
 }
 
+void Supla::Parser::Parser::addCellKey(const std::string &key,
+                                       int index,
+                                       int column) {
+  (void)(column);
+  addKey(key, index);
+}
+
 bool Supla::Parser::Parser::isValid() {
   return valid;
 }
 
 bool Supla::Parser::Parser::refreshParserSource() {
-  if (!lastRefreshTime || millis() - lastRefreshTime > refreshTimeMs) {
+  if (publishing) {
+    // called by snapshot listener - it should use published snapshot
+    return snapshot->valid;
+  }
+
+  // publish results of refreshes done by worker threads (of all parsers)
+  Supla::Linux::WorkerPool::processFinishedJobs();
+  if (refreshJobPending) {
+    return snapshot->valid;
+  }
+
+  uint64_t elapsed = millis() - lastRefreshTime;
+  bool changeNotified = false;
+  if (source) {
+    // source may be read by worker thread of other parser at the moment
+    std::unique_lock<std::mutex> lock(source->getMutex(), std::try_to_lock);
+    if (lock.owns_lock()) {
+      uint32_t notifications = source->getChangeNotificationCount();
+      changeNotified = notifications != changeNotificationCount;
+      changeNotificationCount = notifications;
+    }
+  }
+  if (!lastRefreshTime || elapsed > refreshTimeMs || changeNotified) {
     lastRefreshTime = millis();
-    return refreshSource();
+    // make sure main loop doesn't sleep through next refresh
+    Supla::Linux::EventLoop::wakeUpIn(refreshTimeMs + 1);
+    if (snapshot->version > 0 &&
+        Supla::Linux::WorkerPool::submit(&refreshJob)) {
+      refreshJobPending = true;
+      return snapshot->valid;
+    }
+    auto next = parseSource();
+    if (next) {
+      publishSnapshot(next);
+    }
+    return snapshot->valid;
   }
+  Supla::Linux::EventLoop::wakeUpIn(refreshTimeMs + 1 - elapsed);
   return true;
 }
 
+std::shared_ptr<Supla::Parser::Snapshot> Supla::Parser::Parser::parseSource() {
+  std::unique_lock<std::mutex> lock;
+  if (source) {
+    lock = std::unique_lock<std::mutex>(source->getMutex());
+    // source shared with other parsers is read once per refresh period
+    uint32_t version = source->refreshCache(refreshTimeMs);
+    if (version == parsedContentVersion) {
+      // content didn't change, so previously parsed data is used
+      valid = parsedContentValid;
+      return nullptr;
+    }
+    parsedContentVersion = version;
+  }
+  parsedContentValid = refreshSource();
+
+  auto next = std::make_shared<Snapshot>();
+  next->valid = parsedContentValid;
+  next->values.resize(slotKeys.size(), 0);
+  next->found.resize(slotKeys.size(), 0);
+  if (parsedContentValid) {
+    fillSlots(next.get());
+  }
+  return next;
+}
+
 void Supla::Parser::Parser::setRefreshTime(unsigned int timeMs) {
   if (timeMs < 10) {
     timeMs = 10;
   }
   refreshTimeMs = timeMs;
 }
+
+int Supla::Parser::Parser::getSlot(const std::string &key) {
+  for (int i = 0; i < static_cast<int>(slotKeys.size()); i++) {
+    if (slotKeys[i] == key) {
+      return i;
+    }
+  }
+
+  int index = -1;
+  auto it = keys.find(key);
+  if (it != keys.end()) {
+    index = it->second;
+  }
+  slotKeys.push_back(key);
+  slotIndexes.push_back(index);
+  // values of already parsed content are not copied to new slot
+  parsedContentVersion = 0;
+  lastRefreshTime = 0;
+  return slotKeys.size() - 1;
+}
+
+std::shared_ptr<const Supla::Parser::Snapshot>
+Supla::Parser::Parser::getSnapshot() const {
+  return snapshot;
+}
+
+void Supla::Parser::Parser::addSnapshotListener(SnapshotListener *listener) {
+  listeners.push_back(listener);
+}
+
+void Supla::Parser::Parser::removeSnapshotListener(
+    SnapshotListener *listener) {
+  listeners.erase(std::remove(listeners.begin(), listeners.end(), listener),
+                  listeners.end());
+}
+
+void Supla::Parser::Parser::publishSnapshot(std::shared_ptr<Snapshot> next) {
+  next->version = snapshot->version + 1;
+  snapshot = next;
+
+  publishing = true;
+  for (auto listener : listeners) {
+    listener->onSnapshotPublished();
+  }
+  publishing = false;
+}
+
+void Supla::Parser::Parser::fillSlots(Snapshot *snapshot) {
+  bool parserValid = valid;
+  for (size_t i = 0; i < slotKeys.size(); i++) {
+    valid = true;
+    snapshot->values[i] = getValue(slotKeys[i]);
+    snapshot->found[i] = valid;
+  }
+  valid = parserValid;
+}
+
+Supla::Parser::Parser::RefreshJob::RefreshJob(Parser *parser)
+    : parser(parser) {
+}
+
+void Supla::Parser::Parser::RefreshJob::run() {
+  result = parser->parseSource();
+}
+
+void Supla::Parser::Parser::RefreshJob::finish() {
+  parser->refreshJobPending = false;
+  if (result) {
+    parser->publishSnapshot(result);
+    result.reset();
+  }
+}
@@ -17,14 +17,40 @@
 #ifndef EXTRAS_PORTING_LINUX_SUPLA_PARSER_PARSER_H_
 #define EXTRAS_PORTING_LINUX_SUPLA_PARSER_PARSER_H_
 
+#include <linux_worker_pool.h>
 #include <supla/source/source.h>
 
+#include <stdint.h>
+
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace Supla {
 namespace Parser {
 
+// Values of all slots from single parsing of source. Snapshot isn't modified
+// after it is published, so all channels which read it get consistent data.
+struct Snapshot {
+  // incremented with each published snapshot
+  uint32_t version = 0;
+  bool valid = false;
+  std::vector<double> values;
+  std::vector<uint8_t> found;
+};
+
+class SnapshotListener {
+ public:
+  virtual ~SnapshotListener() {}
+  // Called after parser publishes new snapshot
+  virtual void onSnapshotPublished() = 0;
+};
+
+// When Supla::Linux::WorkerPool is running, source is read and parsed on
+// worker thread and snapshot is published later on main thread (first refresh
+// is always done synchronously, so values are available after start). In this
+// mode values should be read only from snapshots.
 class Parser {
  public:
   explicit Parser(Supla::Source::Source *);
@@ -32,19 +58,65 @@ class Parser {
   bool refreshParserSource();
 
   virtual void addKey(const std::string &key, int index);
+  // Registers key for value from given column of line with given index (for
+  // parsers based on index). Default implementation ignores column.
+  virtual void addCellKey(const std::string &key, int index, int column);
   virtual double getValue(const std::string &key) = 0;
 
   virtual bool isValid();
   virtual bool isBasedOnIndex() = 0;
   void setRefreshTime(unsigned int timeMs);
 
+  // Resolves key registered with addKey() to slot. Values of all slots are
+  // copied to new snapshot after each parsing of source, so they can be read
+  // by slot without any key lookup. Same key gets same slot.
+  int getSlot(const std::string &key);
+  // Returns last published snapshot (never null)
+  std::shared_ptr<const Snapshot> getSnapshot() const;
+
+  // Listeners are notified about each published snapshot, so all channels
+  // which use this parser are updated from it in the same iteration.
+  void addSnapshotListener(SnapshotListener *listener);
+  void removeSnapshotListener(SnapshotListener *listener);
+
  protected:
   virtual bool refreshSource() = 0;
+  // Copies values of all slots from parsed content. Default implementation
+  // uses getValue().
+  virtual void fillSlots(Snapshot *snapshot);
+  // Reads source and parses it. Returns new snapshot, or nullptr when content
+  // didn't change. Called on worker thread in async mode.
+  std::shared_ptr<Snapshot> parseSource();
+  void publishSnapshot(std::shared_ptr<Snapshot> next);
+
+  class RefreshJob : public Supla::Linux::WorkerPool::Job {
+   public:
+    explicit RefreshJob(Parser *parser);
+    void run() override;
+    void finish() override;
+
+   protected:
+    Parser *parser = nullptr;
+    std::shared_ptr<Snapshot> result;
+  };
+
   std::map<std::string, int> keys;
   bool valid = false;
   Supla::Source::Source *source = nullptr;
   uint64_t lastRefreshTime = 0;
   unsigned int refreshTimeMs = 5 * 1000;  // 5 s
+  uint32_t parsedContentVersion = 0;
+  bool parsedContentValid = false;
+  uint32_t changeNotificationCount = 0;
+
+  std::vector<std::string> slotKeys;
+  // index of slot's key given in addKey()
+  std::vector<int> slotIndexes;
+  std::shared_ptr<const Snapshot> snapshot;
+  std::vector<SnapshotListener *> listeners;
+  bool publishing = false;
+  RefreshJob refreshJob;
+  bool refreshJobPending = false;
 };
 };  // namespace Parser
 };  // namespace Supla
@@ -15,7 +15,17 @@
 */
 
 #include "simple.h"
-#include <sstream>
+
+#include <string.h>
+
+#include <algorithm>
+#include <charconv>
+
+namespace {
+bool isBlank(char c) {
+  return c == ' ' || c == '\t';
+}
+}  // namespace
 
 Supla::Parser::Simple::Simple(Supla::Source::Source *src)
   : Supla::Parser::Parser(src) {
@@ -23,33 +33,145 @@ Supla::Parser::Simple::Simple(Supla::Source::Source *src)
 
 Supla::Parser::Simple::~Simple() {}
 
+void Supla::Parser::Simple::addKey(const std::string &key, int index) {
+  addCellKey(key, index, 0);
+}
+
+void Supla::Parser::Simple::addCellKey(const std::string &key,
+                                       int index,
+                                       int column) {
+  Supla::Parser::Parser::addKey(key, index);
+  keyCells[key] = getCell(index, column);
+}
+
+int Supla::Parser::Simple::getCell(int line, int column) {
+  for (int i = 0; i < static_cast<int>(cells.size()); i++) {
+    if (cells[i].line == line && cells[i].column == column) {
+      return i;
+    }
+  }
+  Cell cell;
+  cell.line = line;
+  cell.column = column;
+  cells.push_back(cell);
+  values.push_back(0);
+  found.push_back(0);
+  cellOrder.push_back(cells.size() - 1);
+  std::sort(cellOrder.begin(), cellOrder.end(), [this](int a, int b) {
+    return cells[a].line < cells[b].line ||
+           (cells[a].line == cells[b].line &&
+            cells[a].column < cells[b].column);
+  });
+  return cells.size() - 1;
+}
+
+void Supla::Parser::Simple::setSeparator(char separator) {
+  this->separator = separator;
+}
+
 double Supla::Parser::Simple::getValue(const std::string &key) {
-  int index = keys[key];
-  if (index < 0 || index >= values.size()) {
+  auto cell = keyCells.find(key);
+  if (cell == keyCells.end() || !found[cell->second]) {
     valid = false;
     return 0;
   }
 
-  return values[index];
+  return values[cell->second];
+}
+
+double Supla::Parser::Simple::parseNumber(std::string_view text) {
+  size_t pos = 0;
+  while (pos < text.size() && isBlank(text[pos])) {
+    pos++;
+  }
+  // from_chars doesn't accept leading plus sign
+  if (pos < text.size() && text[pos] == '+') {
+    pos++;
+  }
+  double result = 0;
+  auto parsed =
+      std::from_chars(text.data() + pos, text.data() + text.size(), result);
+  if (parsed.ec != std::errc()) {
+    return 0;
+  }
+  return result;
 }
 
+bool Supla::Parser::Simple::nextColumn(std::string_view line,
+                                       size_t *pos) const {
+  if (separator == ' ') {
+    while (*pos < line.size() && !isBlank(line[*pos])) {
+      (*pos)++;
+    }
+    while (*pos < line.size() && isBlank(line[*pos])) {
+      (*pos)++;
+    }
+    return *pos < line.size();
+  }
+
+  auto next = static_cast<const char *>(
+      memchr(line.data() + *pos, separator, line.size() - *pos));
+  if (next == nullptr) {
+    return false;
+  }
+  *pos = next - line.data() + 1;
+  return true;
+}
 
 bool Supla::Parser::Simple::refreshSource() {
   if (source) {
-    std::string sourceContent = source->getContent();
+    std::string_view content = source->getCachedContentView();
 
-    if (sourceContent.length() == 0) {
+    if (content.length() == 0) {
       valid = false;
       return false;
     }
 
-    std::stringstream ss(sourceContent);
-    std::string line;
-    values.clear();
+    std::fill(found.begin(), found.end(), 0);
 
-    for (int i = 0; std::getline(ss, line, '\n'); i++) {
-      std::stringstream sline(line);
-      sline >> values[i];
+    size_t next = 0;
+    // cells with negative index are never found
+    while (next < cellOrder.size() && (cells[cellOrder[next]].line < 0 ||
+                                       cells[cellOrder[next]].column < 0)) {
+      next++;
+    }
+
+    size_t pos = 0;
+    // lines after the last registered one are not scanned
+    for (int lineIndex = 0; next < cellOrder.size() && pos < content.size();
+         lineIndex++) {
+      auto eol = static_cast<const char *>(
+          memchr(content.data() + pos, '\n', content.size() - pos));
+      size_t end = eol ? eol - content.data() : content.size();
+      std::string_view line = content.substr(pos, end - pos);
+      pos = end + 1;
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      }
+
+      // cells are ordered by column, so each line is scanned only once
+      size_t columnPos = 0;
+      int column = 0;
+      bool columnExists = true;
+      if (separator == ' ') {
+        while (columnPos < line.size() && isBlank(line[columnPos])) {
+          columnPos++;
+        }
+      }
+      for (; next < cellOrder.size() &&
+             cells[cellOrder[next]].line == lineIndex;
+           next++) {
+        int cell = cellOrder[next];
+        while (columnExists && column < cells[cell].column) {
+          columnExists = nextColumn(line, &columnPos);
+          column++;
+        }
+        if (!columnExists) {
+          continue;
+        }
+        values[cell] = parseNumber(line.substr(columnPos));
+        found[cell] = 1;
+      }
     }
 
     valid = true;
@@ -59,6 +181,21 @@ bool Supla::Parser::Simple::refreshSource() {
   return false;
 }
 
+void Supla::Parser::Simple::fillSlots(Snapshot *snapshot) {
+  while (slotCells.size() < slotKeys.size()) {
+    auto cell = keyCells.find(slotKeys[slotCells.size()]);
+    slotCells.push_back(cell != keyCells.end() ? cell->second : -1);
+  }
+
+  for (size_t i = 0; i < slotCells.size(); i++) {
+    int cell = slotCells[i];
+    if (cell >= 0 && found[cell]) {
+      snapshot->found[i] = 1;
+      snapshot->values[i] = values[cell];
+    }
+  }
+}
+
 bool Supla::Parser::Simple::isBasedOnIndex() {
   return true;
 }
@@ -21,15 +21,24 @@
 
 #include <supla/source/source.h>
 
+#include <map>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
 
 #include "parser.h"
 
 namespace Supla {
 
 namespace Parser {
+// Reads numbers from text source. Key index is a line number (starting from
+// 0). Line may be split to columns (see setSeparator()) and value can be taken
+// from selected column (addCellKey()). addKey() uses first column (0). Text
+// after number is ignored (i.e. "21.5 C" gives 21.5), and column which
+// doesn't start with number gives 0.
+//
+// Only registered cells are parsed and source scanning stops after last line
+// which is used.
 class Simple : public Parser {
  public:
   explicit Simple(Supla::Source::Source *);
@@ -38,10 +47,40 @@ class Simple : public Parser {
   bool isBasedOnIndex() override;
   bool refreshSource() override;
 
+  void addKey(const std::string &key, int index) override;
+  void addCellKey(const std::string &key, int index, int column) override;
   double getValue(const std::string &key) override;
 
+  // Sets columns separator. For ' ' (default) columns are separated by any
+  // number of spaces or tabs. For other separators each separator character
+  // starts new column and spaces around values are ignored.
+  void setSeparator(char separator);
+
+  // Returns number from beginning of text (leading blanks are skipped), or 0
+  // when text doesn't start with number
+  static double parseNumber(std::string_view text);
+
  protected:
-  std::map<int, double> values;
+  struct Cell {
+    int line = 0;
+    int column = 0;
+  };
+
+  void fillSlots(Snapshot *snapshot) override;
+  int getCell(int line, int column);
+  // Moves pos from beginning of column to beginning of next one. Returns
+  // false when there is no next column in line.
+  bool nextColumn(std::string_view line, size_t *pos) const;
+
+  char separator = ' ';
+  std::vector<Cell> cells;
+  // cell ids ordered by line and column
+  std::vector<int> cellOrder;
+  std::map<std::string, int> keyCells;
+  std::vector<int> slotCells;
+  // results of last parsing - by cell id
+  std::vector<double> values;
+  std::vector<uint8_t> found;
 };
 };  // namespace Parser
 };  // namespace Supla
@@ -24,16 +24,30 @@ Supla::Sensor::BinaryParsed::BinaryParsed(Supla::Parser::Parser *parser)
     : SensorParsed(parser) {
 }
 
+void Supla::Sensor::BinaryParsed::iterateAlways() {
+  // channel value is updated when parser publishes new snapshot
+  refreshParserSource();
+}
+
+void Supla::Sensor::BinaryParsed::onSnapshotPublished() {
+  channel.setNewValue(getValue());
+}
+
+void Supla::Sensor::BinaryParsed::onResolveParameters() {
+  state = resolveParameter(Supla::Parser::State);
+}
+
 bool Supla::Sensor::BinaryParsed::getValue() {
   bool value = false;
 
-  if (isParameterConfigured(Supla::Parser::State)) {
+  ensureParametersResolved();
+  if (state.isConfigured()) {
     if (refreshParserSource()) {
-      double result = getParameterValue(Supla::Parser::State);
+      double result = getParameterValue(state);
       if (result - 0.1 <= 1 && 1 <= result + 0.1) {
         value = true;
       }
-      if (!parser->isValid()) {
+      if (!isDataValid()) {
         value = false;
       }
     }
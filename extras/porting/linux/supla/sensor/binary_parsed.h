@@ -35,6 +35,13 @@ class BinaryParsed : public VirtualBinary, public SensorParsed {
  public:
   explicit BinaryParsed(Supla::Parser::Parser *);
   bool getValue() override;
+  void iterateAlways() override;
+  void onSnapshotPublished() override;
+
+ protected:
+  void onResolveParameters() override;
+
+  Parameter state;
 };
 };  // namespace Sensor
 };  // namespace Supla
@@ -19,181 +19,147 @@
 
 Supla::Sensor::ElectricityMeterParsed::ElectricityMeterParsed(
     Supla::Parser::Parser *parser) :
-  Supla::Sensor::SensorParsed(parser) {}
+  Supla::Sensor::SensorParsed(parser) {
+  // parser schedules main loop wake up for its next refresh
+  useDeadlineScheduling(false);
+}
 
 void Supla::Sensor::ElectricityMeterParsed::onInit() {
   readValuesFromDevice();
   updateChannelValues();
 }
 
-void Supla::Sensor::ElectricityMeterParsed::readValuesFromDevice() {
-  if (refreshParserSource()) {
-    if (isParameterConfigured(Supla::Parser::FwdActEnergy1)) {
-      setFwdActEnergy(0,
-          getParameterValue(Supla::Parser::FwdActEnergy1) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::FwdActEnergy2)) {
-      setFwdActEnergy(1,
-          getParameterValue(Supla::Parser::FwdActEnergy2) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::FwdActEnergy3)) {
-      setFwdActEnergy(2,
-          getParameterValue(Supla::Parser::FwdActEnergy3) * 100000);
-    }
-
-    if (isParameterConfigured(Supla::Parser::RvrActEnergy1)) {
-      setRvrActEnergy(0,
-          getParameterValue(Supla::Parser::RvrActEnergy1) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::RvrActEnergy2)) {
-      setRvrActEnergy(1,
-          getParameterValue(Supla::Parser::RvrActEnergy2) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::RvrActEnergy3)) {
-      setRvrActEnergy(2,
-          getParameterValue(Supla::Parser::RvrActEnergy3) * 100000);
-    }
-
-    if (isParameterConfigured(Supla::Parser::FwdReactEnergy1)) {
-      setFwdReactEnergy(
-          0, getParameterValue(Supla::Parser::FwdReactEnergy1) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::FwdReactEnergy2)) {
-      setFwdReactEnergy(
-          1, getParameterValue(Supla::Parser::FwdReactEnergy2) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::FwdReactEnergy3)) {
-      setFwdReactEnergy(
-          2, getParameterValue(Supla::Parser::FwdReactEnergy3) * 100000);
-    }
+void Supla::Sensor::ElectricityMeterParsed::iterateAlways() {
+  // values are read when parser publishes new snapshot
+  refreshParserSource();
+}
 
-    if (isParameterConfigured(Supla::Parser::RvrReactEnergy1)) {
-      setRvrReactEnergy(
-          0, getParameterValue(Supla::Parser::RvrReactEnergy1) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::RvrReactEnergy2)) {
-      setRvrReactEnergy(
-          1, getParameterValue(Supla::Parser::RvrReactEnergy2) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::RvrReactEnergy3)) {
-      setRvrReactEnergy(
-          2, getParameterValue(Supla::Parser::RvrReactEnergy3) * 100000);
-    }
+void Supla::Sensor::ElectricityMeterParsed::onSnapshotPublished() {
+  readValuesFromDevice();
+  updateChannelValues();
+}
 
-    if (isParameterConfigured(Supla::Parser::Current1)) {
-      setCurrent(0, getParameterValue(Supla::Parser::Current1) * 1000);
-    }
-    if (isParameterConfigured(Supla::Parser::Current2)) {
-      setCurrent(1, getParameterValue(Supla::Parser::Current2) * 1000);
-    }
-    if (isParameterConfigured(Supla::Parser::Current3)) {
-      setCurrent(2, getParameterValue(Supla::Parser::Current3) * 1000);
-    }
+void Supla::Sensor::ElectricityMeterParsed::onResolveParameters() {
+  const char *fwdActEnergyNames[MAX_PHASES] = {
+      Supla::Parser::FwdActEnergy1,
+      Supla::Parser::FwdActEnergy2,
+      Supla::Parser::FwdActEnergy3};
+  const char *rvrActEnergyNames[MAX_PHASES] = {
+      Supla::Parser::RvrActEnergy1,
+      Supla::Parser::RvrActEnergy2,
+      Supla::Parser::RvrActEnergy3};
+  const char *fwdReactEnergyNames[MAX_PHASES] = {
+      Supla::Parser::FwdReactEnergy1,
+      Supla::Parser::FwdReactEnergy2,
+      Supla::Parser::FwdReactEnergy3};
+  const char *rvrReactEnergyNames[MAX_PHASES] = {
+      Supla::Parser::RvrReactEnergy1,
+      Supla::Parser::RvrReactEnergy2,
+      Supla::Parser::RvrReactEnergy3};
+  const char *currentNames[MAX_PHASES] = {
+      Supla::Parser::Current1,
+      Supla::Parser::Current2,
+      Supla::Parser::Current3};
+  const char *powerActiveNames[MAX_PHASES] = {
+      Supla::Parser::PowerActive1,
+      Supla::Parser::PowerActive2,
+      Supla::Parser::PowerActive3};
+  const char *rvrPowerActiveNames[MAX_PHASES] = {
+      Supla::Parser::RvrPowerActive1,
+      Supla::Parser::RvrPowerActive2,
+      Supla::Parser::RvrPowerActive3};
+  const char *powerReactiveNames[MAX_PHASES] = {
+      Supla::Parser::PowerReactive1,
+      Supla::Parser::PowerReactive2,
+      Supla::Parser::PowerReactive3};
+  const char *powerApparentNames[MAX_PHASES] = {
+      Supla::Parser::PowerApparent1,
+      Supla::Parser::PowerApparent2,
+      Supla::Parser::PowerApparent3};
+  const char *powerFactorNames[MAX_PHASES] = {
+      Supla::Parser::PowerFactor1,
+      Supla::Parser::PowerFactor2,
+      Supla::Parser::PowerFactor3};
+  const char *phaseAngleNames[MAX_PHASES] = {
+      Supla::Parser::PhaseAngle1,
+      Supla::Parser::PhaseAngle2,
+      Supla::Parser::PhaseAngle3};
+  const char *voltageNames[MAX_PHASES] = {
+      Supla::Parser::Voltage1,
+      Supla::Parser::Voltage2,
+      Supla::Parser::Voltage3};
+
+  for (int i = 0; i < MAX_PHASES; i++) {
+    fwdActEnergy[i] = resolveParameter(fwdActEnergyNames[i]);
+    rvrActEnergy[i] = resolveParameter(rvrActEnergyNames[i]);
+    fwdReactEnergy[i] = resolveParameter(fwdReactEnergyNames[i]);
+    rvrReactEnergy[i] = resolveParameter(rvrReactEnergyNames[i]);
+    current[i] = resolveParameter(currentNames[i]);
+    powerActive[i] = resolveParameter(powerActiveNames[i]);
+    rvrPowerActive[i] = resolveParameter(rvrPowerActiveNames[i]);
+    powerReactive[i] = resolveParameter(powerReactiveNames[i]);
+    powerApparent[i] = resolveParameter(powerApparentNames[i]);
+    powerFactor[i] = resolveParameter(powerFactorNames[i]);
+    phaseAngle[i] = resolveParameter(phaseAngleNames[i]);
+    voltage[i] = resolveParameter(voltageNames[i]);
+  }
+  frequency = resolveParameter(Supla::Parser::Frequency);
+}
 
-    // Supla shows signed power (negative value means power returned to grid)
-    if (isParameterConfigured(Supla::Parser::PowerActive1)) {
-      if (isParameterConfigured(Supla::Parser::RvrPowerActive1)) {
-        setPowerActive(0,
-            (getParameterValue(Supla::Parser::PowerActive1) -
-             getParameterValue(Supla::Parser::RvrPowerActive1)) *
-            100000);
-      } else {
-        setPowerActive(0,
-            getParameterValue(Supla::Parser::PowerActive1) * 100000);
+void Supla::Sensor::ElectricityMeterParsed::readValuesFromDevice() {
+  if (refreshParserSource()) {
+    for (int i = 0; i < MAX_PHASES; i++) {
+      if (fwdActEnergy[i].isConfigured()) {
+        setFwdActEnergy(i, getParameterValue(fwdActEnergy[i]) * 100000);
       }
-    } else if (isParameterConfigured(Supla::Parser::RvrPowerActive1)) {
-      setPowerActive(
-          0, -getParameterValue(Supla::Parser::RvrPowerActive1) * 100000);
-    }
-
-    if (isParameterConfigured(Supla::Parser::PowerActive2)) {
-      if (isParameterConfigured(Supla::Parser::RvrPowerActive2)) {
-        setPowerActive(1,
-            (getParameterValue(Supla::Parser::PowerActive2) -
-             getParameterValue(Supla::Parser::RvrPowerActive2)) *
-            100000);
-      } else {
-        setPowerActive(1,
-            getParameterValue(Supla::Parser::PowerActive2) * 100000);
+      if (rvrActEnergy[i].isConfigured()) {
+        setRvrActEnergy(i, getParameterValue(rvrActEnergy[i]) * 100000);
       }
-    } else if (isParameterConfigured(Supla::Parser::RvrPowerActive2)) {
-      setPowerActive(
-          1, -getParameterValue(Supla::Parser::RvrPowerActive2) * 100000);
-    }
-
-    if (isParameterConfigured(Supla::Parser::PowerActive3)) {
-      if (isParameterConfigured(Supla::Parser::RvrPowerActive3)) {
-        setPowerActive(2,
-            (getParameterValue(Supla::Parser::PowerActive3) -
-             getParameterValue(Supla::Parser::RvrPowerActive3)) *
-            100000);
-      } else {
-        setPowerActive(2,
-            getParameterValue(Supla::Parser::PowerActive3) * 100000);
+      if (fwdReactEnergy[i].isConfigured()) {
+        setFwdReactEnergy(i, getParameterValue(fwdReactEnergy[i]) * 100000);
+      }
+      if (rvrReactEnergy[i].isConfigured()) {
+        setRvrReactEnergy(i, getParameterValue(rvrReactEnergy[i]) * 100000);
       }
-    } else if (isParameterConfigured(Supla::Parser::RvrPowerActive3)) {
-      setPowerActive(
-          2, -getParameterValue(Supla::Parser::RvrPowerActive3) * 100000);
-    }
-
-    if (isParameterConfigured(Supla::Parser::PowerReactive1)) {
-      setPowerReactive(
-          0, getParameterValue(Supla::Parser::PowerReactive1) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::PowerReactive2)) {
-      setPowerReactive(
-          1, getParameterValue(Supla::Parser::PowerReactive2) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::PowerReactive3)) {
-      setPowerReactive(
-          2, getParameterValue(Supla::Parser::PowerReactive3) * 100000);
-    }
-
-    if (isParameterConfigured(Supla::Parser::PowerApparent1)) {
-      setPowerApparent(
-          0, getParameterValue(Supla::Parser::PowerApparent1) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::PowerApparent2)) {
-      setPowerApparent(
-          1, getParameterValue(Supla::Parser::PowerApparent2) * 100000);
-    }
-    if (isParameterConfigured(Supla::Parser::PowerApparent3)) {
-      setPowerApparent(
-          2, getParameterValue(Supla::Parser::PowerApparent3) * 100000);
-    }
 
-    if (isParameterConfigured(Supla::Parser::PowerFactor1)) {
-      setPowerFactor(0, getParameterValue(Supla::Parser::PowerFactor1) * 1000);
-    }
-    if (isParameterConfigured(Supla::Parser::PowerFactor2)) {
-      setPowerFactor(1, getParameterValue(Supla::Parser::PowerFactor2) * 1000);
-    }
-    if (isParameterConfigured(Supla::Parser::PowerFactor3)) {
-      setPowerFactor(2, getParameterValue(Supla::Parser::PowerFactor3) * 1000);
-    }
+      if (current[i].isConfigured()) {
+        setCurrent(i, getParameterValue(current[i]) * 1000);
+      }
 
-    if (isParameterConfigured(Supla::Parser::PhaseAngle1)) {
-      setPhaseAngle(0, getParameterValue(Supla::Parser::PhaseAngle1) * 10);
-    }
-    if (isParameterConfigured(Supla::Parser::PhaseAngle2)) {
-      setPhaseAngle(1, getParameterValue(Supla::Parser::PhaseAngle2) * 10);
-    }
-    if (isParameterConfigured(Supla::Parser::PhaseAngle3)) {
-      setPhaseAngle(2, getParameterValue(Supla::Parser::PhaseAngle3) * 10);
-    }
+      // Supla shows signed power (negative value means power returned to
+      // grid)
+      if (powerActive[i].isConfigured()) {
+        if (rvrPowerActive[i].isConfigured()) {
+          setPowerActive(i,
+                         (getParameterValue(powerActive[i]) -
+                          getParameterValue(rvrPowerActive[i])) *
+                             100000);
+        } else {
+          setPowerActive(i, getParameterValue(powerActive[i]) * 100000);
+        }
+      } else if (rvrPowerActive[i].isConfigured()) {
+        setPowerActive(i, -getParameterValue(rvrPowerActive[i]) * 100000);
+      }
 
-    if (isParameterConfigured(Supla::Parser::Voltage1)) {
-      setVoltage(0, getParameterValue(Supla::Parser::Voltage1) * 100);
-    }
-    if (isParameterConfigured(Supla::Parser::Voltage2)) {
-      setVoltage(1, getParameterValue(Supla::Parser::Voltage2) * 100);
-    }
-    if (isParameterConfigured(Supla::Parser::Voltage3)) {
-      setVoltage(2, getParameterValue(Supla::Parser::Voltage3) * 100);
+      if (powerReactive[i].isConfigured()) {
+        setPowerReactive(i, getParameterValue(powerReactive[i]) * 100000);
+      }
+      if (powerApparent[i].isConfigured()) {
+        setPowerApparent(i, getParameterValue(powerApparent[i]) * 100000);
+      }
+      if (powerFactor[i].isConfigured()) {
+        setPowerFactor(i, getParameterValue(powerFactor[i]) * 1000);
+      }
+      if (phaseAngle[i].isConfigured()) {
+        setPhaseAngle(i, getParameterValue(phaseAngle[i]) * 10);
+      }
+      if (voltage[i].isConfigured()) {
+        setVoltage(i, getParameterValue(voltage[i]) * 100);
+      }
     }
 
-    if (isParameterConfigured(Supla::Parser::Frequency)) {
-      setFreq(getParameterValue(Supla::Parser::Frequency) * 100);
+    if (frequency.isConfigured()) {
+      setFreq(getParameterValue(frequency) * 100);
     }
     isDataErrorLogged = false;
 
@@ -100,8 +100,25 @@ class ElectricityMeterParsed : public ElectricityMeter, public SensorParsed {
 
   void readValuesFromDevice() override;
   void onInit() override;
+  void iterateAlways() override;
+  void onSnapshotPublished() override;
 
  protected:
+  void onResolveParameters() override;
+
+  Parameter fwdActEnergy[MAX_PHASES];
+  Parameter rvrActEnergy[MAX_PHASES];
+  Parameter fwdReactEnergy[MAX_PHASES];
+  Parameter rvrReactEnergy[MAX_PHASES];
+  Parameter current[MAX_PHASES];
+  Parameter powerActive[MAX_PHASES];
+  Parameter rvrPowerActive[MAX_PHASES];
+  Parameter powerReactive[MAX_PHASES];
+  Parameter powerApparent[MAX_PHASES];
+  Parameter powerFactor[MAX_PHASES];
+  Parameter phaseAngle[MAX_PHASES];
+  Parameter voltage[MAX_PHASES];
+  Parameter frequency;
   bool isDataErrorLogged = false;
 };
 };  // namespace Sensor
@@ -15,7 +15,6 @@
 */
 
 #include <supla/log_wrapper.h>
-#include <supla/time.h>
 
 #include "impulse_counter_parsed.h"
 
@@ -23,27 +22,35 @@ Supla::Sensor::ImpulseCounterParsed::ImpulseCounterParsed(
     Supla::Parser::Parser *parser)
     : SensorParsed(parser) {
   channel.setType(SUPLA_CHANNELTYPE_IMPULSE_COUNTER);
+  useChannelUpdateIteration();
 }
 
 void Supla::Sensor::ImpulseCounterParsed::iterateAlways() {
-  if (millis() - lastReadTime > 10000) {
-    lastReadTime = millis();
-    channel.setNewValue(getValue());
-  }
+  // channel value is updated when parser publishes new snapshot
+  refreshParserSource();
+}
+
+void Supla::Sensor::ImpulseCounterParsed::onSnapshotPublished() {
+  channel.setNewValue(getValue());
 }
 
 void Supla::Sensor::ImpulseCounterParsed::onInit() {
   channel.setNewValue(getValue());
 }
 
+void Supla::Sensor::ImpulseCounterParsed::onResolveParameters() {
+  counter = resolveParameter(Supla::Parser::Counter);
+}
+
 unsigned _supla_int64_t Supla::Sensor::ImpulseCounterParsed::getValue() {
   double value = 0;
 
-  if (isParameterConfigured(Supla::Parser::Counter)) {
+  ensureParametersResolved();
+  if (counter.isConfigured()) {
     if (refreshParserSource()) {
-      value = getParameterValue(Supla::Parser::Counter);
+      value = getParameterValue(counter);
     }
-    if (!parser->isValid()) {
+    if (!isDataValid()) {
       if (!isDataErrorLogged) {
         isDataErrorLogged = true;
         SUPLA_LOG_WARNING(
@@ -40,9 +40,12 @@ class ImpulseCounterParsed : public ChannelElement, public SensorParsed {
   virtual unsigned _supla_int64_t getValue();
   void onInit() override;
   void iterateAlways() override;
+  void onSnapshotPublished() override;
 
  protected:
-  uint64_t lastReadTime = 0;
+  void onResolveParameters() override;
+
+  Parameter counter;
   bool isDataErrorLogged = false;
 };
 };  // namespace Sensor
@@ -20,26 +20,44 @@ Supla::Sensor::SensorParsed::SensorParsed(Supla::Parser::Parser *parser)
     : parser(parser) {
   static int instanceCounter = 0;
   id = instanceCounter++;
+  if (parser) {
+    parser->addSnapshotListener(this);
+  }
+}
+
+Supla::Sensor::SensorParsed::~SensorParsed() {
+  if (parser) {
+    parser->removeSnapshotListener(this);
+  }
 }
 
 void Supla::Sensor::SensorParsed::setMapping(const std::string &parameter,
                                              const std::string &key) {
   parameterToKey[parameter] = key;
   parser->addKey(key, -1);  // ignore index
+  parametersResolved = false;
 }
 
 void Supla::Sensor::SensorParsed::setMapping(const std::string &parameter,
                                              const int index) {
+  setMapping(parameter, index, 0);
+}
+
+void Supla::Sensor::SensorParsed::setMapping(const std::string &parameter,
+                                             const int index,
+                                             const int column) {
   std::string key = parameter;
   key += "_";
   key += std::to_string(id);
   parameterToKey[parameter] = key;
-  parser->addKey(key, index);
+  parser->addCellKey(key, index, column);
+  parametersResolved = false;
 }
 
 void Supla::Sensor::SensorParsed::setMultiplier(const std::string &parameter,
                                                 double multiplier) {
   parameterMultiplier[parameter] = multiplier;
+  parametersResolved = false;
 }
 
 double Supla::Sensor::SensorParsed::getParameterValue(
@@ -51,11 +69,61 @@ double Supla::Sensor::SensorParsed::getParameterValue(
   return parser->getValue(parameterToKey[parameter]) * multiplier;
 }
 
+double Supla::Sensor::SensorParsed::getParameterValue(
+    const Parameter &parameter) {
+  if (!snapshot || parameter.slot < 0 ||
+      parameter.slot >= static_cast<int>(snapshot->found.size()) ||
+      !snapshot->found[parameter.slot]) {
+    dataValid = false;
+    return 0;
+  }
+  return snapshot->values[parameter.slot] * parameter.multiplier;
+}
+
+bool Supla::Sensor::SensorParsed::isDataValid() const {
+  return dataValid;
+}
+
+void Supla::Sensor::SensorParsed::onSnapshotPublished() {
+}
+
+void Supla::Sensor::SensorParsed::resolveParameters() {
+  parametersResolved = true;
+  if (parser) {
+    onResolveParameters();
+  }
+}
+
+void Supla::Sensor::SensorParsed::ensureParametersResolved() {
+  if (!parametersResolved) {
+    resolveParameters();
+  }
+}
+
+Supla::Sensor::SensorParsed::Parameter
+Supla::Sensor::SensorParsed::resolveParameter(const std::string &parameter) {
+  Parameter result;
+  auto key = parameterToKey.find(parameter);
+  if (key != parameterToKey.end()) {
+    result.slot = parser->getSlot(key->second);
+  }
+  auto multiplier = parameterMultiplier.find(parameter);
+  if (multiplier != parameterMultiplier.end()) {
+    result.multiplier = multiplier->second;
+  }
+  return result;
+}
+
 bool Supla::Sensor::SensorParsed::refreshParserSource() {
-  if (parser && parser->refreshParserSource()) {
-    return true;
+  dataValid = false;
+  if (!parser) {
+    return false;
   }
-  return false;
+  ensureParametersResolved();
+  bool result = parser->refreshParserSource();
+  snapshot = parser->getSnapshot();
+  dataValid = result && snapshot->valid;
+  return dataValid;
 }
 
 bool Supla::Sensor::SensorParsed::isParameterConfigured(
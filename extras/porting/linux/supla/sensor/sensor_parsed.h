@@ -22,32 +22,73 @@
 #include <supla/parser/parser.h>
 
 #include <map>
+#include <memory>
 #include <string>
 
 namespace Supla {
 namespace Sensor {
 
-class SensorParsed {
+// Parsed sensor reads values from snapshots published by parser. Each
+// sensor drives parser refresh, and all sensors which share parser are
+// notified about new snapshot (onSnapshotPublished()), so their channels are
+// updated from the same data in the same iteration.
+class SensorParsed : public Supla::Parser::SnapshotListener {
  public:
   explicit SensorParsed(Supla::Parser::Parser *);
+  virtual ~SensorParsed();
 
   void setMapping(const std::string &parameter, const std::string &key);
 
   void setMapping(const std::string &parameter, const int index);
 
+  // Maps parameter to column of line with given index (for parsers based on
+  // index)
+  void setMapping(const std::string &parameter,
+                  const int index,
+                  const int column);
+
   void setMultiplier(const std::string &parameter, double multiplier);
 
   bool refreshParserSource();
 
   bool isParameterConfigured(const std::string &parameter);
 
+  // Resolves configured parameters to parser slots, so their values are
+  // later read without any key lookup. Should be called after mapping and
+  // multipliers are set. Otherwise it is done before first read.
+  void resolveParameters();
+
+  void onSnapshotPublished() override;
+
  protected:
+  struct Parameter {
+    int slot = -1;
+    double multiplier = 1;
+
+    bool isConfigured() const {
+      return slot >= 0;
+    }
+  };
+
+  // Derived classes resolve here their parameters with resolveParameter()
+  virtual void onResolveParameters() {
+  }
+  void ensureParametersResolved();
+  Parameter resolveParameter(const std::string &parameter);
+
   double getParameterValue(const std::string &parameter);
+  // Reads value from snapshot taken by last refreshParserSource() call.
+  // Missing value makes data invalid (see isDataValid()).
+  double getParameterValue(const Parameter &parameter);
+  bool isDataValid() const;
 
   Supla::Parser::Parser *parser = nullptr;
   std::map<std::string, std::string> parameterToKey;
   std::map<std::string, double> parameterMultiplier;
   int id;
+  bool parametersResolved = false;
+  std::shared_ptr<const Supla::Parser::Snapshot> snapshot;
+  bool dataValid = false;
 };
 };  // namespace Sensor
 };  // namespace Supla
@@ -29,14 +29,28 @@ void Supla::Sensor::ThermometerParsed::onInit() {
   channel.setNewValue(getValue());
 }
 
+void Supla::Sensor::ThermometerParsed::iterateAlways() {
+  // channel value is updated when parser publishes new snapshot
+  refreshParserSource();
+}
+
+void Supla::Sensor::ThermometerParsed::onSnapshotPublished() {
+  channel.setNewValue(getValue());
+}
+
+void Supla::Sensor::ThermometerParsed::onResolveParameters() {
+  temperature = resolveParameter(Supla::Parser::Temperature);
+}
+
 double Supla::Sensor::ThermometerParsed::getValue() {
   double value = TEMPERATURE_NOT_AVAILABLE;
 
-  if (isParameterConfigured(Supla::Parser::Temperature)) {
+  ensureParametersResolved();
+  if (temperature.isConfigured()) {
     if (refreshParserSource()) {
-      value = getParameterValue(Supla::Parser::Temperature);
+      value = getParameterValue(temperature);
     }
-    if (!parser->isValid()) {
+    if (!isDataValid()) {
       if (!isDataErrorLogged) {
         isDataErrorLogged = true;
         SUPLA_LOG_WARNING("ThermometerParsed: source data error");
@@ -38,8 +38,13 @@ class ThermometerParsed : public Thermometer, public SensorParsed {
   explicit ThermometerParsed(Supla::Parser::Parser *);
   double getValue() override;
   void onInit() override;
+  void iterateAlways() override;
+  void onSnapshotPublished() override;
 
  protected:
+  void onResolveParameters() override;
+
+  Parameter temperature;
   bool isDataErrorLogged = false;
 };
 };  // namespace Sensor
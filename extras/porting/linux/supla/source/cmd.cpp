@@ -16,26 +16,191 @@
  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <linux_event_loop.h>
+#include <signal.h>
+#include <spawn.h>
+#include <supla/log_wrapper.h>
+#include <supla/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <cstdio>
 
 #include "cmd.h"
 
+extern char **environ;
+
+std::atomic<int> Supla::Source::Cmd::runningCount(0);
+int Supla::Source::Cmd::maxRunningCount = 4;
+
 Supla::Source::Cmd::Cmd(const char *cmd) : cmdLine(cmd) {
 }
 
 Supla::Source::Cmd::~Cmd() {
+  std::lock_guard<std::mutex> lock(processMutex);
+  killProcess();
+}
+
+void Supla::Source::Cmd::setAsync(bool async) {
+  this->async = async;
+}
+
+void Supla::Source::Cmd::setTimeoutMs(uint32_t timeoutMs) {
+  this->timeoutMs = timeoutMs;
+}
+
+void Supla::Source::Cmd::setMaxRunningCommands(int count) {
+  maxRunningCount = count < 1 ? 1 : count;
+}
+
+int Supla::Source::Cmd::getRunningCommandsCount() {
+  return runningCount;
 }
 
 std::string Supla::Source::Cmd::getContent() {
+  if (async) {
+    std::lock_guard<std::mutex> lock(processMutex);
+    if (pid > 0) {
+      pollProcess();
+    }
+    checkTimeout();
+    if (pid <= 0 && runningCount < maxRunningCount) {
+      startProcess();
+    }
+    return lastOutput;
+  }
+
   auto p = popen(cmdLine.c_str(), "r");
   if (p) {
     std::string content;
-    int c = 0;
-    while ((c = fgetc(p)) != EOF) {
-      content.append(1, static_cast<char>(c));
+    char buf[4096];
+    size_t bytes = 0;
+    while ((bytes = fread(buf, 1, sizeof(buf), p)) > 0) {
+      content.append(buf, bytes);
     }
     pclose(p);
     return content;
   }
   return std::string("");
 }
+
+void Supla::Source::Cmd::iterateAlways() {
+  if (!async) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(processMutex);
+  if (pid > 0) {
+    pollProcess();
+  }
+  checkTimeout();
+}
+
+void Supla::Source::Cmd::checkTimeout() {
+  if (pid > 0 && millis() - startTimeMs > timeoutMs) {
+    SUPLA_LOG_WARNING("Cmd: \"%s\" timeout - killing it", cmdLine.c_str());
+    killProcess();
+    lastOutput.clear();
+  }
+}
+
+bool Supla::Source::Cmd::startProcess() {
+  int fds[2] = {};
+  if (pipe2(fds, O_CLOEXEC) != 0) {
+    SUPLA_LOG_ERROR("Cmd: pipe failed (%d)", errno);
+    return false;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+
+  // command runs in its own process group, so whole pipeline can be killed
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+  posix_spawnattr_setpgroup(&attr, 0);
+
+  const char *argv[] = {"sh", "-c", cmdLine.c_str(), nullptr};
+  int result = posix_spawn(&pid,
+                           "/bin/sh",
+                           &actions,
+                           &attr,
+                           const_cast<char *const *>(argv),
+                           environ);
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attr);
+  close(fds[1]);
+
+  if (result != 0) {
+    SUPLA_LOG_ERROR(
+        "Cmd: failed to start \"%s\" (%d)", cmdLine.c_str(), result);
+    close(fds[0]);
+    pid = -1;
+    return false;
+  }
+
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+  pipeFd = fds[0];
+  Supla::Linux::EventLoop::addFd(pipeFd);
+  startTimeMs = millis();
+  output.clear();
+  runningCount++;
+  return true;
+}
+
+void Supla::Source::Cmd::readOutput() {
+  if (pipeFd < 0) {
+    return;
+  }
+  char buf[4096];
+  ssize_t bytes = 0;
+  while ((bytes = read(pipeFd, buf, sizeof(buf))) > 0) {
+    output.append(buf, bytes);
+  }
+  if (bytes == 0 || (bytes < 0 && errno != EAGAIN && errno != EINTR)) {
+    closePipe();
+  }
+}
+
+void Supla::Source::Cmd::closePipe() {
+  if (pipeFd >= 0) {
+    Supla::Linux::EventLoop::removeFd(pipeFd);
+    close(pipeFd);
+    pipeFd = -1;
+  }
+}
+
+void Supla::Source::Cmd::pollProcess() {
+  readOutput();
+
+  // output is complete when process exits
+  int status = 0;
+  if (waitpid(pid, &status, WNOHANG) == pid) {
+    pid = -1;
+    runningCount--;
+    // collect data written just before exit
+    readOutput();
+    closePipe();
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+      lastOutput.swap(output);
+    } else {
+      SUPLA_LOG_WARNING(
+          "Cmd: \"%s\" failed (status %d)", cmdLine.c_str(), status);
+      lastOutput.clear();
+    }
+    output.clear();
+  }
+}
+
+void Supla::Source::Cmd::killProcess() {
+  closePipe();
+  if (pid > 0) {
+    kill(-pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    pid = -1;
+    runningCount--;
+  }
+  output.clear();
+}
@@ -19,8 +19,12 @@
 #ifndef EXTRAS_PORTING_LINUX_SUPLA_SOURCE_CMD_H_
 #define EXTRAS_PORTING_LINUX_SUPLA_SOURCE_CMD_H_
 
+#include <supla/element.h>
 #include <supla/parser/parser.h>
+#include <sys/types.h>
 
+#include <atomic>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 
 #include "source.h"
@@ -28,14 +32,63 @@
 namespace Supla {
 
 namespace Source {
-class Cmd : public Source {
+// Runs shell command and returns its output.
+// By default command is executed synchronously on each getContent() call.
+// In async mode command is started in background and getContent() only
+// collects its output without blocking. It returns output of the last
+// command which finished (empty string if there was none yet, or if last
+// command was killed after timeout) and starts next run of command.
+// Output of running command is read in iterateAlways(), as soon as it
+// arrives (pipe is registered in EventLoop), so command isn't blocked on full
+// pipe until next getContent() call.
+// Async command which exits with non-zero status is treated as failed and its
+// output is not returned. In sync mode output is returned regardless of exit
+// status.
+class Cmd : public Source, public Supla::Element {
  public:
   explicit Cmd(const char *cmd);
   virtual ~Cmd();
   std::string getContent() override;
+  void iterateAlways() override;
+
+  void setAsync(bool async);
+  // Command running longer than timeout is killed (async mode only). Timeout
+  // is checked in iterateAlways(), so it doesn't depend on parser's refresh
+  // time.
+  void setTimeoutMs(uint32_t timeoutMs);
+  // Limits number of commands running in background at the same time.
+  // When limit is reached, command is started on one of next getContent()
+  // calls.
+  static void setMaxRunningCommands(int count);
+  static int getRunningCommandsCount();
 
  protected:
+  bool startProcess();
+  // Reads available output without blocking
+  void readOutput();
+  // Reads output and reaps finished process
+  void pollProcess();
+  void killProcess();
+  // Kills command which runs longer than timeoutMs
+  void checkTimeout();
+  void closePipe();
+
   std::string cmdLine;
+  bool async = false;
+  uint32_t timeoutMs = 60 * 1000;
+
+  pid_t pid = -1;
+  int pipeFd = -1;
+  uint64_t startTimeMs = 0;
+  std::string output;
+  std::string lastOutput;
+  // guards process state, which is used by getContent() (may be called on
+  // worker thread) and iterateAlways() (main thread)
+  std::mutex processMutex;
+
+  // async commands of sources used by parsers on worker threads
+  static std::atomic<int> runningCount;
+  static int maxRunningCount;
 };
 };  // namespace Source
 };  // namespace Supla
@@ -16,7 +16,13 @@
  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <linux_event_loop.h>
 #include <supla/log_wrapper.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <chrono>  // NOLINT(build/c++11)
 #include <fstream>
@@ -24,14 +30,23 @@
 
 #include "file.h"
 
+namespace {
+const off_t MaxFileSize = 1024 * 1024 * 10;
+}  // namespace
+
 Supla::Source::File::File(const char *filePath, int expirationSec)
     : filePath(filePath), fileExpirationSec(expirationSec) {
 }
 
 Supla::Source::File::~File() {
+  closeInotify();
 }
 
 std::string Supla::Source::File::getContent() {
+  if (cacheMode) {
+    return std::string(getContentView());
+  }
+
   std::string result;
   std::ifstream file;
   try {
@@ -70,3 +85,212 @@ void Supla::Source::File::setExpirationTime(int timeSec) {
   }
   fileExpirationSec = timeSec;
 }
+
+void Supla::Source::File::setCacheMode(bool enabled) {
+  cacheMode = enabled;
+  if (!cacheMode) {
+    clearCache();
+  }
+}
+
+void Supla::Source::File::setInotify(bool enabled) {
+  inotifyEnabled = enabled;
+  if (!inotifyEnabled) {
+    closeInotify();
+  }
+}
+
+std::string_view Supla::Source::File::getContentView() {
+  if (!cacheMode) {
+    return Supla::Source::Source::getContentView();
+  }
+
+  FileStat fileStat;
+  if (!readFileStat(&fileStat)) {
+    clearCache();
+    return {};
+  }
+
+  if (fileStat.tooOld) {
+    if (!fileIsTooOldLog) {
+      fileIsTooOldLog = true;
+      SUPLA_LOG_DEBUG("File: file \"%s\" is too old", filePath.c_str());
+    }
+    clearCache();
+    return {};
+  }
+  fileIsTooOldLog = false;
+
+  if (cacheValid && isSameFile(fileStat, cacheStat)) {
+    return cache;
+  }
+
+  clearCache();
+  int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return {};
+  }
+
+  struct stat st = {};
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return {};
+  }
+
+  size_t size = st.st_size;
+  if (st.st_size > MaxFileSize) {
+    // file is too big - cut it at 10 MB
+    size = MaxFileSize;
+  }
+
+  // buffer capacity is kept, so it is allocated again only when file grows
+  cache.resize(size);
+  size_t length = 0;
+  while (length < size) {
+    ssize_t count = pread(fd, &cache[length], size - length, length);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0) {
+      SUPLA_LOG_WARNING("File: read of \"%s\" failed (errno %d)",
+                        filePath.c_str(),
+                        errno);
+      close(fd);
+      cache.clear();
+      return {};
+    }
+    if (count == 0) {
+      // file was truncated during read
+      break;
+    }
+    length += count;
+  }
+  close(fd);
+  cache.resize(length);
+
+  // stat is taken from opened file, so file replaced during read is read
+  // again on next refresh
+  cacheValid = true;
+  cacheStat = fileStat;
+  cacheStat.dev = st.st_dev;
+  cacheStat.ino = st.st_ino;
+  cacheStat.size = st.st_size;
+  cacheStat.mtime = st.st_mtim;
+  return cache;
+}
+
+uint32_t Supla::Source::File::getContentVersion() {
+  if (!cacheMode) {
+    return 0;
+  }
+
+  if (contentVersion != 0 && inotifyFd >= 0) {
+    // file is checked only after change notification or when it may expire
+    if (versionNotificationCount == getChangeNotificationCount() &&
+        (versionStat.tooOld || versionStat.ino == 0 ||
+         time(nullptr) <= versionStat.mtime.tv_sec + fileExpirationSec)) {
+      return contentVersion;
+    }
+  }
+
+  versionNotificationCount = getChangeNotificationCount();
+  FileStat fileStat;
+  readFileStat(&fileStat);
+  if (contentVersion == 0 || !isSameFile(fileStat, versionStat) ||
+      fileStat.tooOld != versionStat.tooOld) {
+    versionStat = fileStat;
+    contentVersion++;
+    if (contentVersion == 0) {
+      contentVersion = 1;
+    }
+  }
+  return contentVersion;
+}
+
+uint32_t Supla::Source::File::getChangeNotificationCount() {
+  if (!inotifyEnabled || !cacheMode) {
+    return 0;
+  }
+
+  if (inotifyFd < 0) {
+    initInotify();
+    if (inotifyFd < 0) {
+      return 0;
+    }
+  }
+
+  std::string fileName = filePath.filename().string();
+  alignas(struct inotify_event) char buf[4096];
+  while (true) {
+    ssize_t len = read(inotifyFd, buf, sizeof(buf));
+    if (len <= 0) {
+      break;
+    }
+    for (char *ptr = buf; ptr < buf + len;) {
+      auto event = reinterpret_cast<struct inotify_event *>(ptr);
+      if (event->len > 0 && fileName == event->name) {
+        changeNotificationCount++;
+      }
+      ptr += sizeof(struct inotify_event) + event->len;
+    }
+  }
+  return changeNotificationCount;
+}
+
+bool Supla::Source::File::readFileStat(FileStat *result) {
+  *result = {};
+  struct stat st = {};
+  if (stat(filePath.c_str(), &st) != 0) {
+    return false;
+  }
+  result->dev = st.st_dev;
+  result->ino = st.st_ino;
+  result->size = st.st_size;
+  result->mtime = st.st_mtim;
+  result->tooOld = st.st_mtim.tv_sec + fileExpirationSec < time(nullptr);
+  return true;
+}
+
+bool Supla::Source::File::isSameFile(const FileStat &a, const FileStat &b) {
+  return a.dev == b.dev && a.ino == b.ino && a.size == b.size &&
+         a.mtime.tv_sec == b.mtime.tv_sec && a.mtime.tv_nsec == b.mtime.tv_nsec;
+}
+
+void Supla::Source::File::clearCache() {
+  cacheValid = false;
+  cache.clear();
+}
+
+void Supla::Source::File::initInotify() {
+  std::string dir = filePath.parent_path().string();
+  if (dir.empty()) {
+    dir = ".";
+  }
+
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    SUPLA_LOG_WARNING("File: inotify init failed (errno %d)", errno);
+    inotifyEnabled = false;
+    return;
+  }
+
+  // directory is watched, so atomic replace of file (rename) is detected
+  if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    SUPLA_LOG_WARNING(
+        "File: can't watch directory \"%s\" (errno %d)", dir.c_str(), errno);
+    close(fd);
+    inotifyEnabled = false;
+    return;
+  }
+  inotifyFd = fd;
+  // main loop is woken up on file change, so parser refresh isn't delayed
+  Supla::Linux::EventLoop::addFd(inotifyFd, true);
+}
+
+void Supla::Source::File::closeInotify() {
+  if (inotifyFd >= 0) {
+    Supla::Linux::EventLoop::removeFd(inotifyFd);
+    close(inotifyFd);
+    inotifyFd = -1;
+  }
+}
@@ -21,8 +21,12 @@
 
 #include <supla/parser/parser.h>
 
+#include <sys/types.h>
+#include <time.h>
+
 #include <filesystem>
 #include <string>
+#include <string_view>
 
 #include "source.h"
 
@@ -34,13 +38,52 @@ class File : public Source {
   explicit File(const char *filePath, int expirationSec = 10 * 60);
   virtual ~File();
   std::string getContent() override;
+  std::string_view getContentView() override;
+  uint32_t getContentVersion() override;
+  uint32_t getChangeNotificationCount() override;
 
   void setExpirationTime(int timeSec);
+  // In cache mode file content is kept in reused buffer and parsers get it
+  // without copying. File is read again (with pread) only when its inode,
+  // size or modification time changes, so unchanged file isn't parsed again.
+  // Parsers never access the file directly, so file may be rewritten in
+  // place while it is parsed.
+  void setCacheMode(bool enabled);
+  // Watch file with inotify, so parser is refreshed right after file is
+  // written, without waiting for its refresh time. Requires cache mode.
+  void setInotify(bool enabled);
 
  protected:
+  struct FileStat {
+    dev_t dev = 0;
+    ino_t ino = 0;
+    off_t size = 0;
+    struct timespec mtime = {};
+    bool tooOld = false;
+  };
+
+  // Returns false when file doesn't exist
+  bool readFileStat(FileStat *result);
+  static bool isSameFile(const FileStat &a, const FileStat &b);
+  void clearCache();
+  void initInotify();
+  void closeInotify();
+
   std::filesystem::path filePath;
   int fileExpirationSec = 10 * 60;
   bool fileIsTooOldLog = false;
+
+  bool cacheMode = false;
+  bool cacheValid = false;
+  std::string cache;
+  FileStat cacheStat;
+  FileStat versionStat;
+  uint32_t contentVersion = 0;
+
+  bool inotifyEnabled = false;
+  int inotifyFd = -1;
+  uint32_t changeNotificationCount = 0;
+  uint32_t versionNotificationCount = 0;
 };
 };  // namespace Source
 };  // namespace Supla
@@ -0,0 +1,52 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <supla/time.h>
+
+#include "source.h"
+
+uint32_t Supla::Source::Source::refreshCache(uint32_t maxAgeMs) {
+  uint32_t notifications = getChangeNotificationCount();
+  if (cacheReady && millis() - cacheReadTime < maxAgeMs &&
+      notifications == cachedNotificationCount) {
+    return cachedVersion;
+  }
+  cachedNotificationCount = notifications;
+  cacheReadTime = millis();
+
+  uint32_t version = getContentVersion();
+  if (cacheReady && version != 0 && version == cachedSourceVersion) {
+    return cachedVersion;
+  }
+
+  cachedContent = getContentView();
+  cachedSourceVersion = version;
+  cacheReady = true;
+  cachedVersion++;
+  if (cachedVersion == 0) {
+    cachedVersion = 1;
+  }
+  return cachedVersion;
+}
+
+std::string_view Supla::Source::Source::getCachedContentView() {
+  if (!cacheReady) {
+    refreshCache(0);
+  }
+  return cachedContent;
+}
@@ -19,7 +19,11 @@
 #ifndef EXTRAS_PORTING_LINUX_SUPLA_SOURCE_SOURCE_H_
 #define EXTRAS_PORTING_LINUX_SUPLA_SOURCE_SOURCE_H_
 
+#include <stdint.h>
+
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <string_view>
 
 namespace Supla {
 
@@ -28,6 +32,54 @@ class Source {
  public:
   virtual ~Source() {}
   virtual std::string getContent() = 0;
+
+  // Returns source content. View is valid until next call of
+  // getContentView() or getContent() on this source.
+  virtual std::string_view getContentView() {
+    content = getContent();
+    return content;
+  }
+
+  // Returns number which changes each time when source content changes, so
+  // parser may skip parsing of the same content again. 0 means that source
+  // can't detect changes and content has to be parsed on each refresh.
+  virtual uint32_t getContentVersion() {
+    return 0;
+  }
+
+  // Returns counter of change notifications received from OS. Parser refreshes
+  // its data without waiting for refresh time when this value changes.
+  virtual uint32_t getChangeNotificationCount() {
+    return 0;
+  }
+
+  // Reads content of source and keeps it in cache, unless it was read less
+  // than maxAgeMs ago (and no change notification arrived since then), so
+  // source shared by multiple parsers is read once per their refresh period.
+  // Returns version of cached content, which changes each time when different
+  // content is cached. It is never 0.
+  uint32_t refreshCache(uint32_t maxAgeMs);
+  // Returns content cached by refreshCache(). Source is read if cache is
+  // empty.
+  std::string_view getCachedContentView();
+
+  // Locked while source is read or its cached content is parsed (parsers may
+  // run on worker threads, see Supla::Linux::WorkerPool)
+  std::mutex &getMutex() {
+    return mutex;
+  }
+
+ protected:
+  std::string content;
+
+ private:
+  std::string_view cachedContent;
+  bool cacheReady = false;
+  uint64_t cacheReadTime = 0;
+  uint32_t cachedVersion = 0;
+  uint32_t cachedSourceVersion = 0;
+  uint32_t cachedNotificationCount = 0;
+  std::mutex mutex;
 };
 };  // namespace Source
 };  // namespace Supla
@@ -0,0 +1,60 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <supla/crc16.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+typedef uint16_t (*Crc16Function)(uint16_t, const void *, size_t);
+
+double measureMBps(Crc16Function function, const std::vector<uint8_t> &data) {
+  const int rounds = 2000;
+  volatile uint16_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    sink = sink + function(0xFFFF, data.data(), data.size());
+  }
+  auto stop = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(stop - start).count();
+  return data.size() * rounds / seconds / 1e6;
+}
+
+}  // namespace
+
+TEST(Crc16Benchmark, ThroughputVsBufferSize) {
+  printf("%10s %14s %14s %14s\n",
+         "size [B]",
+         "bitwise [MB/s]",
+         "table [MB/s]",
+         "slice8 [MB/s]");
+  for (size_t size : {8, 32, 256, 4096}) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+      data[i] = i * 31 + 7;
+    }
+    printf("%10zu %14.1f %14.1f %14.1f\n",
+           size,
+           measureMBps(&crc16_update_buf_bitwise, data),
+           measureMBps(&crc16_update_buf_table, data),
+           measureMBps(&crc16_update_buf_slicing_by_8, data));
+  }
+}
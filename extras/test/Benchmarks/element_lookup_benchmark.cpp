@@ -0,0 +1,83 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <supla/element.h>
+#include <supla/channel.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+class ElementWithChannel : public Supla::Element {
+ public:
+  Supla::Channel *getChannel() override {
+    return &channel;
+  }
+  Supla::Channel channel;
+};
+
+// Reference implementation - old linear list scan
+Supla::Element *linearLookup(int channelNumber) {
+  auto element = Supla::Element::begin();
+  while (element != nullptr && element->getChannelNumber() != channelNumber) {
+    element = element->next();
+  }
+  return element;
+}
+
+template <typename Lookup>
+double measureNsPerLookup(int channelCount, Lookup lookup) {
+  const int rounds = 20000;
+  volatile uintptr_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    // always ask for the last channel - worst case for list scan
+    sink = sink + reinterpret_cast<uintptr_t>(lookup(channelCount - 1));
+  }
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+         rounds;
+}
+
+}  // namespace
+
+TEST(ElementLookupBenchmark, LookupCostVsChannelCount) {
+  memset(&(Supla::Channel::reg_dev), 0, sizeof(Supla::Channel::reg_dev));
+  std::vector<ElementWithChannel *> elements;
+
+  printf("%10s %16s %16s\n", "channels", "index [ns]", "list scan [ns]");
+  for (int count = 1; count <= SUPLA_CHANNELMAXCOUNT; count++) {
+    elements.push_back(new ElementWithChannel);
+    if (count != 1 && count % 16 != 0) {
+      continue;
+    }
+    ASSERT_EQ(Supla::Element::getElementByChannelNumber(count - 1),
+              elements.back());
+    double indexed = measureNsPerLookup(
+        count, &Supla::Element::getElementByChannelNumber);
+    double scan = measureNsPerLookup(count, &linearLookup);
+    printf("%10d %16.2f %16.2f\n", count, indexed, scan);
+  }
+
+  for (auto element : elements) {
+    delete element;
+  }
+  memset(&(Supla::Channel::reg_dev), 0, sizeof(Supla::Channel::reg_dev));
+}
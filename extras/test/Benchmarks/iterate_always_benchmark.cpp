@@ -0,0 +1,147 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include <arduino_mock.h>
+#include <supla/element.h>
+#include <supla/time.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+class FakeTime : public TimeInterface {
+ public:
+  uint64_t millis() override {
+    return now;
+  }
+  uint64_t now = 1;
+};
+
+// Old style element: checks its timestamp on each iteration
+class PollingSensor : public Supla::Element {
+ public:
+  void iterateAlways() override {
+    if (millis() - lastReadTime > 10000) {
+      lastReadTime = millis();
+      reads++;
+    }
+  }
+  uint64_t lastReadTime = 0;
+  int reads = 0;
+};
+
+// The same sensor which uses deadline scheduler
+class ScheduledSensor : public PollingSensor {
+ public:
+  void iterateAlways() override {
+    PollingSensor::iterateAlways();
+    scheduleIterateAlways(lastReadTime + 10001);
+  }
+  bool isIteratedAlwaysOnDeadline() override {
+    return true;
+  }
+};
+
+// Element which still has to be iterated on each loop
+class BusyElement : public Supla::Element {
+ public:
+  void iterateAlways() override {
+    counter++;
+  }
+  int counter = 0;
+};
+
+const int ElementCount = 128;
+const int BusyCount = 8;
+const int Iterations = 200000;
+
+void iterateOldLoop(uint64_t) {
+  for (auto element = Supla::Element::begin(); element != nullptr;
+       element = element->next()) {
+    element->iterateAlways();
+  }
+}
+
+void iterateScheduledLoop(uint64_t now) {
+  for (auto element = Supla::Element::beginAlwaysIterate(); element != nullptr;
+       element = element->nextAlwaysIterate()) {
+    element->iterateAlways();
+  }
+  for (auto element = Supla::Element::takeDueElements(now); element != nullptr;
+       element = element->nextDue()) {
+    element->iterateAlways();
+  }
+}
+
+template <typename Sensor, typename Loop>
+double measureIterationsPerSecond(Loop loop, int *reads) {
+  FakeTime time;
+  std::vector<Supla::Element *> elements;
+  std::vector<Sensor *> sensors;
+  for (int i = 0; i < ElementCount; i++) {
+    if (i < BusyCount) {
+      elements.push_back(new BusyElement);
+    } else {
+      auto sensor = new Sensor;
+      sensors.push_back(sensor);
+      elements.push_back(sensor);
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < Iterations; i++) {
+    // 1 ms per loop iteration
+    time.now++;
+    loop(time.now);
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  *reads = 0;
+  for (auto sensor : sensors) {
+    *reads += sensor->reads;
+  }
+  for (auto element : elements) {
+    delete element;
+  }
+  double seconds = std::chrono::duration<double>(stop - start).count();
+  return Iterations / seconds;
+}
+
+}  // namespace
+
+TEST(IterateAlwaysBenchmark, IdleElements) {
+  int pollingReads = 0;
+  int scheduledReads = 0;
+  double polling =
+      measureIterationsPerSecond<PollingSensor>(&iterateOldLoop, &pollingReads);
+  double scheduled = measureIterationsPerSecond<ScheduledSensor>(
+      &iterateScheduledLoop, &scheduledReads);
+
+  // both variants do the same work
+  EXPECT_EQ(pollingReads, scheduledReads);
+
+  printf("%d elements (%d iterated on each loop), %d loop iterations\n",
+         ElementCount,
+         BusyCount,
+         Iterations);
+  printf("%24s %16.0f iterations/s\n", "millis() polling:", polling);
+  printf("%24s %16.0f iterations/s\n", "deadline scheduler:", scheduled);
+}
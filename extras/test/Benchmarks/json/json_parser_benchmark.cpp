@@ -0,0 +1,149 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <linux_event_loop.h>
+#include <supla/parser/json.h>
+#include <supla/source/source.h>
+#include <supla/time.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// This benchmark is linked with Linux port Json parser. It compares DOM and
+// streaming parsing of multi-megabyte JSON document, from which only few
+// values are used (typical inverter/energy meter dump with history).
+
+uint64_t millis() {
+  return 0;
+}
+
+void Supla::Linux::EventLoop::wakeUpIn(uint32_t) {
+}
+
+void Supla::Linux::EventLoop::wakeUp() {
+}
+
+namespace {
+
+class StringSource : public Supla::Source::Source {
+ public:
+  explicit StringSource(std::string content) : content(std::move(content)) {
+  }
+
+  std::string getContent() override {
+    return content;
+  }
+
+  std::string content;
+};
+
+// Builds document with "history" array of historyCount records. Wanted
+// values are placed before and after history.
+std::string buildDocument(int historyCount) {
+  std::string doc;
+  doc.reserve(historyCount * 160);
+  doc += "{\"device\": {\"name\": \"inverter\", \"serial\": \"AB123456\"},";
+  doc += "\"voltage\": 231.5,";
+  doc += "\"inverter\": {\"phases\": [";
+  doc += "{\"voltage\": 230.1, \"current\": 1.25},";
+  doc += "{\"voltage\": 229.8, \"current\": 2.5},";
+  doc += "{\"voltage\": 231.0, \"current\": 3.75}]},";
+  doc += "\"history\": [";
+  char buf[200];
+  for (int i = 0; i < historyCount; i++) {
+    snprintf(buf,
+             sizeof(buf),
+             "%s{\"ts\": %d, \"voltage\": %.2f, \"current\": %.3f, "
+             "\"power\": %d, \"state\": \"ok\", \"flags\": [1, 2, 3]}",
+             i ? "," : "",
+             1650000000 + i,
+             220.0 + (i % 200) / 10.0,
+             (i % 1000) / 100.0,
+             i % 5000);
+    doc += buf;
+  }
+  doc += "],";
+  doc += "\"total_energy\": 12345.678}";
+  return doc;
+}
+
+const int HistoryCount = 40000;
+const int Iterations = 5;
+
+void runBenchmark(const char *name,
+                  bool streaming,
+                  const std::vector<std::string> &keys,
+                  double *results) {
+  StringSource source(buildDocument(HistoryCount));
+  Supla::Parser::Json parser(&source);
+  parser.setStreamingMode(streaming);
+  for (auto &key : keys) {
+    parser.addKey(key, -1);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < Iterations; i++) {
+    ASSERT_TRUE(parser.refreshSource());
+    for (size_t k = 0; k < keys.size(); k++) {
+      results[k] = parser.getValue(keys[k]);
+    }
+    ASSERT_TRUE(parser.isValid());
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+  double mb = source.content.size() * Iterations / (1024.0 * 1024.0);
+  printf("%s (%s): %d x %.2f MB in %.2f ms (%.1f MB/s)\n",
+         name,
+         streaming ? "streaming" : "DOM",
+         Iterations,
+         source.content.size() / (1024.0 * 1024.0),
+         ms,
+         mb * 1000.0 / ms);
+}
+
+void compareModes(const char *name, const std::vector<std::string> &keys) {
+  std::vector<double> dom(keys.size());
+  std::vector<double> streaming(keys.size());
+  runBenchmark(name, false, keys, dom.data());
+  runBenchmark(name, true, keys, streaming.data());
+  for (size_t k = 0; k < keys.size(); k++) {
+    EXPECT_DOUBLE_EQ(dom[k], streaming[k]) << keys[k];
+  }
+}
+
+}  // namespace
+
+TEST(JsonParserBenchmark, KeysAtBeginning) {
+  compareModes("Keys at beginning",
+               {"voltage",
+                "/inverter/phases/0/voltage",
+                "/inverter/phases/1/voltage",
+                "/inverter/phases/2/current"});
+}
+
+TEST(JsonParserBenchmark, KeyAtEnd) {
+  // whole document has to be read, but history array is skipped
+  compareModes("Key at end", {"voltage", "total_energy"});
+}
+
+TEST(JsonParserBenchmark, KeyInsideHistory) {
+  compareModes("Key inside history", {"/history/30000/power"});
+}
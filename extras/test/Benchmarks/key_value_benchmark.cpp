@@ -0,0 +1,115 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <supla/storage/key_value.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+class KeyValueForBenchmark : public Supla::KeyValue {
+ public:
+  bool init() override {
+    return true;
+  }
+  void removeAll() override {
+  }
+
+  // Reference implementation - old linear list scan
+  Supla::KeyValueElement *linearFind(const char *key) {
+    for (auto element = first; element; element = element->getNext()) {
+      if (element->isKeyEqual(key)) {
+        return element;
+      }
+    }
+    return nullptr;
+  }
+};
+
+const int keyCount = 1000;
+
+void makeKey(char *buf, int i, int part) {
+  // similar to keys used by channels config: "<channel>_<param>"
+  snprintf(buf, SUPLA_STORAGE_KEY_SIZE + 1, "%d_param_%d", i, part);
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+}  // namespace
+
+TEST(KeyValueBenchmark, BootWith1000Keys) {
+  std::vector<uint8_t> buffer(64 * 1024);
+  size_t size = 0;
+  {
+    KeyValueForBenchmark kv;
+    char key[SUPLA_STORAGE_KEY_SIZE + 1] = {};
+    for (int i = 0; i < keyCount / 4; i++) {
+      makeKey(key, i, 0);
+      kv.setUInt8(key, i % 256);
+      makeKey(key, i, 1);
+      kv.setInt32(key, i);
+      makeKey(key, i, 2);
+      kv.setString(key, "some config text");
+      makeKey(key, i, 3);
+      kv.setBlob(key, "0123456789abcdef", 16);
+    }
+    size = kv.serializeToMemory(buffer.data(), buffer.size());
+  }
+
+  KeyValueForBenchmark kv;
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(kv.initFromMemory(buffer.data(), size));
+  double initMs = msSince(start);
+
+  // each key is read once, like in Element::onLoadConfig()
+  char key[SUPLA_STORAGE_KEY_SIZE + 1] = {};
+  char text[32] = {};
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < keyCount / 4; i++) {
+    uint8_t u8 = 0;
+    int32_t i32 = 0;
+    makeKey(key, i, 0);
+    ASSERT_TRUE(kv.getUInt8(key, &u8));
+    makeKey(key, i, 1);
+    ASSERT_TRUE(kv.getInt32(key, &i32));
+    makeKey(key, i, 2);
+    ASSERT_TRUE(kv.getString(key, text, sizeof(text)));
+    makeKey(key, i, 3);
+    ASSERT_TRUE(kv.getBlob(key, text, 16));
+  }
+  double indexedMs = msSince(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < keyCount / 4; i++) {
+    for (int part = 0; part < 4; part++) {
+      makeKey(key, i, part);
+      ASSERT_NE(kv.linearFind(key), nullptr);
+    }
+  }
+  double linearMs = msSince(start);
+
+  printf("%d keys, %zu bytes\n", keyCount, size);
+  printf("initFromMemory:          %8.3f ms\n", initMs);
+  printf("lookups with hash index: %8.3f ms\n", indexedMs);
+  printf("lookups with list scan:  %8.3f ms\n", linearMs);
+}
@@ -0,0 +1,102 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <supla/action_handler.h>
+#include <supla/actions.h>
+#include <supla/events.h>
+#include <supla/local_action.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+class CountingHandler : public Supla::ActionHandler {
+ public:
+  void handleAction(int event, int action) override {
+    (void)(event);
+    (void)(action);
+    counter++;
+  }
+  int counter = 0;
+};
+
+// Reference implementation - old scan of global client list
+void runActionWithListScan(Supla::LocalAction *trigger, int event) {
+  auto ptr = Supla::LocalAction::getClientListPtr();
+  while (ptr) {
+    if (ptr->trigger == trigger && ptr->onEvent == event &&
+        ptr->isEnabled()) {
+      ptr->client->handleAction(event, ptr->action);
+    }
+    ptr = ptr->next;
+  }
+}
+
+template <typename Run>
+double measureNsPerEvent(Run run) {
+  const int rounds = 20000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    run();
+  }
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+         rounds;
+}
+
+}  // namespace
+
+TEST(LocalActionBenchmark, RunActionCostVsBindingCount) {
+  CountingHandler handler;
+  // measured trigger has 2 bindings for ON_CHANGE and few for other events
+  Supla::LocalAction measured;
+  measured.addAction(Supla::TURN_ON, handler, Supla::ON_CHANGE);
+  measured.addAction(Supla::TURN_OFF, handler, Supla::ON_CHANGE);
+  measured.addAction(Supla::TOGGLE, handler, Supla::ON_PRESS);
+  measured.addAction(Supla::TOGGLE, handler, Supla::ON_RELEASE);
+
+  std::vector<Supla::LocalAction *> others;
+  printf("%10s %16s %16s\n", "bindings", "index [ns]", "list scan [ns]");
+  int bindings = 4;
+  for (int count : {0, 10, 100, 1000, 5000}) {
+    while (bindings < count) {
+      auto trigger = new Supla::LocalAction;
+      for (int i = 0; i < 5; i++) {
+        trigger->addAction(Supla::TOGGLE, handler, Supla::ON_CHANGE);
+      }
+      others.push_back(trigger);
+      bindings += 5;
+    }
+
+    handler.counter = 0;
+    double indexed = measureNsPerEvent(
+        [&]() { measured.runAction(Supla::ON_CHANGE); });
+    int indexedCounter = handler.counter;
+    handler.counter = 0;
+    double scan = measureNsPerEvent(
+        [&]() { runActionWithListScan(&measured, Supla::ON_CHANGE); });
+    EXPECT_EQ(indexedCounter, handler.counter);
+    printf("%10d %16.2f %16.2f\n", bindings, indexed, scan);
+  }
+
+  for (auto trigger : others) {
+    delete trigger;
+  }
+}
@@ -0,0 +1,217 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <linux_event_loop.h>
+#include <supla/parser/simple.h>
+#include <supla/source/source.h>
+#include <supla/time.h>
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// This benchmark is linked with Linux port Simple parser. It compares it with
+// previous implementation (std::stringstream per line, values kept in
+// std::map) on big tabular text file, from which channels read selected
+// lines.
+
+uint64_t millis() {
+  return 0;
+}
+
+void Supla::Linux::EventLoop::wakeUpIn(uint32_t) {
+}
+
+void Supla::Linux::EventLoop::wakeUp() {
+}
+
+namespace {
+
+class StringSource : public Supla::Source::Source {
+ public:
+  explicit StringSource(std::string content) : content(std::move(content)) {
+  }
+
+  std::string getContent() override {
+    return content;
+  }
+
+  std::string content;
+};
+
+// Previous implementation of Simple parser
+class LegacySimple : public Supla::Parser::Parser {
+ public:
+  explicit LegacySimple(Supla::Source::Source *src)
+      : Supla::Parser::Parser(src) {
+  }
+
+  bool isBasedOnIndex() override {
+    return true;
+  }
+
+  double getValue(const std::string &key) override {
+    int index = keys[key];
+    if (index < 0 || index >= static_cast<int>(values.size())) {
+      valid = false;
+      return 0;
+    }
+
+    return values[index];
+  }
+
+  bool refreshSource() override {
+    std::string sourceContent(source->getCachedContentView());
+
+    if (sourceContent.length() == 0) {
+      valid = false;
+      return false;
+    }
+
+    std::stringstream ss(sourceContent);
+    std::string line;
+    values.clear();
+
+    for (int i = 0; std::getline(ss, line, '\n'); i++) {
+      std::stringstream sline(line);
+      sline >> values[i];
+    }
+
+    valid = true;
+    return true;
+  }
+
+  std::map<int, double> values;
+};
+
+// Builds text with lineCount lines, each with columnCount numbers separated
+// by separator
+std::string buildTable(int lineCount, int columnCount, char separator) {
+  std::string table;
+  table.reserve(lineCount * columnCount * 10);
+  char buf[32];
+  for (int line = 0; line < lineCount; line++) {
+    for (int column = 0; column < columnCount; column++) {
+      snprintf(buf,
+               sizeof(buf),
+               "%s%.3f",
+               column ? (separator == ' ' ? " " : ",") : "",
+               line * 0.5 + column * 0.001);
+      table += buf;
+    }
+    table += "\n";
+  }
+  return table;
+}
+
+const int LineCount = 50000;
+const int Iterations = 5;
+
+template <typename ParserType>
+void runParser(const char *name,
+               ParserType *parser,
+               const std::string &content,
+               const std::vector<std::string> &keys,
+               double *results) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < Iterations; i++) {
+    EXPECT_TRUE(parser->refreshSource());
+    for (size_t k = 0; k < keys.size(); k++) {
+      results[k] = parser->getValue(keys[k]);
+    }
+    EXPECT_TRUE(parser->isValid());
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+  double mb = content.size() * Iterations / (1024.0 * 1024.0);
+  printf("%s: %d x %.2f MB, %zu keys in %.2f ms (%.1f MB/s)\n",
+         name,
+         Iterations,
+         content.size() / (1024.0 * 1024.0),
+         keys.size(),
+         ms,
+         mb * 1000.0 / ms);
+}
+
+// Compares both implementations for keys registered on given lines (first
+// column)
+void compare(const char *name, const std::vector<int> &lines) {
+  StringSource source(buildTable(LineCount, 8, ' '));
+  LegacySimple legacy(&source);
+  Supla::Parser::Simple simple(&source);
+  std::vector<std::string> keys;
+  for (auto line : lines) {
+    keys.push_back(std::to_string(line));
+    legacy.addKey(keys.back(), line);
+    simple.addKey(keys.back(), line);
+  }
+
+  std::vector<double> legacyResults(keys.size());
+  std::vector<double> results(keys.size());
+  std::string title = name;
+  runParser((title + " (legacy)").c_str(),
+            &legacy,
+            source.content,
+            keys,
+            legacyResults.data());
+  runParser(title.c_str(), &simple, source.content, keys, results.data());
+  for (size_t k = 0; k < keys.size(); k++) {
+    EXPECT_DOUBLE_EQ(legacyResults[k], results[k]) << keys[k];
+  }
+}
+
+}  // namespace
+
+TEST(SimpleParserBenchmark, FewLinesAtBeginning) {
+  compare("Few lines at beginning", {0, 1, 5, 10});
+}
+
+TEST(SimpleParserBenchmark, LinesInWholeFile) {
+  std::vector<int> lines;
+  for (int i = 0; i < LineCount; i += LineCount / 200) {
+    lines.push_back(i);
+  }
+  lines.push_back(LineCount - 1);
+  compare("200 lines in whole file", lines);
+}
+
+TEST(SimpleParserBenchmark, CsvColumns) {
+  // hundreds of channels fed from one CSV export
+  StringSource source(buildTable(LineCount, 8, ','));
+  Supla::Parser::Simple simple(&source);
+  simple.setSeparator(',');
+  std::vector<std::string> keys;
+  std::vector<double> expected;
+  for (int line = 0; line < LineCount; line += LineCount / 100) {
+    for (int column = 0; column < 8; column += 2) {
+      keys.push_back(std::to_string(line) + ":" + std::to_string(column));
+      simple.addCellKey(keys.back(), line, column);
+      expected.push_back(line * 0.5 + column * 0.001);
+    }
+  }
+
+  std::vector<double> results(keys.size());
+  runParser("CSV columns", &simple, source.content, keys, results.data());
+  for (size_t k = 0; k < keys.size(); k++) {
+    EXPECT_DOUBLE_EQ(expected[k], results[k]) << keys[k];
+  }
+}
@@ -0,0 +1,224 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <supla-common/srpc.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// This benchmark is linked with real srpc.c (not with srpc mock), so it
+// measures in/out queue handling of the current queue implementation.
+
+namespace {
+
+struct Link {
+  std::vector<char> data;
+  std::vector<size_t> frameSizes;
+  size_t readOffset = 0;
+  size_t readFrame = 0;
+  size_t bytesWritten = 0;
+  bool capture = false;
+};
+
+_supla_int_t linkRead(void *buf, _supla_int_t count, void *userParams) {
+  auto link = reinterpret_cast<Link *>(userParams);
+  size_t left = link->data.size() - link->readOffset;
+  if (left == 0 || link->capture) {
+    return -1;
+  }
+  // data is returned in the same chunks as it was written
+  if (link->readFrame < link->frameSizes.size() &&
+      link->frameSizes[link->readFrame] < left) {
+    left = link->frameSizes[link->readFrame];
+  }
+  link->readFrame++;
+  if (static_cast<size_t>(count) > left) {
+    count = left;
+  }
+  memcpy(buf, link->data.data() + link->readOffset, count);
+  link->readOffset += count;
+  return count;
+}
+
+_supla_int_t linkWrite(void *buf, _supla_int_t count, void *userParams) {
+  auto link = reinterpret_cast<Link *>(userParams);
+  link->bytesWritten += count;
+  if (link->capture) {
+    auto ptr = reinterpret_cast<char *>(buf);
+    link->data.insert(link->data.end(), ptr, ptr + count);
+    link->frameSizes.push_back(count);
+  }
+  return count;
+}
+
+unsigned _supla_int_t lastReceivedRrId = 0;
+int receivedCount = 0;
+
+void onRemoteCall(void *srpc,
+                  unsigned _supla_int_t rrId,
+                  unsigned _supla_int_t callType,
+                  void *userParams,
+                  unsigned char protoVersion) {
+  (void)(srpc);
+  (void)(callType);
+  (void)(userParams);
+  (void)(protoVersion);
+  lastReceivedRrId = rrId;
+  receivedCount++;
+}
+
+void *createSrpc(Link *link) {
+  TsrpcParams params;
+  srpc_params_init(&params);
+  params.data_read = &linkRead;
+  params.data_write = &linkWrite;
+  params.on_remote_call_received = &onRemoteCall;
+  params.user_params = link;
+  return srpc_init(&params);
+}
+
+// Keeps this many packets in queue, so queue operations are not done on
+// empty queue only
+const int QueueFill = 4;
+const int PacketCount = 100000;
+
+}  // namespace
+
+TEST(SrpcQueueBenchmark, OutQueue) {
+  Link link;
+  void *srpc = createSrpc(&link);
+  ASSERT_NE(srpc, nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < PacketCount; i++) {
+    ASSERT_NE(srpc_dcs_async_ping_server(srpc), 0);
+    if (srpc_out_queue_item_count(srpc) >= QueueFill) {
+      ASSERT_EQ(srpc_iterate(srpc), SUPLA_RESULT_TRUE);
+    }
+  }
+  while (srpc_out_queue_item_count(srpc) > 0 ||
+         srpc_output_dataexists(srpc) == SUPLA_RESULT_TRUE) {
+    ASSERT_EQ(srpc_iterate(srpc), SUPLA_RESULT_TRUE);
+  }
+  auto stop = std::chrono::steady_clock::now();
+  srpc_free(srpc);
+
+  size_t packetSize = sizeof(TSuplaDataPacket) - SUPLA_MAX_DATA_SIZE +
+                      sizeof(TDCS_SuplaPingServer) + SUPLA_TAG_SIZE;
+  EXPECT_EQ(link.bytesWritten, packetSize * PacketCount);
+  double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+  printf("Out queue (%s): %d packets in %.2f ms (%.0f packets/s)\n",
+#ifdef SRPC_QUEUE_WITHOUT_RING_BUFFER
+         "legacy",
+#else
+         "ring buffer",
+#endif
+         PacketCount,
+         ms,
+         PacketCount * 1000.0 / ms);
+}
+
+TEST(SrpcQueueBenchmark, OutSinglePacket) {
+  // typical device traffic: single packet is sent and written out before
+  // next one is created
+  Link link;
+  void *srpc = createSrpc(&link);
+  ASSERT_NE(srpc, nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < PacketCount; i++) {
+    ASSERT_NE(srpc_dcs_async_ping_server(srpc), 0);
+    ASSERT_EQ(srpc_iterate(srpc), SUPLA_RESULT_TRUE);
+  }
+  auto stop = std::chrono::steady_clock::now();
+  srpc_free(srpc);
+
+  size_t packetSize = sizeof(TSuplaDataPacket) - SUPLA_MAX_DATA_SIZE +
+                      sizeof(TDCS_SuplaPingServer) + SUPLA_TAG_SIZE;
+  EXPECT_EQ(link.bytesWritten, packetSize * PacketCount);
+  double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+  printf("Single packet out (%s): %d packets in %.2f ms (%.0f packets/s)\n",
+#ifdef SRPC_QUEUE_WITHOUT_RING_BUFFER
+         "legacy",
+#else
+         "ring buffer",
+#endif
+         PacketCount,
+         ms,
+         PacketCount * 1000.0 / ms);
+}
+
+TEST(SrpcQueueBenchmark, InQueue) {
+  // prepare byte stream with packets from "server"
+  Link serverLink;
+  serverLink.capture = true;
+  void *server = createSrpc(&serverLink);
+  ASSERT_NE(server, nullptr);
+  for (int i = 0; i < PacketCount; i++) {
+    ASSERT_NE(srpc_sdc_async_ping_server_result(server), 0);
+    ASSERT_EQ(srpc_iterate(server), SUPLA_RESULT_TRUE);
+  }
+  srpc_free(server);
+
+  Link link;
+  link.data = serverLink.data;
+  link.frameSizes = serverLink.frameSizes;
+  void *srpc = createSrpc(&link);
+  ASSERT_NE(srpc, nullptr);
+
+  receivedCount = 0;
+  int popped = 0;
+  std::vector<unsigned _supla_int_t> rrIds;
+  TsrpcReceivedData rd;
+
+  auto start = std::chrono::steady_clock::now();
+  while (popped < PacketCount) {
+    char result = srpc_iterate(srpc);
+    ASSERT_EQ(result, SUPLA_RESULT_TRUE);
+    if (static_cast<int>(rrIds.size()) < receivedCount - popped) {
+      rrIds.push_back(lastReceivedRrId);
+    }
+    if (rrIds.size() >= QueueFill || link.readOffset == link.data.size()) {
+      // pop newest packet first by rr_id, then the rest from queue head
+      ASSERT_EQ(srpc_getdata(srpc, &rd, rrIds.back()), SUPLA_RESULT_TRUE);
+      srpc_rd_free(&rd);
+      popped++;
+      for (size_t i = 0; i + 1 < rrIds.size(); i++) {
+        ASSERT_EQ(srpc_getdata(srpc, &rd, 0), SUPLA_RESULT_TRUE);
+        srpc_rd_free(&rd);
+        popped++;
+      }
+      rrIds.clear();
+    }
+  }
+  auto stop = std::chrono::steady_clock::now();
+  srpc_free(srpc);
+
+  EXPECT_EQ(popped, PacketCount);
+  double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+  printf("In queue (%s): %d packets in %.2f ms (%.0f packets/s)\n",
+#ifdef SRPC_QUEUE_WITHOUT_RING_BUFFER
+         "legacy",
+#else
+         "ring buffer",
+#endif
+         PacketCount,
+         ms,
+         PacketCount * 1000.0 / ms);
+}
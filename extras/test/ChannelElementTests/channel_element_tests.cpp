@@ -21,6 +21,7 @@
 #include <supla/actions.h>
 #include <supla/action_handler.h>
 #include <supla/condition.h>
+#include <supla/sensor/thermometer.h>
 
 
 class ActionHandlerMock : public Supla::ActionHandler {
@@ -85,3 +86,26 @@ TEST(ChannelElementTests, ActionDelegationToConditions) {
 }
 
 
+
+class ChannelElementWithPeriodicWork : public Supla::Sensor::Thermometer {
+ public:
+  ChannelElementWithPeriodicWork() {
+    useChannelUpdateIteration(false);
+  }
+};
+
+TEST(ChannelElementTests, IterationOnlyOnChannelUpdateIsOptIn) {
+  // custom ChannelElement may do periodic work in iterateConnected()
+  Supla::ChannelElement element;
+  EXPECT_FALSE(element.isIteratedOnlyOnChannelUpdate());
+
+  Supla::Sensor::Thermometer thermometer;
+  EXPECT_TRUE(thermometer.isIteratedOnlyOnChannelUpdate());
+
+  ChannelElementWithPeriodicWork periodic;
+  EXPECT_FALSE(periodic.isIteratedOnlyOnChannelUpdate());
+
+  EXPECT_EQ(Supla::Element::beginPeriodicIterate(), &element);
+  EXPECT_EQ(element.nextPeriodicIterate(), &periodic);
+  EXPECT_EQ(periodic.nextPeriodicIterate(), nullptr);
+}
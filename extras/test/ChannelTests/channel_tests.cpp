@@ -510,3 +510,49 @@ TEST(ChannelTests, SetNewValueWithCorrection) {
 
   Supla::Correction::clear(); // cleanup
 }
+
+TEST(ChannelTests, PendingUpdatesList) {
+  EXPECT_EQ(Supla::Channel::getFirstPendingUpdate(), nullptr);
+
+  {
+    Supla::Channel channel1;
+    Supla::Channel channel2;
+    Supla::Channel channel3;
+
+    EXPECT_EQ(Supla::Channel::getFirstPendingUpdate(), nullptr);
+
+    channel2.setNewValue(true);
+    channel1.setNewValue(true);
+    // second change of the same channel doesn't add it again
+    channel2.setNewValue(false);
+    channel3.requestChannelConfig();
+
+    EXPECT_EQ(Supla::Channel::getFirstPendingUpdate(), &channel2);
+    EXPECT_EQ(channel2.getNextPendingUpdate(), &channel1);
+    EXPECT_EQ(channel1.getNextPendingUpdate(), &channel3);
+    EXPECT_EQ(channel3.getNextPendingUpdate(), nullptr);
+
+    // nothing was sent, so nothing is removed
+    Supla::Channel::removeSentPendingUpdates();
+    EXPECT_EQ(Supla::Channel::getFirstPendingUpdate(), &channel2);
+
+    channel1.clearUpdateReady();
+    Supla::Channel::removeSentPendingUpdates();
+    EXPECT_EQ(Supla::Channel::getFirstPendingUpdate(), &channel2);
+    EXPECT_EQ(channel2.getNextPendingUpdate(), &channel3);
+    EXPECT_EQ(channel3.getNextPendingUpdate(), nullptr);
+
+    channel2.clearUpdateReady();
+    Supla::Channel::removeSentPendingUpdates();
+    EXPECT_EQ(Supla::Channel::getFirstPendingUpdate(), &channel3);
+
+    // channel is added at the end of the list
+    channel1.setNewValue(false);
+    EXPECT_EQ(channel3.getNextPendingUpdate(), &channel1);
+    EXPECT_EQ(channel1.getNextPendingUpdate(), nullptr);
+
+    // channel3 and channel1 are removed from list in destructors
+  }
+
+  EXPECT_EQ(Supla::Channel::getFirstPendingUpdate(), nullptr);
+}
@@ -0,0 +1,198 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <arduino_mock.h>
+#include <srpc_mock.h>
+#include <supla/channel.h>
+
+using ::testing::_;
+
+namespace {
+
+class FakeTime : public TimeInterface {
+ public:
+  uint64_t millis() override {
+    return value;
+  }
+
+  uint64_t value = 1000;
+};
+
+}  // namespace
+
+TEST(UplinkFilterTests, ChannelWithoutFilterSendsEachChange) {
+  FakeTime time;
+  SrpcMock srpc;
+  Supla::Channel channel;
+  channel.setType(SUPLA_CHANNELTYPE_THERMOMETER);
+
+  EXPECT_CALL(srpc, valueChanged(_, _, _, _, _)).Times(2);
+
+  channel.setNewValue(21.0);
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+  channel.setNewValue(21.01);
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+
+  EXPECT_EQ(channel.getUplinkSentCount(), 0);
+  EXPECT_EQ(channel.getUplinkSuppressedCount(), 0);
+}
+
+TEST(UplinkFilterTests, AbsoluteDeadband) {
+  FakeTime time;
+  SrpcMock srpc;
+  Supla::Channel channel;
+  channel.setType(SUPLA_CHANNELTYPE_THERMOMETER);
+  channel.setUplinkDeadband(0.5);
+
+  EXPECT_CALL(srpc, valueChanged(_, _, _, _, _)).Times(3);
+
+  // first value is always sent
+  channel.setNewValue(21.0);
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+
+  channel.setNewValue(21.2);
+  EXPECT_FALSE(channel.isUpdateReady());
+  channel.setNewValue(20.6);
+  EXPECT_FALSE(channel.isUpdateReady());
+  // local value is updated anyway
+  EXPECT_DOUBLE_EQ(channel.getValueDouble(), 20.6);
+
+  channel.setNewValue(21.6);
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+  EXPECT_FALSE(channel.isUpdateReady());
+
+  channel.setNewValue(21.3);
+  EXPECT_FALSE(channel.isUpdateReady());
+  channel.setNewValue(21.0);
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+
+  EXPECT_EQ(channel.getUplinkSentCount(), 3);
+  EXPECT_EQ(channel.getUplinkSuppressedCount(), 3);
+}
+
+TEST(UplinkFilterTests, RelativeDeadbandForTwoValues) {
+  FakeTime time;
+  SrpcMock srpc;
+  Supla::Channel channel;
+  channel.setType(SUPLA_CHANNELTYPE_HUMIDITYANDTEMPSENSOR);
+  // 10 %
+  channel.setUplinkDeadband(10, true);
+
+  EXPECT_CALL(srpc, valueChanged(_, _, _, _, _)).Times(3);
+
+  channel.setNewValue(20.0, 50.0);
+  channel.sendUpdate(nullptr);
+
+  channel.setNewValue(21.9, 54.0);
+  EXPECT_FALSE(channel.isUpdateReady());
+
+  // humidity changed above 10 %
+  channel.setNewValue(20.0, 56.0);
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+
+  // temperature changed above 10 %
+  channel.setNewValue(17.0, 56.0);
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+}
+
+TEST(UplinkFilterTests, MinIntervalSendsLatestValue) {
+  FakeTime time;
+  SrpcMock srpc;
+  Supla::Channel channel;
+  channel.setType(SUPLA_CHANNELTYPE_THERMOMETER);
+  channel.setUplinkMinIntervalMs(5000);
+
+  char expected[SUPLA_CHANNELVALUE_SIZE] = {};
+  double latest = 23.0;
+  memcpy(expected, &latest, sizeof(latest));
+
+  EXPECT_CALL(srpc, valueChanged(_, _, _, _, _));
+  EXPECT_CALL(srpc,
+              valueChanged(_, _, ::testing::ElementsAreArray(expected), _, _));
+
+  channel.setNewValue(21.0);
+  channel.sendUpdate(nullptr);
+
+  time.value += 1000;
+  channel.setNewValue(22.0);
+  EXPECT_FALSE(channel.isUpdateReady());
+  time.value += 1000;
+  channel.setNewValue(23.0);
+  EXPECT_FALSE(channel.isUpdateReady());
+
+  // channel has to stay on pending updates list until value is sent
+  Supla::Channel::removeSentPendingUpdates();
+  bool found = false;
+  for (auto ch = Supla::Channel::getFirstPendingUpdate(); ch != nullptr;
+       ch = ch->getNextPendingUpdate()) {
+    if (ch == &channel) {
+      found = true;
+    }
+  }
+  EXPECT_TRUE(found);
+
+  time.value += 3000;
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+  EXPECT_FALSE(channel.isUpdateReady());
+
+  EXPECT_EQ(channel.getUplinkSentCount(), 2);
+  EXPECT_EQ(channel.getUplinkSuppressedCount(), 1);
+}
+
+TEST(UplinkFilterTests, HeartbeatSendsUnchangedValue) {
+  FakeTime time;
+  SrpcMock srpc;
+  Supla::Channel channel;
+  channel.setType(SUPLA_CHANNELTYPE_THERMOMETER);
+  channel.setUplinkDeadband(1);
+  channel.setUplinkHeartbeatMs(60000);
+
+  EXPECT_CALL(srpc, valueChanged(_, _, _, _, _)).Times(3);
+
+  channel.setNewValue(21.0);
+  channel.sendUpdate(nullptr);
+
+  time.value += 30000;
+  channel.setNewValue(21.5);
+  EXPECT_FALSE(channel.isUpdateReady());
+
+  // heartbeat sends value which was held back by deadband
+  time.value += 30000;
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+  EXPECT_FALSE(channel.isUpdateReady());
+
+  // and then it is sent again without any change
+  time.value += 59999;
+  EXPECT_FALSE(channel.isUpdateReady());
+  time.value += 1;
+  EXPECT_TRUE(channel.isUpdateReady());
+  channel.sendUpdate(nullptr);
+
+  EXPECT_EQ(channel.getUplinkSentCount(), 3);
+  EXPECT_EQ(channel.getUplinkSuppressedCount(), 0);
+}
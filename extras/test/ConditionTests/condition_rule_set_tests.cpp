@@ -0,0 +1,149 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <supla/condition.h>
+#include <supla/condition_getter.h>
+#include <supla/condition_rule_set.h>
+#include <supla/channel_element.h>
+#include <supla/events.h>
+#include <supla/sensor/electricity_meter.h>
+
+using ::testing::InSequence;
+
+namespace {
+
+class RuleSetActionHandlerMock : public Supla::ActionHandler {
+ public:
+  MOCK_METHOD(void, handleAction, (int, int), (override));
+  MOCK_METHOD(void, activateAction, (int), (override));
+};
+
+class CountingGetter : public Supla::ConditionGetter {
+ public:
+  CountingGetter(double *value, int *readCount, uint16_t valueId)
+      : value(value), readCount(readCount), valueId(valueId) {
+  }
+
+  double getValue(Supla::Element *, bool *isValid) override {
+    (*readCount)++;
+    *isValid = true;
+    return *value;
+  }
+
+  uint16_t getValueId() const override {
+    return valueId;
+  }
+
+ protected:
+  double *value;
+  int *readCount;
+  uint16_t valueId;
+};
+
+}  // namespace
+
+TEST(ConditionRuleSetTests, SharedValueIsReadOncePerChange) {
+  RuleSetActionHandlerMock ahMock;
+  EXPECT_CALL(ahMock, activateAction).Times(5);
+
+  double value = 0;
+  int sharedReads = 0;
+  int privateReads = 0;
+
+  Supla::ChannelElement element;
+  element.addAction(1, ahMock, OnLess(10, new CountingGetter(
+          &value, &sharedReads, 0x42)));
+  element.addAction(2, ahMock, OnLess(20, new CountingGetter(
+          &value, &sharedReads, 0x42)));
+  element.addAction(3, ahMock, OnGreater(30, new CountingGetter(
+          &value, &sharedReads, 0x42)));
+  // getters with id 0 are always read separately
+  element.addAction(4, ahMock, OnLess(40, new CountingGetter(
+          &value, &privateReads, 0)));
+  element.addAction(5, ahMock, OnLess(50, new CountingGetter(
+          &value, &privateReads, 0)));
+
+  EXPECT_CALL(ahMock, handleAction(Supla::ON_CHANGE, 1));
+  EXPECT_CALL(ahMock, handleAction(Supla::ON_CHANGE, 2));
+  EXPECT_CALL(ahMock, handleAction(Supla::ON_CHANGE, 4));
+  EXPECT_CALL(ahMock, handleAction(Supla::ON_CHANGE, 5));
+
+  value = 5;
+  element.getChannel()->setNewValue(1.0);
+  EXPECT_EQ(sharedReads, 1);
+  EXPECT_EQ(privateReads, 2);
+
+  // value still below thresholds, so actions are not repeated
+  value = 6;
+  element.getChannel()->setNewValue(2.0);
+  EXPECT_EQ(sharedReads, 2);
+  EXPECT_EQ(privateReads, 4);
+
+  EXPECT_CALL(ahMock, handleAction(Supla::ON_CHANGE, 3));
+  value = 35;
+  element.getChannel()->setNewValue(3.0);
+  EXPECT_EQ(sharedReads, 3);
+  EXPECT_EQ(privateReads, 6);
+}
+
+TEST(ConditionRuleSetTests, ConditionsForSameValueKeepOrderOfAdding) {
+  RuleSetActionHandlerMock ahMock;
+  EXPECT_CALL(ahMock, activateAction).Times(4);
+
+  Supla::Sensor::ElectricityMeter em;
+  em.addAction(1, ahMock, OnLess(220.0, EmVoltage(1)));
+  em.addAction(2, ahMock, OnLess(230.0, EmVoltage(0)));
+  em.addAction(3, ahMock, OnLess(220.0, EmVoltage(0)));
+  em.addAction(4, ahMock, OnLess(240.0, EmVoltage(1)));
+
+  {
+    InSequence seq;
+    // phase 1 (id of EmVoltage(0)) conditions go first
+    EXPECT_CALL(ahMock, handleAction(Supla::ON_CHANGE, 2));
+    EXPECT_CALL(ahMock, handleAction(Supla::ON_CHANGE, 3));
+    EXPECT_CALL(ahMock, handleAction(Supla::ON_CHANGE, 1));
+    EXPECT_CALL(ahMock, handleAction(Supla::ON_CHANGE, 4));
+  }
+
+  em.setVoltage(0, 250.0 * 100);
+  em.setVoltage(1, 250.0 * 100);
+  em.updateChannelValues();
+
+  em.setVoltage(0, 210.0 * 100);
+  em.setVoltage(1, 210.0 * 100);
+  em.updateChannelValues();
+}
+
+TEST(ConditionRuleSetTests, AddConditionCreatesSingleRuleSet) {
+  RuleSetActionHandlerMock ahMock;
+  EXPECT_CALL(ahMock, activateAction).Times(20);
+
+  Supla::ChannelElement element;
+  Supla::ConditionRuleSet *ruleSet = nullptr;
+  for (int i = 0; i < 20; i++) {
+    auto cond = OnLess(i);
+    cond->setClient(ahMock);
+    cond->setSource(element);
+    Supla::ConditionRuleSet::addCondition(
+        &ruleSet, element.getChannel(), i, cond, false);
+  }
+  ASSERT_NE(ruleSet, nullptr);
+  EXPECT_EQ(ruleSet->getConditionCount(), 20);
+  EXPECT_TRUE(element.getChannel()->isEventAlreadyUsed(Supla::ON_CHANGE));
+}
@@ -23,6 +23,7 @@
 
 using ::testing::Return;
 using ::testing::ElementsAreArray;
+using ::testing::UnorderedElementsAre;
 
 class ElementTests : public ::testing::Test {
   protected:
@@ -205,3 +206,176 @@ TEST_F(ElementTests, ChannelElementMethods) {
 
 
 
+
+TEST_F(ElementTests, GetElementByChannelNumberFollowsListChanges) {
+  auto el1 = new ElementWithChannel;
+  auto noChannel = new Supla::Element;
+  auto el2 = new ElementWithChannel;
+
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(0), el1);
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(1), el2);
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(2), nullptr);
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(-1), noChannel);
+  EXPECT_EQ(
+      Supla::Element::getElementByChannelNumber(SUPLA_CHANNELMAXCOUNT),
+      nullptr);
+
+  // element added after lookup has to be visible
+  auto el3 = new ElementWithChannel;
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(2), el3);
+
+  // removed element can't be returned anymore
+  delete el1;
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(0), nullptr);
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(1), el2);
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(2), el3);
+
+  delete el3;
+  delete noChannel;
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(-1), nullptr);
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(1), el2);
+
+  delete el2;
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(1), nullptr);
+  EXPECT_EQ(Supla::Element::begin(), nullptr);
+}
+
+class ElementWithTwoChannels : public ElementWithChannel {
+  public:
+    Supla::Channel *getSecondaryChannel() {
+      return &secondaryChannel;
+    }
+    bool isIteratedOnlyOnChannelUpdate() override {
+      return true;
+    }
+    Supla::Channel secondaryChannel;
+};
+
+TEST_F(ElementTests, ChannelOwnersAndPeriodicIterateList) {
+  ElementWithTwoChannels el1;
+  Supla::Element noChannel;
+  ElementWithChannel el2;
+
+  EXPECT_EQ(el1.getChannelNumber(), 0);
+  EXPECT_EQ(el1.secondaryChannel.getChannelNumber(), 1);
+  EXPECT_EQ(el2.getChannelNumber(), 2);
+
+  EXPECT_EQ(Supla::Element::getOwnerOfChannel(0), &el1);
+  EXPECT_EQ(Supla::Element::getOwnerOfChannel(1), &el1);
+  EXPECT_EQ(Supla::Element::getOwnerOfChannel(2), &el2);
+  EXPECT_EQ(Supla::Element::getOwnerOfChannel(3), nullptr);
+  EXPECT_EQ(Supla::Element::getOwnerOfChannel(-1), nullptr);
+  // secondary channel is not used for server requests routing
+  EXPECT_EQ(Supla::Element::getElementByChannelNumber(1), nullptr);
+
+  // el1 is iterated only when its channels have pending updates
+  EXPECT_EQ(Supla::Element::beginPeriodicIterate(), &noChannel);
+  EXPECT_EQ(noChannel.nextPeriodicIterate(), &el2);
+  EXPECT_EQ(el2.nextPeriodicIterate(), nullptr);
+}
+
+class ElementWithDeadline : public Supla::Element {
+  public:
+    bool isIteratedAlwaysOnDeadline() override {
+      return true;
+    }
+    void schedule(uint64_t deadlineMs) {
+      scheduleIterateAlways(deadlineMs);
+    }
+    void cancel() {
+      cancelIterateAlways();
+    }
+};
+
+TEST_F(ElementTests, IterateAlwaysDeadlines) {
+  Supla::Element always;
+  ElementWithDeadline el1;
+  ElementWithDeadline el2;
+  uint64_t deadline = 0;
+
+  EXPECT_EQ(Supla::Element::beginAlwaysIterate(), &always);
+  EXPECT_EQ(always.nextAlwaysIterate(), nullptr);
+
+  // new elements are iterated once
+  auto due = Supla::Element::takeDueElements(0);
+  EXPECT_EQ(due, &el1);
+  EXPECT_EQ(due->nextDue(), &el2);
+  EXPECT_EQ(el2.nextDue(), nullptr);
+  EXPECT_FALSE(Supla::Element::getNextDeadline(&deadline));
+  EXPECT_EQ(Supla::Element::takeDueElements(1000), nullptr);
+
+  el1.schedule(500);
+  el2.schedule(300);
+  // earlier deadline is kept
+  el1.schedule(700);
+  EXPECT_TRUE(Supla::Element::getNextDeadline(&deadline));
+  EXPECT_EQ(deadline, 300);
+  el1.schedule(200);
+  EXPECT_TRUE(Supla::Element::getNextDeadline(&deadline));
+  EXPECT_EQ(deadline, 200);
+
+  EXPECT_EQ(Supla::Element::takeDueElements(199), nullptr);
+  EXPECT_EQ(Supla::Element::takeDueElements(250), &el1);
+  EXPECT_EQ(el1.nextDue(), nullptr);
+
+  el1.schedule(400);
+  el2.cancel();
+  EXPECT_EQ(Supla::Element::takeDueElements(350), nullptr);
+  EXPECT_EQ(Supla::Element::takeDueElements(400), &el1);
+  EXPECT_FALSE(Supla::Element::getNextDeadline(&deadline));
+
+  {
+    ElementWithDeadline el3;
+    // elements list changed, so all not scheduled elements are iterated once
+    std::vector<Supla::Element *> dueList;
+    for (due = Supla::Element::takeDueElements(500); due != nullptr;
+         due = due->nextDue()) {
+      dueList.push_back(due);
+    }
+    EXPECT_THAT(dueList, UnorderedElementsAre(&el1, &el2, &el3));
+    el3.schedule(1000);
+    el2.schedule(2000);
+  }
+  // removed element is dropped from scheduler
+  EXPECT_TRUE(Supla::Element::getNextDeadline(&deadline));
+  EXPECT_EQ(deadline, 2000);
+  el2.cancel();
+}
+
+class ElementWithDeadlineScheduling : public Supla::Element {
+  public:
+    ElementWithDeadlineScheduling() {
+      useDeadlineScheduling();
+    }
+    void schedule(uint64_t deadlineMs) {
+      scheduleIterateAlways(deadlineMs);
+    }
+};
+
+class DerivedIteratedOnEachLoop : public ElementWithDeadlineScheduling {
+  public:
+    DerivedIteratedOnEachLoop() {
+      useDeadlineScheduling(false);
+    }
+};
+
+TEST_F(ElementTests, DeadlineSchedulingOptOut) {
+  ElementWithDeadlineScheduling onDeadline;
+  DerivedIteratedOnEachLoop derived;
+  uint64_t deadline = 0;
+
+  EXPECT_TRUE(onDeadline.isIteratedAlwaysOnDeadline());
+  EXPECT_FALSE(derived.isIteratedAlwaysOnDeadline());
+  EXPECT_EQ(Supla::Element::beginAlwaysIterate(), &derived);
+  EXPECT_EQ(derived.nextAlwaysIterate(), nullptr);
+  EXPECT_EQ(Supla::Element::takeDueElements(0), &onDeadline);
+  EXPECT_EQ(onDeadline.nextDue(), nullptr);
+
+  // element iterated on each loop doesn't get scheduled
+  derived.schedule(100);
+  EXPECT_FALSE(Supla::Element::getNextDeadline(&deadline));
+  onDeadline.schedule(100);
+  EXPECT_TRUE(Supla::Element::getNextDeadline(&deadline));
+  EXPECT_EQ(deadline, 100);
+  EXPECT_EQ(Supla::Element::takeDueElements(100), &onDeadline);
+}
@@ -169,6 +169,10 @@ TEST(InternalPinOutputTests, TurnOnWithDuration) {
   ipo.iterateAlways();
 
   ipo.turnOn(200);
+  // iterateAlways() is scheduled when duration expires
+  uint64_t deadline = 0;
+  EXPECT_TRUE(Supla::Element::getNextDeadline(&deadline));
+  EXPECT_EQ(deadline, 201);
   ipo.iterateAlways(); // time 0
   ipo.iterateAlways(); // time 100
   ipo.iterateAlways(); // time 200
@@ -0,0 +1,366 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <arduino_mock.h>
+#include <linux_client.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <filesystem>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+namespace {
+
+class SimpleTime : public TimeInterface {
+ public:
+  uint64_t millis() override {
+    return value;
+  }
+
+  uint64_t value = 1000;
+};
+
+// Listening socket on loopback. Connections are completed by kernel, but
+// never accepted, so peer doesn't send anything.
+class TcpServer {
+ public:
+  explicit TcpServer(int backlog = 8) {
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), len) != 0 ||
+        listen(fd, backlog) != 0 ||
+        getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len) !=
+            0) {
+      ADD_FAILURE() << "server setup failed";
+    }
+    port = ntohs(addr.sin_port);
+  }
+
+  ~TcpServer() {
+    close(fd);
+  }
+
+  int fd = -1;
+  uint16_t port = 0;
+};
+
+// Server which completes TCP connection, but its accept queue is full, so
+// next connect stays in progress
+class StalledServer : public TcpServer {
+ public:
+  StalledServer() : TcpServer(0) {
+    filler = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(filler, reinterpret_cast<struct sockaddr *>(&addr),
+                sizeof(addr)) != 0) {
+      ADD_FAILURE() << "filler connect failed";
+    }
+  }
+
+  ~StalledServer() {
+    close(filler);
+  }
+
+  int filler = -1;
+};
+
+// Returns port on which nothing listens
+uint16_t getClosedPort() {
+  TcpServer server;
+  return server.port;
+}
+
+// Builds list of loopback addresses with given ports, as returned by DNS
+struct addrinfo *makeAddresses(std::initializer_list<uint16_t> ports) {
+  struct addrinfo *result = nullptr;
+  struct addrinfo **last = &result;
+  for (auto port : ports) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    struct addrinfo *address = nullptr;
+    EXPECT_EQ(getaddrinfo(
+                  "127.0.0.1", std::to_string(port).c_str(), &hints, &address),
+              0);
+    // glibc releases each node separately, so lists can be joined
+    *last = address;
+    while (*last) {
+      last = &(*last)->ai_next;
+    }
+  }
+  return result;
+}
+
+class LinuxClientForTest : public Supla::LinuxClient {
+ public:
+  // Starts connect to given addresses, as if they were resolved for
+  // host:port. Following connect(host, port) calls continue it.
+  bool startConnect(struct addrinfo *list, const char *host, uint16_t port) {
+    strncpy(this->host, host, sizeof(this->host) - 1);
+    this->port = port;
+    addresses = list;
+    nextAddress = list;
+    return startTcpConnect(0);
+  }
+
+  bool isTlsHandshake() const {
+    return state == ConnectState::TlsHandshake;
+  }
+};
+
+// Calls non-blocking connect until it is finished. Returns last connect()
+// result.
+int connectUntilDone(Supla::LinuxClient *client,
+                     const char *host,
+                     uint16_t port) {
+  auto start = std::chrono::steady_clock::now();
+  int result = 0;
+  do {
+    result = client->connect(host, port);
+    if (result == 1 || !client->isConnecting()) {
+      return result;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  } while (std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+  ADD_FAILURE() << "connect didn't finish";
+  return result;
+}
+
+class LinuxClientTests : public ::testing::Test {
+ protected:
+  SimpleTime time;
+};
+
+}  // namespace
+
+TEST_F(LinuxClientTests, NonBlockingConnectWithoutTls) {
+  TcpServer server;
+  LinuxClientForTest client;
+  client.setNonBlockingConnect(true);
+
+  EXPECT_FALSE(client.isConnecting());
+  EXPECT_EQ(connectUntilDone(&client, "127.0.0.1", server.port), 1);
+  EXPECT_FALSE(client.isConnecting());
+  EXPECT_TRUE(client.connected());
+
+  client.stop();
+  EXPECT_FALSE(client.connected());
+  EXPECT_FALSE(client.isConnecting());
+}
+
+TEST_F(LinuxClientTests, RefusedAddressFallsBackToNextAddress) {
+  TcpServer server;
+  LinuxClientForTest client;
+  client.setNonBlockingConnect(true);
+
+  ASSERT_TRUE(client.startConnect(
+      makeAddresses({getClosedPort(), server.port}), "server", 2016));
+  EXPECT_EQ(connectUntilDone(&client, "server", 2016), 1);
+  EXPECT_TRUE(client.connected());
+}
+
+TEST_F(LinuxClientTests, ConnectFailsWhenAllAddressesAreRefused) {
+  LinuxClientForTest client;
+  client.setNonBlockingConnect(true);
+
+  if (client.startConnect(
+          makeAddresses({getClosedPort(), getClosedPort()}), "server", 2016)) {
+    EXPECT_EQ(connectUntilDone(&client, "server", 2016), 0);
+  }
+  EXPECT_FALSE(client.isConnecting());
+  EXPECT_FALSE(client.connected());
+}
+
+TEST_F(LinuxClientTests, TcpConnectTimeoutFallsBackToNextAddress) {
+  StalledServer stalled;
+  TcpServer server;
+  LinuxClientForTest client;
+  client.setNonBlockingConnect(true);
+  client.setTimeoutMs(500);
+
+  ASSERT_TRUE(client.startConnect(
+      makeAddresses({stalled.port, server.port}), "server", 2016));
+  EXPECT_EQ(client.connect("server", 2016), 0);
+  EXPECT_TRUE(client.isConnecting());
+
+  time.value += 499;
+  EXPECT_EQ(client.connect("server", 2016), 0);
+  EXPECT_TRUE(client.isConnecting());
+
+  // timeout of the first address - next one is tried
+  time.value += 1;
+  EXPECT_EQ(connectUntilDone(&client, "server", 2016), 1);
+  EXPECT_TRUE(client.connected());
+}
+
+TEST_F(LinuxClientTests, TlsHandshakeTimeout) {
+  // server completes TCP connection, but never answers TLS ClientHello
+  TcpServer server;
+  LinuxClientForTest client;
+  client.setNonBlockingConnect(true);
+  client.setSSLEnabled(true);
+  client.setTimeoutMs(500);
+
+  ASSERT_TRUE(
+      client.startConnect(makeAddresses({server.port}), "server", 2016));
+  auto start = std::chrono::steady_clock::now();
+  while (!client.isTlsHandshake() &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+    EXPECT_EQ(client.connect("server", 2016), 0);
+  }
+  ASSERT_TRUE(client.isTlsHandshake());
+
+  time.value += 499;
+  EXPECT_EQ(client.connect("server", 2016), 0);
+  EXPECT_TRUE(client.isConnecting());
+
+  time.value += 1;
+  EXPECT_EQ(client.connect("server", 2016), 0);
+  EXPECT_FALSE(client.isConnecting());
+  EXPECT_FALSE(client.connected());
+}
+
+namespace {
+
+// TLS 1.2 server with self-signed certificate, which handles given number of
+// connections on its own thread. TLS 1.2 is used, so client gets session
+// during handshake.
+class TlsServer : public TcpServer {
+ public:
+  explicit TlsServer(int connections) {
+    key = EVP_EC_gen("P-256");
+    cert = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name,
+                               "CN",
+                               MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char *>("test"),
+                               -1,
+                               -1,
+                               0);
+    X509_set_issuer_name(cert, name);
+    X509_sign(cert, key, EVP_sha256());
+
+    ctx = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_use_certificate(ctx, cert);
+    SSL_CTX_use_PrivateKey(ctx, key);
+
+    worker = std::thread([this, connections]() {
+      for (int i = 0; i < connections; i++) {
+        int connection = accept(fd, nullptr, nullptr);
+        if (connection < 0) {
+          return;
+        }
+        SSL *ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, connection);
+        if (SSL_accept(ssl) == 1) {
+          // wait for client's close_notify
+          char buf[16];
+          SSL_read(ssl, buf, sizeof(buf));
+          SSL_shutdown(ssl);
+        }
+        SSL_free(ssl);
+        close(connection);
+      }
+    });
+  }
+
+  ~TlsServer() {
+    shutdown(fd, SHUT_RDWR);
+    worker.join();
+    SSL_CTX_free(ctx);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+  }
+
+  EVP_PKEY *key = nullptr;
+  X509 *cert = nullptr;
+  SSL_CTX *ctx = nullptr;
+  std::thread worker;
+};
+
+}  // namespace
+
+TEST_F(LinuxClientTests, TlsSessionIsResumedAndStoredInFile) {
+  char dirTemplate[] = "/tmp/supla_tls_session_XXXXXX";
+  ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+  std::filesystem::path dir = dirTemplate;
+  Supla::LinuxClient::setSessionCachePath(dir.string());
+
+  TlsServer server(3);
+  auto fullCount = Supla::LinuxClient::getFullHandshakeCount();
+  auto resumedCount = Supla::LinuxClient::getResumedHandshakeCount();
+  std::string sessionFile =
+      (dir / ("tls_session_127.0.0.1_" + std::to_string(server.port) + ".pem"))
+          .string();
+
+  {
+    LinuxClientForTest client;
+    client.setNonBlockingConnect(true);
+    client.setSSLEnabled(true);
+    EXPECT_EQ(connectUntilDone(&client, "127.0.0.1", server.port), 1);
+    EXPECT_EQ(Supla::LinuxClient::getFullHandshakeCount(), fullCount + 1);
+
+    // session file is readable only by owner
+    struct stat st = {};
+    ASSERT_EQ(stat(sessionFile.c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0600);
+    EXPECT_FALSE(std::filesystem::exists(sessionFile + ".tmp"));
+
+    // reconnect uses cached session
+    client.stop();
+    EXPECT_EQ(connectUntilDone(&client, "127.0.0.1", server.port), 1);
+    EXPECT_EQ(Supla::LinuxClient::getResumedHandshakeCount(),
+              resumedCount + 1);
+    client.stop();
+  }
+
+  // new client (i.e. after application restart) loads session from file
+  LinuxClientForTest client;
+  client.setNonBlockingConnect(true);
+  client.setSSLEnabled(true);
+  EXPECT_EQ(connectUntilDone(&client, "127.0.0.1", server.port), 1);
+  EXPECT_EQ(Supla::LinuxClient::getResumedHandshakeCount(), resumedCount + 2);
+  EXPECT_EQ(Supla::LinuxClient::getFullHandshakeCount(), fullCount + 1);
+  client.stop();
+
+  Supla::LinuxClient::setSessionCachePath("");
+  std::filesystem::remove_all(dir);
+}
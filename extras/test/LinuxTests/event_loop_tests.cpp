@@ -0,0 +1,157 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <arduino_mock.h>
+#include <linux_event_loop.h>
+#include <supla/element.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
+namespace {
+
+class SimpleTime : public TimeInterface {
+ public:
+  uint64_t millis() override {
+    return value;
+  }
+
+  uint64_t value = 0;
+};
+
+class ElementWithDeadline : public Supla::Element {
+ public:
+  ElementWithDeadline() {
+    useDeadlineScheduling();
+  }
+
+  void iterateAlways() override {
+  }
+
+  void schedule(uint64_t deadlineMs) {
+    scheduleIterateAlways(deadlineMs);
+  }
+};
+
+class EventLoopTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(Supla::Linux::EventLoop::init());
+  }
+
+  void TearDown() override {
+    Supla::Linux::EventLoop::deinit();
+  }
+
+  // Returns duration of EventLoop::wait() call in ms
+  int64_t measureWait(uint32_t maxWaitMs) {
+    auto start = std::chrono::steady_clock::now();
+    Supla::Linux::EventLoop::wait(maxWaitMs);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+
+  SimpleTime time;
+};
+
+}  // namespace
+
+TEST_F(EventLoopTests, WaitTimesOutAfterMaxWait) {
+  auto elapsed = measureWait(30);
+  EXPECT_GE(elapsed, 25);
+  EXPECT_LT(elapsed, 1000);
+}
+
+TEST_F(EventLoopTests, WaitReturnsWhenFdIsReadable) {
+  int fds[2] = {};
+  ASSERT_EQ(pipe(fds), 0);
+  Supla::Linux::EventLoop::addFd(fds[0]);
+  auto wakeUpCount = Supla::Linux::EventLoop::getWakeUpCount();
+
+  std::thread writer([&fds]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(write(fds[1], "x", 1), 1);
+  });
+  EXPECT_LT(measureWait(5000), 2000);
+  writer.join();
+  EXPECT_EQ(Supla::Linux::EventLoop::getWakeUpCount(), wakeUpCount + 1);
+
+  // removed fd doesn't wake up loop
+  Supla::Linux::EventLoop::removeFd(fds[0]);
+  EXPECT_GE(measureWait(30), 25);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST_F(EventLoopTests, WakeUpFromOtherThread) {
+  std::thread waker([]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    Supla::Linux::EventLoop::wakeUp();
+  });
+  EXPECT_LT(measureWait(5000), 2000);
+  waker.join();
+
+  // wake up event is consumed by wait()
+  EXPECT_GE(measureWait(30), 25);
+}
+
+TEST_F(EventLoopTests, WakeUpInShortensWait) {
+  Supla::Linux::EventLoop::wakeUpIn(100);
+  // earlier request wins
+  Supla::Linux::EventLoop::wakeUpIn(20);
+  Supla::Linux::EventLoop::wakeUpIn(3000);
+  auto elapsed = measureWait(5000);
+  EXPECT_GE(elapsed, 15);
+  EXPECT_LT(elapsed, 2000);
+
+  // requests are cleared by wait()
+  EXPECT_GE(measureWait(30), 25);
+}
+
+TEST_F(EventLoopTests, ElementDeadlineShortensWait) {
+  ElementWithDeadline element;
+  // element is iterated once after it is added
+  EXPECT_EQ(Supla::Element::takeDueElements(0), &element);
+
+  element.schedule(20);
+  auto elapsed = measureWait(5000);
+  EXPECT_GE(elapsed, 15);
+  EXPECT_LT(elapsed, 2000);
+  EXPECT_EQ(Supla::Element::takeDueElements(20), &element);
+}
+
+TEST_F(EventLoopTests, WatchFdWrite) {
+  int fds[2] = {};
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  Supla::Linux::EventLoop::addFd(fds[0]);
+
+  // socket is writable, so loop doesn't sleep
+  Supla::Linux::EventLoop::watchFdWrite(fds[0], true);
+  EXPECT_LT(measureWait(5000), 1000);
+
+  Supla::Linux::EventLoop::watchFdWrite(fds[0], false);
+  EXPECT_GE(measureWait(30), 25);
+
+  Supla::Linux::EventLoop::removeFd(fds[0]);
+  close(fds[0]);
+  close(fds[1]);
+}
@@ -0,0 +1,74 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <linux_timers.h>
+#include <supla/element.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
+namespace {
+
+class TimerCounter : public Supla::Element {
+ public:
+  void onTimer() override {
+    timerCount++;
+  }
+
+  void onFastTimer() override {
+    fastTimerCount++;
+  }
+
+  std::atomic<int> timerCount{0};
+  std::atomic<int> fastTimerCount{0};
+};
+
+}  // namespace
+
+TEST(LinuxTimersTests, TimersCallElements) {
+  TimerCounter counter;
+  Supla::Linux::Timers::init();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  Supla::Linux::Timers::deinit();
+
+  // 1 ms fast timer and 10 ms timer (missed fast timer ticks are skipped)
+  int fastTimerCount = counter.fastTimerCount;
+  int timerCount = counter.timerCount;
+  EXPECT_GE(fastTimerCount, 20);
+  EXPECT_LE(fastTimerCount, 110);
+  EXPECT_GE(timerCount, 5);
+  EXPECT_LE(timerCount, 11);
+
+  // timers thread is stopped
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(counter.fastTimerCount, fastTimerCount);
+  EXPECT_EQ(counter.timerCount, timerCount);
+}
+
+TEST(LinuxTimersTests, DisabledTimersDontStartThread) {
+  TimerCounter counter;
+  Supla::Linux::Timers::setEnabled(false);
+  Supla::Linux::Timers::init();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  Supla::Linux::Timers::deinit();
+  Supla::Linux::Timers::setEnabled(true);
+
+  EXPECT_EQ(counter.fastTimerCount, 0);
+  EXPECT_EQ(counter.timerCount, 0);
+}
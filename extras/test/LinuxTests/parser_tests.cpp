@@ -0,0 +1,269 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <arduino_mock.h>
+#include <linux_worker_pool.h>
+#include <supla/parser/simple.h>
+#include <supla/sensor/thermometer_parsed.h>
+#include <supla/source/source.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <mutex>   // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+namespace {
+
+class SimpleTime : public TimeInterface {
+ public:
+  uint64_t millis() override {
+    return value;
+  }
+
+  uint64_t value = 1000;
+};
+
+class FakeSource : public Supla::Source::Source {
+ public:
+  explicit FakeSource(const std::string &text) : text(text) {
+  }
+
+  std::string getContent() override {
+    readThread = std::this_thread::get_id();
+    readCount++;
+    return text;
+  }
+
+  void setText(const std::string &newText) {
+    std::lock_guard<std::mutex> lock(getMutex());
+    text = newText;
+  }
+
+  std::string text;
+  std::atomic<int> readCount{0};
+  std::thread::id readThread;
+};
+
+class RecordingListener : public Supla::Parser::SnapshotListener {
+ public:
+  explicit RecordingListener(Supla::Parser::Parser *parser) : parser(parser) {
+  }
+
+  void onSnapshotPublished() override {
+    publishThread = std::this_thread::get_id();
+    auto snapshot = parser->getSnapshot();
+    lastVersion = snapshot->version;
+    // refresh from listener uses snapshot which is being published
+    refreshResult = parser->refreshParserSource();
+    count++;
+  }
+
+  Supla::Parser::Parser *parser = nullptr;
+  int count = 0;
+  uint32_t lastVersion = 0;
+  bool refreshResult = false;
+  std::thread::id publishThread;
+};
+
+class ParserTests : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    Supla::Linux::WorkerPool::stop();
+    Supla::Linux::WorkerPool::processFinishedJobs();
+  }
+
+  SimpleTime time;
+};
+
+}  // namespace
+
+TEST_F(ParserTests, SlotsKeepValuesOfParsedKeys) {
+  FakeSource source("1.5 2.5\n3.5\n");
+  Supla::Parser::Simple parser(&source);
+  parser.addKey("a", 0);
+  parser.addCellKey("b", 0, 1);
+  parser.addKey("c", 1);
+
+  int slotA = parser.getSlot("a");
+  int slotB = parser.getSlot("b");
+  EXPECT_EQ(parser.getSlot("a"), slotA);
+  EXPECT_NE(slotA, slotB);
+  int slotMissing = parser.getSlot("missing");
+
+  // nothing is published before first refresh
+  EXPECT_EQ(parser.getSnapshot()->version, 0);
+  EXPECT_FALSE(parser.getSnapshot()->valid);
+
+  EXPECT_TRUE(parser.refreshParserSource());
+  auto snapshot = parser.getSnapshot();
+  EXPECT_EQ(snapshot->version, 1);
+  EXPECT_TRUE(snapshot->valid);
+  ASSERT_EQ(snapshot->values.size(), 3);
+  EXPECT_TRUE(snapshot->found[slotA]);
+  EXPECT_DOUBLE_EQ(snapshot->values[slotA], 1.5);
+  EXPECT_TRUE(snapshot->found[slotB]);
+  EXPECT_DOUBLE_EQ(snapshot->values[slotB], 2.5);
+  EXPECT_FALSE(snapshot->found[slotMissing]);
+
+  // slot added after parsing forces new parsing without waiting for refresh
+  // time
+  int slotC = parser.getSlot("c");
+  EXPECT_TRUE(parser.refreshParserSource());
+  snapshot = parser.getSnapshot();
+  EXPECT_EQ(snapshot->version, 2);
+  ASSERT_EQ(snapshot->values.size(), 4);
+  EXPECT_TRUE(snapshot->found[slotC]);
+  EXPECT_DOUBLE_EQ(snapshot->values[slotC], 3.5);
+  EXPECT_DOUBLE_EQ(snapshot->values[slotA], 1.5);
+}
+
+TEST_F(ParserTests, SnapshotIsPublishedToListeners) {
+  FakeSource source("1\n");
+  Supla::Parser::Simple parser(&source);
+  parser.setRefreshTime(100);
+  parser.addKey("a", 0);
+  int slot = parser.getSlot("a");
+  RecordingListener first(&parser);
+  RecordingListener second(&parser);
+  parser.addSnapshotListener(&first);
+  parser.addSnapshotListener(&second);
+
+  EXPECT_TRUE(parser.refreshParserSource());
+  EXPECT_EQ(first.count, 1);
+  EXPECT_EQ(second.count, 1);
+  EXPECT_EQ(first.lastVersion, 1);
+  EXPECT_TRUE(first.refreshResult);
+  // refresh called from listener doesn't read source again
+  EXPECT_EQ(source.readCount, 1);
+
+  // no new snapshot before refresh time
+  time.value += 50;
+  EXPECT_TRUE(parser.refreshParserSource());
+  EXPECT_EQ(first.count, 1);
+
+  parser.removeSnapshotListener(&second);
+  source.setText("2\n");
+  time.value += 100;
+  EXPECT_TRUE(parser.refreshParserSource());
+  EXPECT_EQ(first.count, 2);
+  EXPECT_EQ(second.count, 1);
+  EXPECT_DOUBLE_EQ(parser.getSnapshot()->values[slot], 2);
+}
+
+TEST_F(ParserTests, ParsersShareSourceCache) {
+  FakeSource source("1 2\n");
+  Supla::Parser::Simple first(&source);
+  Supla::Parser::Simple second(&source);
+  first.setRefreshTime(1000);
+  second.setRefreshTime(1000);
+  first.addKey("a", 0);
+  second.addCellKey("b", 0, 1);
+  int slotA = first.getSlot("a");
+  int slotB = second.getSlot("b");
+
+  EXPECT_TRUE(first.refreshParserSource());
+  EXPECT_TRUE(second.refreshParserSource());
+  // source is read once for both parsers
+  EXPECT_EQ(source.readCount, 1);
+  EXPECT_DOUBLE_EQ(first.getSnapshot()->values[slotA], 1);
+  EXPECT_DOUBLE_EQ(second.getSnapshot()->values[slotB], 2);
+
+  source.setText("3 4\n");
+  time.value += 1001;
+  EXPECT_TRUE(first.refreshParserSource());
+  EXPECT_TRUE(second.refreshParserSource());
+  EXPECT_EQ(source.readCount, 2);
+  EXPECT_DOUBLE_EQ(first.getSnapshot()->values[slotA], 3);
+  EXPECT_DOUBLE_EQ(second.getSnapshot()->values[slotB], 4);
+}
+
+TEST_F(ParserTests, SensorsSharingParserAreUpdatedFromSameSnapshot) {
+  FakeSource source("21.5\n");
+  Supla::Parser::Simple parser(&source);
+  parser.setRefreshTime(100);
+  Supla::Sensor::ThermometerParsed first(&parser);
+  first.setMapping(Supla::Parser::Temperature, 0);
+  {
+    Supla::Sensor::ThermometerParsed second(&parser);
+    second.setMapping(Supla::Parser::Temperature, 0);
+    first.onInit();
+    second.onInit();
+    EXPECT_DOUBLE_EQ(first.getChannel()->getValueDouble(), 21.5);
+    EXPECT_DOUBLE_EQ(second.getChannel()->getValueDouble(), 21.5);
+
+    // refresh driven by one sensor updates channels of all sensors
+    source.setText("22.5\n");
+    time.value += 101;
+    first.iterateAlways();
+    EXPECT_DOUBLE_EQ(first.getChannel()->getValueDouble(), 22.5);
+    EXPECT_DOUBLE_EQ(second.getChannel()->getValueDouble(), 22.5);
+  }
+
+  // destroyed sensor is removed from parser listeners
+  source.setText("23.5\n");
+  time.value += 101;
+  first.iterateAlways();
+  EXPECT_DOUBLE_EQ(first.getChannel()->getValueDouble(), 23.5);
+}
+
+TEST_F(ParserTests, AsyncRefreshIsPublishedOnMainThread) {
+  FakeSource source("1\n");
+  Supla::Parser::Simple parser(&source);
+  parser.setRefreshTime(100);
+  parser.addKey("a", 0);
+  int slot = parser.getSlot("a");
+  RecordingListener listener(&parser);
+  parser.addSnapshotListener(&listener);
+  ASSERT_TRUE(Supla::Linux::WorkerPool::start(1));
+
+  // first refresh is synchronous, so values are available right after start
+  EXPECT_TRUE(parser.refreshParserSource());
+  EXPECT_EQ(source.readCount, 1);
+  EXPECT_EQ(source.readThread, std::this_thread::get_id());
+  EXPECT_EQ(parser.getSnapshot()->version, 1);
+  EXPECT_DOUBLE_EQ(parser.getSnapshot()->values[slot], 1);
+
+  source.setText("2\n");
+  time.value += 101;
+  EXPECT_TRUE(parser.refreshParserSource());
+
+  auto start = std::chrono::steady_clock::now();
+  while (source.readCount < 2 &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(source.readCount, 2);
+  EXPECT_NE(source.readThread, std::this_thread::get_id());
+
+  // parsed values are not visible until main thread processes finished jobs
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(parser.getSnapshot()->version, 1);
+  EXPECT_DOUBLE_EQ(parser.getSnapshot()->values[slot], 1);
+  EXPECT_EQ(listener.count, 1);
+
+  start = std::chrono::steady_clock::now();
+  while (parser.getSnapshot()->version == 1 &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+    Supla::Linux::WorkerPool::processFinishedJobs();
+  }
+  EXPECT_EQ(parser.getSnapshot()->version, 2);
+  EXPECT_DOUBLE_EQ(parser.getSnapshot()->values[slot], 2);
+  EXPECT_EQ(listener.count, 2);
+  EXPECT_EQ(listener.publishThread, std::this_thread::get_id());
+}
@@ -0,0 +1,197 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <arduino_mock.h>
+#include <linux_event_loop.h>
+#include <linux_worker_pool.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace {
+
+class SimpleTime : public TimeInterface {
+ public:
+  uint64_t millis() override {
+    return value;
+  }
+
+  uint64_t value = 0;
+};
+
+class RecordingJob : public Supla::Linux::WorkerPool::Job {
+ public:
+  RecordingJob(int id, std::vector<int> *finishOrder)
+      : id(id), finishOrder(finishOrder) {
+  }
+
+  void run() override {
+    if (gate.valid()) {
+      gate.wait();
+    }
+    runThread = std::this_thread::get_id();
+    runCount++;
+  }
+
+  void finish() override {
+    finishThread = std::this_thread::get_id();
+    finishOrder->push_back(id);
+  }
+
+  int id = 0;
+  std::vector<int> *finishOrder = nullptr;
+  std::shared_future<void> gate;
+  std::atomic<int> runCount{0};
+  std::thread::id runThread;
+  std::thread::id finishThread;
+};
+
+class WorkerPoolTests : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    Supla::Linux::WorkerPool::stop();
+    Supla::Linux::WorkerPool::processFinishedJobs();
+    Supla::Linux::EventLoop::deinit();
+  }
+
+  SimpleTime time;
+};
+
+}  // namespace
+
+TEST_F(WorkerPoolTests, SubmitRequiresRunningPool) {
+  std::vector<int> finishOrder;
+  RecordingJob job(1, &finishOrder);
+
+  EXPECT_FALSE(Supla::Linux::WorkerPool::isRunning());
+  EXPECT_FALSE(Supla::Linux::WorkerPool::submit(&job));
+  EXPECT_FALSE(Supla::Linux::WorkerPool::start(0));
+
+  EXPECT_TRUE(Supla::Linux::WorkerPool::start(1));
+  EXPECT_FALSE(Supla::Linux::WorkerPool::start(1));
+  EXPECT_TRUE(Supla::Linux::WorkerPool::isRunning());
+  EXPECT_FALSE(Supla::Linux::WorkerPool::submit(nullptr));
+
+  Supla::Linux::WorkerPool::stop();
+  EXPECT_FALSE(Supla::Linux::WorkerPool::isRunning());
+  EXPECT_FALSE(Supla::Linux::WorkerPool::submit(&job));
+  EXPECT_EQ(job.runCount, 0);
+}
+
+TEST_F(WorkerPoolTests, StopRunsQueuedJobsAndFinishKeepsCompletionOrder) {
+  std::vector<int> finishOrder;
+  RecordingJob first(1, &finishOrder);
+  RecordingJob second(2, &finishOrder);
+  RecordingJob third(3, &finishOrder);
+  std::promise<void> release;
+  first.gate = release.get_future().share();
+
+  ASSERT_TRUE(Supla::Linux::WorkerPool::start(1));
+  ASSERT_TRUE(Supla::Linux::WorkerPool::submit(&first));
+  ASSERT_TRUE(Supla::Linux::WorkerPool::submit(&second));
+  ASSERT_TRUE(Supla::Linux::WorkerPool::submit(&third));
+
+  // single worker is blocked by first job, so other jobs are still queued
+  // when stop() is called
+  std::thread stopper([]() { Supla::Linux::WorkerPool::stop(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(second.runCount, 0);
+  EXPECT_EQ(third.runCount, 0);
+  release.set_value();
+  stopper.join();
+
+  EXPECT_FALSE(Supla::Linux::WorkerPool::isRunning());
+  EXPECT_EQ(first.runCount, 1);
+  EXPECT_EQ(second.runCount, 1);
+  EXPECT_EQ(third.runCount, 1);
+  EXPECT_NE(first.runThread, std::this_thread::get_id());
+  // finished jobs are not processed by stop()
+  EXPECT_TRUE(finishOrder.empty());
+
+  // finished jobs stack is reversed, so finish() is called in order of
+  // completion
+  Supla::Linux::WorkerPool::processFinishedJobs();
+  EXPECT_EQ(finishOrder, std::vector<int>({1, 2, 3}));
+  EXPECT_EQ(first.finishThread, std::this_thread::get_id());
+  EXPECT_EQ(first.nextFinished, nullptr);
+  EXPECT_EQ(third.nextFinished, nullptr);
+
+  Supla::Linux::WorkerPool::processFinishedJobs();
+  EXPECT_EQ(finishOrder.size(), 3);
+}
+
+TEST_F(WorkerPoolTests, JobsFinishedByManyWorkersAreFinishedOnce) {
+  const int jobCount = 200;
+  std::vector<int> finishOrder;
+  std::vector<std::unique_ptr<RecordingJob>> jobs;
+  for (int i = 0; i < jobCount; i++) {
+    jobs.emplace_back(new RecordingJob(i, &finishOrder));
+  }
+
+  ASSERT_TRUE(Supla::Linux::WorkerPool::start(4));
+  for (auto &job : jobs) {
+    ASSERT_TRUE(Supla::Linux::WorkerPool::submit(job.get()));
+  }
+
+  // finished jobs are collected concurrently with workers pushing new ones
+  auto start = std::chrono::steady_clock::now();
+  while (static_cast<int>(finishOrder.size()) < jobCount &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+    Supla::Linux::WorkerPool::processFinishedJobs();
+  }
+
+  ASSERT_EQ(finishOrder.size(), jobCount);
+  std::vector<int> finishCount(jobCount, 0);
+  for (auto id : finishOrder) {
+    finishCount[id]++;
+  }
+  for (int i = 0; i < jobCount; i++) {
+    EXPECT_EQ(finishCount[i], 1) << "job " << i;
+    EXPECT_EQ(jobs[i]->runCount, 1) << "job " << i;
+    EXPECT_EQ(jobs[i]->finishThread, std::this_thread::get_id());
+  }
+}
+
+TEST_F(WorkerPoolTests, FinishedJobWakesUpEventLoop) {
+  ASSERT_TRUE(Supla::Linux::EventLoop::init());
+  std::vector<int> finishOrder;
+  RecordingJob job(1, &finishOrder);
+  std::promise<void> release;
+  job.gate = release.get_future().share();
+
+  ASSERT_TRUE(Supla::Linux::WorkerPool::start(1));
+  ASSERT_TRUE(Supla::Linux::WorkerPool::submit(&job));
+
+  std::thread releaser([&release]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release.set_value();
+  });
+  auto start = std::chrono::steady_clock::now();
+  Supla::Linux::EventLoop::wait(5000);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  releaser.join();
+
+  EXPECT_LT(elapsed, std::chrono::seconds(2));
+  EXPECT_EQ(job.runCount, 1);
+  Supla::Linux::WorkerPool::processFinishedJobs();
+  EXPECT_EQ(finishOrder, std::vector<int>({1}));
+}
@@ -181,3 +181,38 @@ TEST(LocalActionTests, FourItemsTestsWithCalls) {
   delete b3;
   delete b4;
 }
+
+TEST(LocalActionTests, ActionsAreCalledInOrderOfAdding) {
+  ::testing::InSequence seq;
+  Supla::LocalAction b1;
+  ActionHandlerMock mock1;
+  ActionHandlerMock mock2;
+
+  int event1 = 11;
+  int event2 = 12;
+
+  EXPECT_CALL(mock1, handleAction(event2, 5));
+  EXPECT_CALL(mock2, handleAction(event2, 2));
+  EXPECT_CALL(mock1, handleAction(event2, 3));
+  EXPECT_CALL(mock2, handleAction(event1, 4));
+  EXPECT_CALL(mock1, handleAction(event2, 3));
+
+  b1.addAction(5, mock1, event2);
+  b1.addAction(1, mock1, event1);
+  b1.addAction(2, mock2, event2);
+  b1.addAction(4, mock2, event1);
+  b1.addAction(3, mock1, event2);
+
+  EXPECT_EQ(b1.getHandlerForFirstClient(event1)->action, 1);
+  EXPECT_EQ(b1.getHandlerForFirstClient(event2)->action, 5);
+
+  b1.runAction(event2);
+
+  b1.disableOtherClients(mock2, event1);
+  b1.runAction(event1);
+
+  // removed client is not called anymore
+  delete b1.getHandlerForFirstClient(event2);
+  b1.disableOtherClients(mock1, event2);
+  b1.runAction(event2);
+}
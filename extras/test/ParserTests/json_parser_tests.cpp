@@ -0,0 +1,145 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <linux_event_loop.h>
+#include <supla/parser/json.h>
+#include <supla/source/source.h>
+#include <supla/time.h>
+
+#include <string>
+#include <vector>
+
+// Tests are linked with Linux port Json parser
+
+uint64_t millis() {
+  return 0;
+}
+
+void Supla::Linux::EventLoop::wakeUpIn(uint32_t) {
+}
+
+void Supla::Linux::EventLoop::wakeUp() {
+}
+
+namespace {
+
+class StringSource : public Supla::Source::Source {
+ public:
+  explicit StringSource(std::string content) : content(std::move(content)) {
+  }
+
+  std::string getContent() override {
+    return content;
+  }
+
+  std::string content;
+};
+
+const char *Document =
+    "{\"voltage\": 231.5, \"count\": 12, \"negative\": -3, "
+    "\"on\": true, \"off\": false, \"name\": \"inverter\", \"empty\": null, "
+    "\"a/b\": 1.5, \"c~d\": 2.5, "
+    "\"history\": [{\"power\": 10}, {\"power\": 20}], "
+    "\"inverter\": {\"phases\": [{\"voltage\": 230.1, \"current\": 1.25}, "
+    "{\"voltage\": 229.8, \"current\": [2.5, 3.5]}]}, "
+    "\"total_energy\": 12345.678}";
+
+struct Result {
+  bool valid;
+  double value;
+};
+
+std::vector<Result> parse(bool streaming,
+                          const std::string &document,
+                          const std::vector<std::string> &keys) {
+  StringSource source(document);
+  Supla::Parser::Json parser(&source);
+  parser.setStreamingMode(streaming);
+  for (auto &key : keys) {
+    parser.addKey(key, -1);
+  }
+
+  std::vector<Result> results;
+  for (auto &key : keys) {
+    parser.refreshSource();
+    Result result = {};
+    result.value = parser.getValue(key);
+    result.valid = parser.isValid();
+    results.push_back(result);
+  }
+  return results;
+}
+
+}  // namespace
+
+TEST(JsonParserTests, DomIsDefaultMode) {
+  StringSource source("{\"voltage\": 230}");
+  Supla::Parser::Json parser(&source);
+  // not registered key can be read only in DOM mode
+  EXPECT_TRUE(parser.refreshSource());
+  EXPECT_DOUBLE_EQ(parser.getValue("voltage"), 230);
+  EXPECT_TRUE(parser.isValid());
+}
+
+TEST(JsonParserTests, StreamingAndDomModesGiveSameValues) {
+  std::vector<std::string> keys = {"voltage",
+                                   "count",
+                                   "negative",
+                                   "on",
+                                   "off",
+                                   "name",
+                                   "empty",
+                                   "missing",
+                                   "a/b",
+                                   "/c~0d",
+                                   "/history/1/power",
+                                   "/history/2/power",
+                                   "/inverter/phases/0/voltage",
+                                   "/inverter/phases/1/current/1",
+                                   "/inverter/phases/1/current",
+                                   "total_energy"};
+
+  auto dom = parse(false, Document, keys);
+  auto streaming = parse(true, Document, keys);
+  ASSERT_EQ(dom.size(), keys.size());
+  ASSERT_EQ(streaming.size(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(dom[i].valid, streaming[i].valid) << keys[i];
+    if (dom[i].valid) {
+      EXPECT_DOUBLE_EQ(dom[i].value, streaming[i].value) << keys[i];
+    }
+  }
+
+  EXPECT_TRUE(dom[0].valid);
+  EXPECT_DOUBLE_EQ(dom[0].value, 231.5);
+  EXPECT_DOUBLE_EQ(dom[3].value, 1);
+  EXPECT_FALSE(dom[7].valid);
+  EXPECT_DOUBLE_EQ(dom[8].value, 1.5);
+  EXPECT_DOUBLE_EQ(dom[9].value, 2.5);
+  EXPECT_DOUBLE_EQ(dom[13].value, 3.5);
+}
+
+TEST(JsonParserTests, MalformedDocumentIsInvalidInBothModes) {
+  for (bool streaming : {false, true}) {
+    StringSource source("{\"voltage\": 230, \"current\": }");
+    Supla::Parser::Json parser(&source);
+    parser.setStreamingMode(streaming);
+    parser.addKey("current", -1);
+    EXPECT_FALSE(parser.refreshSource()) << streaming;
+  }
+}
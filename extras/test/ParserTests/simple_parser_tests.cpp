@@ -0,0 +1,193 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <linux_event_loop.h>
+#include <supla/parser/simple.h>
+#include <supla/source/source.h>
+#include <supla/time.h>
+
+#include <string>
+#include <vector>
+
+// Tests are linked with Linux port Simple parser
+
+uint64_t millis() {
+  return 0;
+}
+
+void Supla::Linux::EventLoop::wakeUpIn(uint32_t) {
+}
+
+void Supla::Linux::EventLoop::wakeUp() {
+}
+
+namespace {
+
+class StringSource : public Supla::Source::Source {
+ public:
+  explicit StringSource(std::string content) : content(std::move(content)) {
+  }
+
+  std::string getContent() override {
+    return content;
+  }
+
+  std::string content;
+};
+
+struct Cell {
+  int line;
+  int column;
+};
+
+struct Result {
+  bool valid;
+  double value;
+};
+
+std::vector<Result> parse(const std::string &content,
+                          const std::vector<Cell> &cells,
+                          char separator = ' ') {
+  StringSource source(content);
+  Supla::Parser::Simple parser(&source);
+  parser.setSeparator(separator);
+  for (size_t i = 0; i < cells.size(); i++) {
+    parser.addCellKey(std::to_string(i), cells[i].line, cells[i].column);
+  }
+
+  std::vector<Result> results;
+  EXPECT_TRUE(parser.refreshSource());
+  for (size_t i = 0; i < cells.size(); i++) {
+    Result result = {};
+    result.value = parser.getValue(std::to_string(i));
+    result.valid = parser.isValid();
+    results.push_back(result);
+    // getValue() of missing cell invalidates parser until next refresh
+    parser.refreshSource();
+  }
+  return results;
+}
+
+}  // namespace
+
+TEST(SimpleParserTests, AddKeyUsesFirstColumn) {
+  StringSource source("21.5 C\n  -3.25\t10\n+7\n");
+  Supla::Parser::Simple parser(&source);
+  parser.addKey("temperature", 0);
+  parser.addKey("offset", 1);
+  parser.addKey("plus", 2);
+
+  EXPECT_TRUE(parser.isBasedOnIndex());
+  EXPECT_TRUE(parser.refreshSource());
+  EXPECT_DOUBLE_EQ(parser.getValue("temperature"), 21.5);
+  EXPECT_DOUBLE_EQ(parser.getValue("offset"), -3.25);
+  EXPECT_DOUBLE_EQ(parser.getValue("plus"), 7);
+  EXPECT_TRUE(parser.isValid());
+}
+
+TEST(SimpleParserTests, CellKeysWithBlankSeparator) {
+  auto results = parse("1  2\t3\n\t4 5\n", {{0, 2}, {0, 1}, {1, 0}, {1, 1}});
+  ASSERT_EQ(results.size(), 4);
+  for (auto &result : results) {
+    EXPECT_TRUE(result.valid);
+  }
+  EXPECT_DOUBLE_EQ(results[0].value, 3);
+  EXPECT_DOUBLE_EQ(results[1].value, 2);
+  EXPECT_DOUBLE_EQ(results[2].value, 4);
+  EXPECT_DOUBLE_EQ(results[3].value, 5);
+}
+
+TEST(SimpleParserTests, CellKeysWithCustomSeparator) {
+  auto results =
+      parse("1; 2 ;;4\nname;x;6.5\n", {{0, 1}, {0, 2}, {0, 3}, {1, 1}, {1, 2}},
+            ';');
+  ASSERT_EQ(results.size(), 5);
+  EXPECT_TRUE(results[0].valid);
+  EXPECT_DOUBLE_EQ(results[0].value, 2);
+  // empty column and column without number give 0
+  EXPECT_TRUE(results[1].valid);
+  EXPECT_DOUBLE_EQ(results[1].value, 0);
+  EXPECT_TRUE(results[2].valid);
+  EXPECT_DOUBLE_EQ(results[2].value, 4);
+  EXPECT_TRUE(results[3].valid);
+  EXPECT_DOUBLE_EQ(results[3].value, 0);
+  EXPECT_TRUE(results[4].valid);
+  EXPECT_DOUBLE_EQ(results[4].value, 6.5);
+}
+
+TEST(SimpleParserTests, CrLfLineEndings) {
+  auto results = parse("1\r\n2 3\r\n4;5\r\n", {{0, 0}, {1, 1}, {2, 0}});
+  ASSERT_EQ(results.size(), 3);
+  EXPECT_TRUE(results[0].valid);
+  EXPECT_DOUBLE_EQ(results[0].value, 1);
+  EXPECT_TRUE(results[1].valid);
+  EXPECT_DOUBLE_EQ(results[1].value, 3);
+  EXPECT_DOUBLE_EQ(results[2].value, 4);
+
+  // CR isn't part of last column
+  results = parse("1;2\r\n", {{0, 1}, {0, 2}}, ';');
+  EXPECT_TRUE(results[0].valid);
+  EXPECT_DOUBLE_EQ(results[0].value, 2);
+  EXPECT_FALSE(results[1].valid);
+}
+
+TEST(SimpleParserTests, MissingLinesAndColumnsAreInvalid) {
+  auto results = parse("1 2\n3\n", {{0, 1}, {0, 2}, {1, 1}, {5, 0}});
+  ASSERT_EQ(results.size(), 4);
+  EXPECT_TRUE(results[0].valid);
+  EXPECT_DOUBLE_EQ(results[0].value, 2);
+  EXPECT_FALSE(results[1].valid);
+  EXPECT_FALSE(results[2].valid);
+  EXPECT_FALSE(results[3].valid);
+
+  // trailing blanks don't create new column
+  results = parse("1 2  \n", {{0, 2}});
+  EXPECT_FALSE(results[0].valid);
+}
+
+TEST(SimpleParserTests, NegativeIndexesAreNeverFound) {
+  auto results = parse("1 2\n", {{-1, 0}, {0, -1}, {0, 1}});
+  ASSERT_EQ(results.size(), 3);
+  EXPECT_FALSE(results[0].valid);
+  EXPECT_FALSE(results[1].valid);
+  EXPECT_TRUE(results[2].valid);
+  EXPECT_DOUBLE_EQ(results[2].value, 2);
+}
+
+TEST(SimpleParserTests, NotRegisteredKeyAndEmptySource) {
+  StringSource source("1\n");
+  Supla::Parser::Simple parser(&source);
+  parser.addKey("a", 0);
+  EXPECT_TRUE(parser.refreshSource());
+  EXPECT_DOUBLE_EQ(parser.getValue("unknown"), 0);
+  EXPECT_FALSE(parser.isValid());
+
+  StringSource empty("");
+  Supla::Parser::Simple emptyParser(&empty);
+  emptyParser.addKey("a", 0);
+  EXPECT_FALSE(emptyParser.refreshSource());
+  EXPECT_FALSE(emptyParser.isValid());
+}
+
+TEST(SimpleParserTests, ParseNumber) {
+  EXPECT_DOUBLE_EQ(Supla::Parser::Simple::parseNumber("  7x"), 7);
+  EXPECT_DOUBLE_EQ(Supla::Parser::Simple::parseNumber("+5.5"), 5.5);
+  EXPECT_DOUBLE_EQ(Supla::Parser::Simple::parseNumber("-1e3"), -1000);
+  EXPECT_DOUBLE_EQ(Supla::Parser::Simple::parseNumber("abc"), 0);
+  EXPECT_DOUBLE_EQ(Supla::Parser::Simple::parseNumber(""), 0);
+}
@@ -0,0 +1,115 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <arduino_mock.h>
+#include <supla/source/cmd.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace {
+
+class SimpleTime : public TimeInterface {
+ public:
+  uint64_t millis() override {
+    return value;
+  }
+
+  uint64_t value = 0;
+};
+
+class CmdTests : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    Supla::Source::Cmd::setMaxRunningCommands(4);
+  }
+
+  // Iterates command until all async commands finish
+  void waitForCommands(Supla::Source::Cmd *cmd) {
+    for (int i = 0; i < 500; i++) {
+      cmd->iterateAlways();
+      if (Supla::Source::Cmd::getRunningCommandsCount() == 0) {
+        return;
+      }
+      usleep(10000);
+    }
+    FAIL() << "command didn't finish";
+  }
+
+  SimpleTime time;
+};
+
+TEST_F(CmdTests, SyncCommandOutputIsReturnedRegardlessOfExitStatus) {
+  Supla::Source::Cmd ok("echo 12.5");
+  EXPECT_EQ(ok.getContent(), "12.5\n");
+
+  // i.e. pipeline which ends with grep without match in last line
+  Supla::Source::Cmd failed("echo 12.5; exit 1");
+  EXPECT_EQ(failed.getContent(), "12.5\n");
+}
+
+TEST_F(CmdTests, AsyncCommandReturnsOutputOfLastFinishedRun) {
+  Supla::Source::Cmd cmd("echo 12.5");
+  cmd.setAsync(true);
+
+  // first call only starts command
+  EXPECT_EQ(cmd.getContent(), "");
+  EXPECT_EQ(Supla::Source::Cmd::getRunningCommandsCount(), 1);
+  waitForCommands(&cmd);
+
+  EXPECT_EQ(cmd.getContent(), "12.5\n");
+  waitForCommands(&cmd);
+  EXPECT_EQ(cmd.getContent(), "12.5\n");
+}
+
+TEST_F(CmdTests, AsyncCommandWithNonZeroExitStatusIsRejected) {
+  Supla::Source::Cmd cmd("echo 12.5; exit 3");
+  cmd.setAsync(true);
+
+  EXPECT_EQ(cmd.getContent(), "");
+  waitForCommands(&cmd);
+  EXPECT_EQ(cmd.getContent(), "");
+}
+
+TEST_F(CmdTests, AsyncCommandIsKilledOnTimeoutWithoutGetContentCall) {
+  Supla::Source::Cmd cmd("sleep 10");
+  cmd.setAsync(true);
+  cmd.setTimeoutMs(1000);
+
+  EXPECT_EQ(cmd.getContent(), "");
+  cmd.iterateAlways();
+  EXPECT_EQ(Supla::Source::Cmd::getRunningCommandsCount(), 1);
+
+  time.value = 1001;
+  cmd.iterateAlways();
+  EXPECT_EQ(Supla::Source::Cmd::getRunningCommandsCount(), 0);
+}
+
+TEST_F(CmdTests, AsyncCommandsLimit) {
+  Supla::Source::Cmd::setMaxRunningCommands(1);
+  Supla::Source::Cmd cmd1("sleep 10");
+  Supla::Source::Cmd cmd2("sleep 10");
+  cmd1.setAsync(true);
+  cmd2.setAsync(true);
+
+  cmd1.getContent();
+  cmd2.getContent();
+  EXPECT_EQ(Supla::Source::Cmd::getRunningCommandsCount(), 1);
+}
+
+}  // namespace
@@ -0,0 +1,200 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <arduino_mock.h>
+#include <fcntl.h>
+#include <linux_event_loop.h>
+#include <stdlib.h>
+#include <supla/source/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+class SimpleTime : public TimeInterface {
+ public:
+  uint64_t millis() override {
+    return value;
+  }
+
+  uint64_t value = 0;
+};
+
+class FileForTest : public Supla::Source::File {
+ public:
+  using Supla::Source::File::File;
+
+  int getInotifyFd() const {
+    return inotifyFd;
+  }
+};
+
+class FileSourceTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char dirTemplate[] = "/tmp/supla_file_source_XXXXXX";
+    ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+    dir = dirTemplate;
+    path = dir / "input.txt";
+  }
+
+  void TearDown() override {
+    Supla::Linux::EventLoop::deinit();
+    std::filesystem::remove_all(dir);
+  }
+
+  void writeFile(const std::string &content) {
+    std::ofstream file(path, std::ios::trunc);
+    file << content;
+  }
+
+  struct timespec getMtime() {
+    struct stat st = {};
+    EXPECT_EQ(stat(path.c_str(), &st), 0);
+    return st.st_mtim;
+  }
+
+  void setMtime(struct timespec mtime) {
+    struct timespec times[2] = {mtime, mtime};
+    ASSERT_EQ(utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+  }
+
+  // Returns duration of EventLoop::wait() call in ms
+  int64_t measureWait(uint32_t maxWaitMs) {
+    auto start = std::chrono::steady_clock::now();
+    Supla::Linux::EventLoop::wait(maxWaitMs);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+
+  SimpleTime time;
+  std::filesystem::path dir;
+  std::filesystem::path path;
+};
+
+}  // namespace
+
+TEST_F(FileSourceTests, CacheModeSkipsReadOfUnchangedFile) {
+  writeFile("abc\n");
+  FileForTest file(path.c_str());
+  file.setCacheMode(true);
+
+  EXPECT_EQ(file.getContentView(), "abc\n");
+  auto version = file.getContentVersion();
+  EXPECT_NE(version, 0);
+
+  // same inode, size and mtime - file isn't read again
+  auto mtime = getMtime();
+  writeFile("xyz\n");
+  setMtime(mtime);
+  EXPECT_EQ(file.getContentView(), "abc\n");
+  EXPECT_EQ(file.getContentVersion(), version);
+
+  // rewrite with new mtime triggers read
+  mtime.tv_sec += 1;
+  setMtime(mtime);
+  EXPECT_NE(file.getContentVersion(), version);
+  EXPECT_EQ(file.getContentView(), "xyz\n");
+  EXPECT_EQ(file.getContent(), "xyz\n");
+}
+
+TEST_F(FileSourceTests, CacheModeReadsReplacedFile) {
+  writeFile("abc\n");
+  FileForTest file(path.c_str());
+  file.setCacheMode(true);
+  EXPECT_EQ(file.getContentView(), "abc\n");
+  auto version = file.getContentVersion();
+  auto mtime = getMtime();
+
+  // atomic replace with the same size and mtime - only inode differs
+  auto tmpPath = dir / "input.tmp";
+  {
+    std::ofstream tmp(tmpPath);
+    tmp << "def\n";
+  }
+  struct timespec times[2] = {mtime, mtime};
+  ASSERT_EQ(utimensat(AT_FDCWD, tmpPath.c_str(), times, 0), 0);
+  std::filesystem::rename(tmpPath, path);
+
+  EXPECT_NE(file.getContentVersion(), version);
+  EXPECT_EQ(file.getContentView(), "def\n");
+}
+
+TEST_F(FileSourceTests, CacheModeMissingAndTooOldFile) {
+  FileForTest file(path.c_str(), 60);
+  file.setCacheMode(true);
+  EXPECT_TRUE(file.getContentView().empty());
+
+  writeFile("abc\n");
+  EXPECT_EQ(file.getContentView(), "abc\n");
+
+  auto mtime = getMtime();
+  mtime.tv_sec -= 120;
+  setMtime(mtime);
+  auto version = file.getContentVersion();
+  EXPECT_TRUE(file.getContentView().empty());
+  EXPECT_EQ(file.getContentVersion(), version);
+}
+
+TEST_F(FileSourceTests, InotifyCountsChangesAndWakesUpEventLoop) {
+  ASSERT_TRUE(Supla::Linux::EventLoop::init());
+  writeFile("abc\n");
+  FileForTest file(path.c_str());
+  file.setCacheMode(true);
+  file.setInotify(true);
+
+  EXPECT_EQ(file.getChangeNotificationCount(), 0);
+  ASSERT_GE(file.getInotifyFd(), 0);
+
+  // change of other file in the same directory is ignored
+  {
+    std::ofstream other(dir / "other.txt");
+    other << "1";
+  }
+  EXPECT_EQ(file.getChangeNotificationCount(), 0);
+
+  writeFile("def\n");
+  EXPECT_LT(measureWait(5000), 2000);
+  // notification which wasn't read yet doesn't cause busy loop
+  EXPECT_GE(measureWait(30), 25);
+  EXPECT_EQ(file.getChangeNotificationCount(), 1);
+  EXPECT_EQ(file.getContentView(), "def\n");
+
+  // disabled inotify removes fd from event loop
+  file.setInotify(false);
+  EXPECT_EQ(file.getInotifyFd(), -1);
+  writeFile("ghi\n");
+  EXPECT_GE(measureWait(30), 25);
+  EXPECT_EQ(file.getChangeNotificationCount(), 0);
+}
+
+TEST_F(FileSourceTests, InotifyRequiresCacheMode) {
+  writeFile("abc\n");
+  FileForTest file(path.c_str());
+  file.setInotify(true);
+
+  EXPECT_EQ(file.getChangeNotificationCount(), 0);
+  EXPECT_EQ(file.getInotifyFd(), -1);
+  EXPECT_EQ(file.getContentVersion(), 0);
+}
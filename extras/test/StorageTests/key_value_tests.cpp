@@ -453,3 +453,93 @@ TEST(KeyValueTests, variousKVChecks) {
 
 }
 
+
+TEST(KeyValueTests, manyKeysTest) {
+  KeyValueTest kvStorage;
+  char key[SUPLA_STORAGE_KEY_SIZE + 1] = {};
+  for (int i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "key_%d", i);
+    EXPECT_TRUE(kvStorage.setInt32(key, i));
+  }
+  for (int i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "key_%d", i);
+    int32_t value = -1;
+    EXPECT_TRUE(kvStorage.getInt32(key, &value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(kvStorage.getInt32("key_1000", nullptr));
+
+  // only first SUPLA_STORAGE_KEY_SIZE characters of key are used
+  EXPECT_TRUE(kvStorage.setUInt8("long_key_name_1", 1));
+  EXPECT_TRUE(kvStorage.setUInt8("long_key_name_12", 2));
+  uint8_t result = 0;
+  EXPECT_TRUE(kvStorage.getUInt8("long_key_name_1", &result));
+  EXPECT_EQ(result, 2);
+
+  kvStorage.removeAllMemory();
+  EXPECT_FALSE(kvStorage.getInt32("key_1", nullptr));
+  EXPECT_TRUE(kvStorage.setInt32("key_1", 5));
+  int32_t value = 0;
+  EXPECT_TRUE(kvStorage.getInt32("key_1", &value));
+  EXPECT_EQ(value, 5);
+}
+
+TEST(KeyValueTests, modifyValuesLoadedFromMemoryTest) {
+  KeyValueTest kvStorage;
+  EXPECT_TRUE(kvStorage.setString("name", "abc"));
+  EXPECT_TRUE(kvStorage.setBlob("blob", "1234", 4));
+  EXPECT_TRUE(kvStorage.setString("other", "xyz"));
+
+  uint8_t buffer[256] = {};
+  size_t dataWritten = kvStorage.serializeToMemory(buffer, sizeof(buffer));
+
+  KeyValueTest restored;
+  EXPECT_TRUE(restored.initFromMemory(buffer, dataWritten));
+  // input buffer is not used after init
+  memset(buffer, 0, sizeof(buffer));
+
+  char temp[50] = {};
+  // value with the same size is kept in place, other one is reallocated
+  EXPECT_TRUE(restored.setString("name", "def"));
+  EXPECT_TRUE(restored.setString("other", "longer value"));
+  EXPECT_TRUE(restored.setBlob("blob", "12", 2));
+  EXPECT_TRUE(restored.getString("name", temp, 50));
+  EXPECT_STREQ(temp, "def");
+  EXPECT_TRUE(restored.getString("other", temp, 50));
+  EXPECT_STREQ(temp, "longer value");
+  EXPECT_EQ(restored.getBlobSize("blob"), 2);
+  EXPECT_TRUE(restored.getBlob("blob", temp, 2));
+  EXPECT_EQ(memcmp(temp, "12", 2), 0);
+
+  // new keys can be added after init
+  EXPECT_TRUE(restored.setUInt32("new", 7));
+  uint32_t value = 0;
+  EXPECT_TRUE(restored.getUInt32("new", &value));
+  EXPECT_EQ(value, 7);
+
+  // init is allowed only on empty storage
+  EXPECT_FALSE(restored.initFromMemory(buffer, dataWritten));
+}
+
+TEST(KeyValueTests, initFromBrokenMemoryTest) {
+  KeyValueTest kvStorage;
+  EXPECT_TRUE(kvStorage.setUInt8("first", 1));
+  EXPECT_TRUE(kvStorage.setString("second", "text"));
+
+  uint8_t buffer[256] = {};
+  size_t dataWritten = kvStorage.serializeToMemory(buffer, sizeof(buffer));
+
+  // last record ("first" - new keys are added at the beginning) is truncated
+  KeyValueTest restored;
+  EXPECT_FALSE(restored.initFromMemory(buffer, dataWritten - 2));
+  char temp[10] = {};
+  EXPECT_TRUE(restored.getString("second", temp, 10));
+  EXPECT_STREQ(temp, "text");
+  uint8_t result = 0;
+  EXPECT_FALSE(restored.getUInt8("first", &result));
+
+  // unknown data type
+  buffer[SUPLA_STORAGE_KEY_SIZE] = 0x7F;
+  KeyValueTest broken;
+  EXPECT_FALSE(broken.initFromMemory(buffer, dataWritten));
+}
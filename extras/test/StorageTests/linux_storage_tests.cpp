@@ -0,0 +1,266 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <linux_storage.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+
+namespace {
+
+class LinuxStorageForTest : public Supla::LinuxStorage {
+ public:
+  explicit LinuxStorageForTest(const std::string &path)
+      : Supla::LinuxStorage(path) {
+  }
+
+  using Supla::LinuxStorage::readStorage;
+  using Supla::LinuxStorage::writeStorage;
+
+  // Simulates short write (i.e. full disk): only part of data is written
+  bool writeJournal(const unsigned char *data, size_t size) override {
+    if (failWrites > 0) {
+      failWrites--;
+      EXPECT_EQ(write(journalFd, data, size / 2),
+                static_cast<ssize_t>(size / 2));
+      errno = ENOSPC;
+      return false;
+    }
+    return Supla::LinuxStorage::writeJournal(data, size);
+  }
+
+  int failWrites = 0;
+};
+
+class LinuxStorageTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char pattern[] = "/tmp/supla_storage_XXXXXX";
+    ASSERT_NE(mkdtemp(pattern), nullptr);
+    path = pattern;
+  }
+
+  void TearDown() override {
+    std::filesystem::remove_all(path);
+  }
+
+  uint64_t fileSize(const char *name) {
+    return std::filesystem::file_size(path + "/" + name);
+  }
+
+  bool fileExists(const char *name) {
+    return std::filesystem::exists(path + "/" + name);
+  }
+
+  std::string path;
+};
+
+void writeString(LinuxStorageForTest *storage, int offset, const char *text) {
+  storage->writeStorage(offset,
+                        reinterpret_cast<const unsigned char *>(text),
+                        strlen(text) + 1);
+}
+
+std::string readString(LinuxStorageForTest *storage, int offset, int size) {
+  char buf[64] = {};
+  storage->readStorage(
+      offset, reinterpret_cast<unsigned char *>(buf), size, false);
+  return std::string(buf);
+}
+
+}  // namespace
+
+TEST_F(LinuxStorageTests, DataIsPersistedByJournal) {
+  {
+    LinuxStorageForTest storage(path);
+    EXPECT_TRUE(storage.init());
+    writeString(&storage, 100, "counter 1");
+    writeString(&storage, 200, "relay on");
+    storage.commit();
+    EXPECT_GT(storage.getJournalSize(), 0);
+    EXPECT_FALSE(fileExists("storage.bin"));
+  }
+
+  LinuxStorageForTest storage(path);
+  EXPECT_TRUE(storage.init());
+  EXPECT_EQ(readString(&storage, 100, 10), "counter 1");
+  EXPECT_EQ(readString(&storage, 200, 9), "relay on");
+  // not initialized area is read as zeros
+  EXPECT_EQ(readString(&storage, 1000, 10), "");
+}
+
+TEST_F(LinuxStorageTests, CommitAppendsOnlyChangedData) {
+  LinuxStorageForTest storage(path);
+  EXPECT_TRUE(storage.init());
+  storage.commit();
+  auto initialSize = storage.getJournalSize();
+
+  writeString(&storage, 100, "abc");
+  storage.commit();
+  auto recordSize = storage.getJournalSize() - initialSize;
+  // record header + 4 bytes of data
+  EXPECT_LT(recordSize, 32);
+
+  // nothing written - nothing appended
+  storage.commit();
+  EXPECT_EQ(storage.getJournalSize(), initialSize + recordSize);
+}
+
+TEST_F(LinuxStorageTests, IncompleteRecordIsDroppedOnLoad) {
+  uint64_t validSize = 0;
+  {
+    LinuxStorageForTest storage(path);
+    EXPECT_TRUE(storage.init());
+    writeString(&storage, 10, "first");
+    storage.commit();
+    validSize = storage.getJournalSize();
+    writeString(&storage, 10, "second");
+    storage.commit();
+  }
+
+  // simulate crash during write of last record
+  std::filesystem::resize_file(path + "/storage.journal",
+                               fileSize("storage.journal") - 3);
+
+  {
+    LinuxStorageForTest storage(path);
+    EXPECT_TRUE(storage.init());
+    EXPECT_EQ(readString(&storage, 10, 6), "first");
+    EXPECT_EQ(fileSize("storage.journal"), validSize);
+    // journal is still usable after dropping broken record
+    writeString(&storage, 10, "third");
+    storage.commit();
+  }
+
+  LinuxStorageForTest storage(path);
+  EXPECT_TRUE(storage.init());
+  EXPECT_EQ(readString(&storage, 10, 6), "third");
+}
+
+TEST_F(LinuxStorageTests, FailedWriteDoesNotBreakLaterRecords) {
+  {
+    LinuxStorageForTest storage(path);
+    EXPECT_TRUE(storage.init());
+    writeString(&storage, 10, "first");
+    storage.commit();
+    auto validSize = storage.getJournalSize();
+
+    storage.failWrites = 1;
+    writeString(&storage, 30, "second");
+    storage.commit();
+    // broken record is removed from journal
+    EXPECT_EQ(storage.getJournalSize(), validSize);
+    EXPECT_EQ(fileSize("storage.journal"), validSize);
+
+    // data which wasn't saved is written with next commit
+    writeString(&storage, 50, "third");
+    storage.commit();
+    EXPECT_GT(storage.getJournalSize(), validSize);
+  }
+
+  LinuxStorageForTest storage(path);
+  EXPECT_TRUE(storage.init());
+  EXPECT_EQ(readString(&storage, 10, 6), "first");
+  EXPECT_EQ(readString(&storage, 30, 7), "second");
+  EXPECT_EQ(readString(&storage, 50, 6), "third");
+}
+
+TEST_F(LinuxStorageTests, CompactionWritesSnapshotAndResetsJournal) {
+  {
+    LinuxStorageForTest storage(path);
+    storage.setCompactionThreshold(256);
+    EXPECT_TRUE(storage.init());
+    char text[16] = {};
+    for (int i = 0; i < 100; i++) {
+      snprintf(text, sizeof(text), "value %d", i);
+      writeString(&storage, 50, text);
+      storage.commit();
+    }
+    storage.waitForCompaction();
+    EXPECT_GT(storage.getCompactionCount(), 0);
+    EXPECT_LT(storage.getJournalSize(), 256);
+    EXPECT_TRUE(fileExists("storage.bin"));
+    EXPECT_FALSE(fileExists("storage.journal.old"));
+  }
+
+  LinuxStorageForTest storage(path);
+  EXPECT_TRUE(storage.init());
+  EXPECT_EQ(readString(&storage, 50, 10), "value 99");
+}
+
+TEST_F(LinuxStorageTests, InterruptedCompactionIsFinishedOnLoad) {
+  {
+    LinuxStorageForTest storage(path);
+    EXPECT_TRUE(storage.init());
+    writeString(&storage, 100, "old data");
+    storage.commit();
+  }
+  // journal was rotated, but snapshot wasn't written
+  std::filesystem::rename(path + "/storage.journal",
+                          path + "/storage.journal.old");
+  {
+    LinuxStorageForTest storage(path);
+    EXPECT_TRUE(storage.init());
+    EXPECT_EQ(readString(&storage, 100, 9), "old data");
+    EXPECT_FALSE(fileExists("storage.journal.old"));
+    EXPECT_TRUE(fileExists("storage.bin"));
+  }
+
+  LinuxStorageForTest storage(path);
+  EXPECT_TRUE(storage.init());
+  EXPECT_EQ(readString(&storage, 100, 9), "old data");
+}
+
+TEST_F(LinuxStorageTests, ElementStateWithInvalidCrcIsNotLoaded) {
+  const unsigned char state[] = {1, 2, 3, 4, 5, 6, 7, 8};
+  {
+    LinuxStorageForTest storage(path);
+    EXPECT_TRUE(storage.init());
+    EXPECT_TRUE(Supla::Storage::PrepareState());
+    EXPECT_TRUE(Supla::Storage::WriteState(state, sizeof(state)));
+    EXPECT_TRUE(Supla::Storage::FinalizeSaveState());
+  }
+
+  {
+    LinuxStorageForTest storage(path);
+    EXPECT_TRUE(storage.init());
+    EXPECT_TRUE(Supla::Storage::PrepareState(true));
+    EXPECT_TRUE(Supla::Storage::WriteState(state, sizeof(state)));
+    EXPECT_TRUE(Supla::Storage::FinalizeSaveState());
+
+    unsigned char loaded[sizeof(state)] = {};
+    EXPECT_TRUE(Supla::Storage::PrepareState());
+    EXPECT_TRUE(Supla::Storage::ReadState(loaded, sizeof(loaded)));
+    EXPECT_EQ(memcmp(loaded, state, sizeof(state)), 0);
+
+    // modify last byte of state section without updating its CRC
+    unsigned char broken = 0xFF;
+    int offset = sizeof(Supla::Preamble) + sizeof(Supla::SectionPreamble) +
+                 sizeof(state) - 1;
+    storage.writeStorage(offset, &broken, 1);
+    storage.commit();
+  }
+
+  LinuxStorageForTest storage(path);
+  EXPECT_TRUE(storage.init());
+  EXPECT_TRUE(Supla::Storage::PrepareState(true));
+  EXPECT_TRUE(Supla::Storage::WriteState(state, sizeof(state)));
+  EXPECT_FALSE(Supla::Storage::FinalizeSaveState());
+}
@@ -0,0 +1,457 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <SuplaDevice.h>
+#include <arduino_mock.h>
+#include <supla/control/virtual_relay.h>
+#include <supla/element.h>
+#include <supla/storage/storage.h>
+#include <string.h>
+
+namespace {
+
+class RamStorage : public Supla::Storage {
+ public:
+  RamStorage() {
+    memset(data, 0, sizeof(data));
+    memset(wear, 0, sizeof(wear));
+  }
+
+  // Returns the highest number of writes of single byte in given range
+  int maxWear(unsigned int offset, unsigned int size) {
+    int result = 0;
+    for (unsigned int i = offset; i < offset + size; i++) {
+      if (wear[i] > result) {
+        result = wear[i];
+      }
+    }
+    return result;
+  }
+
+  void commit() override {
+    commitCount++;
+  }
+
+  int readStorage(unsigned int offset,
+                  unsigned char *buf,
+                  int size,
+                  bool logs) override {
+    (void)(logs);
+    memcpy(buf, data + offset, size);
+    return size;
+  }
+
+  int writeStorage(unsigned int offset,
+                   const unsigned char *buf,
+                   int size) override {
+    memcpy(data + offset, buf, size);
+    for (int i = 0; i < size; i++) {
+      wear[offset + i]++;
+    }
+    writtenBytes += size;
+    return size;
+  }
+
+  unsigned char data[512];
+  // simulated wear - number of writes of each byte
+  int wear[512];
+  int commitCount = 0;
+  int writtenBytes = 0;
+};
+
+class CounterElement : public Supla::Element {
+ public:
+  explicit CounterElement(bool tracked) : tracked(tracked) {
+  }
+
+  void onSaveState() override {
+    saveCount++;
+    Supla::Storage::WriteState(reinterpret_cast<unsigned char *>(&counter),
+                               sizeof(counter));
+  }
+
+  void onLoadState() override {
+    Supla::Storage::ReadState(reinterpret_cast<unsigned char *>(&counter),
+                              sizeof(counter));
+  }
+
+  bool isStateDirtyTracked() override {
+    return tracked;
+  }
+
+  void inc() {
+    counter++;
+    setStateDirty();
+  }
+
+  bool tracked;
+  uint64_t counter = 0;
+  int saveCount = 0;
+};
+
+class StatelessElement : public Supla::Element {};
+
+// Storage validation performed by SuplaDevice.begin()
+bool validateStorage() {
+  Supla::Storage::PrepareState(true);
+  for (auto element = Supla::Element::begin(); element != nullptr;
+       element = element->next()) {
+    Supla::Storage::BeginElementState();
+    element->onSaveState();
+    if (Supla::Storage::IsElementStateEmpty()) {
+      element->setStateDirty(false);
+    }
+  }
+  return Supla::Storage::FinalizeSaveState();
+}
+
+bool loadState() {
+  if (!validateStorage()) {
+    return false;
+  }
+  Supla::Storage::PrepareState();
+  for (auto element = Supla::Element::begin(); element != nullptr;
+       element = element->next()) {
+    element->onLoadState();
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(StorageStateTests, SaveIsSkippedWhenNoStateIsDirty) {
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  StatelessElement stateless;
+  CounterElement first(true);
+  CounterElement second(true);
+
+  EXPECT_TRUE(storage.init());
+  validateStorage();
+  first.saveCount = second.saveCount = 0;
+
+  // initial save writes all elements
+  sd.saveStateToStorage();
+  EXPECT_EQ(first.saveCount, 1);
+  EXPECT_EQ(second.saveCount, 1);
+  EXPECT_EQ(storage.commitCount, 2);
+
+  sd.saveStateToStorage();
+  EXPECT_EQ(first.saveCount, 1);
+  EXPECT_EQ(second.saveCount, 1);
+  EXPECT_EQ(storage.commitCount, 2);
+}
+
+TEST(StorageStateTests, OnlyDirtySliceIsWritten) {
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  CounterElement first(true);
+  CounterElement second(true);
+  CounterElement third(true);
+
+  EXPECT_TRUE(storage.init());
+  validateStorage();
+  first.saveCount = second.saveCount = third.saveCount = 0;
+  sd.saveStateToStorage();
+
+  second.counter = 0x0102;
+  second.setStateDirty();
+  storage.writtenBytes = 0;
+  sd.saveStateToStorage();
+  EXPECT_EQ(first.saveCount, 1);
+  EXPECT_EQ(second.saveCount, 2);
+  EXPECT_EQ(third.saveCount, 1);
+  // only second counter and section preamble with new CRC are written
+  int expectedBytes = sizeof(uint64_t) + sizeof(Supla::SectionPreamble);
+  EXPECT_EQ(storage.writtenBytes, expectedBytes);
+
+  // skipped slices are kept and CRC of whole section is valid
+  first.counter = 0;
+  second.counter = 0;
+  third.counter = 0;
+  EXPECT_TRUE(storage.init());
+  EXPECT_TRUE(loadState());
+  EXPECT_EQ(second.counter, 0x0102);
+}
+
+TEST(StorageStateTests, NotTrackedElementIsAlwaysSaved) {
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  CounterElement tracked(true);
+  CounterElement notTracked(false);
+
+  EXPECT_TRUE(storage.init());
+  validateStorage();
+  tracked.saveCount = notTracked.saveCount = 0;
+
+  sd.saveStateToStorage();
+  sd.saveStateToStorage();
+  EXPECT_EQ(tracked.saveCount, 1);
+  EXPECT_EQ(notTracked.saveCount, 2);
+  EXPECT_EQ(storage.commitCount, 3);
+}
+
+TEST(StorageStateTests, SlicesAreNotSkippedWithoutValidation) {
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  CounterElement first(true);
+  CounterElement second(true);
+
+  EXPECT_TRUE(storage.init());
+  sd.saveStateToStorage();
+  first.inc();
+  sd.saveStateToStorage();
+  // without dry run offsets of elements are unknown, so all are written
+  EXPECT_EQ(first.saveCount, 2);
+  EXPECT_EQ(second.saveCount, 2);
+}
+
+TEST(StorageStateTests, StateLogSpreadsWearOverArea) {
+  const int saves = 1400;
+  int sectionWear = 0;
+  {
+    SuplaDeviceClass sd;
+    RamStorage storage;
+    CounterElement counter(true);
+    EXPECT_TRUE(storage.init());
+    validateStorage();
+    for (int i = 0; i < saves; i++) {
+      counter.inc();
+      sd.saveStateToStorage();
+    }
+    sectionWear = storage.maxWear(0, sizeof(storage.data));
+  }
+
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  CounterElement counter(true);
+  storage.setStateLogArea(256, 256);
+  EXPECT_TRUE(storage.init());
+  validateStorage();
+  for (int i = 0; i < saves; i++) {
+    counter.inc();
+    sd.saveStateToStorage();
+  }
+  EXPECT_EQ(sectionWear, saves);
+  // 18 B records: 14 of them fit in area
+  int logWear = storage.maxWear(256, 256);
+  EXPECT_LE(logWear, saves / 14 + 1);
+  // nothing is written outside of log area, except storage preamble
+  int preambleSize = sizeof(Supla::Preamble);
+  EXPECT_EQ(storage.maxWear(preambleSize, 256 - preambleSize), 0);
+
+  counter.counter = 0;
+  EXPECT_TRUE(storage.init());
+  EXPECT_TRUE(loadState());
+  EXPECT_EQ(counter.counter, saves);
+}
+
+TEST(StorageStateTests, StateLogFallsBackToPreviousRecord) {
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  CounterElement counter(true);
+  storage.setStateLogArea(100, 100);
+  EXPECT_TRUE(storage.init());
+  EXPECT_FALSE(validateStorage());
+
+  // 5 records fit in area, so the newest one is after wrap
+  for (int i = 0; i < 7; i++) {
+    counter.inc();
+    sd.saveStateToStorage();
+  }
+  counter.counter = 0;
+  EXPECT_TRUE(storage.init());
+  EXPECT_TRUE(loadState());
+  EXPECT_EQ(counter.counter, 7);
+
+  // newest record is at offset 100 + 18; break its data
+  storage.data[100 + 18 + sizeof(Supla::StateLogRecord)] ^= 0xFF;
+  counter.counter = 0;
+  EXPECT_TRUE(storage.init());
+  EXPECT_TRUE(loadState());
+  EXPECT_EQ(counter.counter, 6);
+
+  // next record is written after the loaded one
+  counter.inc();
+  sd.saveStateToStorage();
+  counter.counter = 0;
+  EXPECT_TRUE(storage.init());
+  EXPECT_TRUE(loadState());
+  EXPECT_EQ(counter.counter, 7);
+}
+
+TEST(StorageStateTests, StateLogRecordWithDifferentSizeIsNotLoaded) {
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  storage.setStateLogArea(100, 200);
+  EXPECT_TRUE(storage.init());
+  {
+    CounterElement counter(true);
+    validateStorage();
+    counter.inc();
+    sd.saveStateToStorage();
+  }
+
+  CounterElement first(true);
+  CounterElement second(true);
+  EXPECT_TRUE(storage.init());
+  EXPECT_FALSE(validateStorage());
+}
+
+TEST(StorageStateTests, StateLogAreaOverlappingSectionsIsRejected) {
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  CounterElement counter(true);
+  EXPECT_TRUE(storage.init());
+  validateStorage();
+  counter.inc();
+  sd.saveStateToStorage();
+
+  // area starts inside of element state section
+  storage.setStateLogArea(sizeof(Supla::Preamble) + 4, 200);
+  counter.counter = 0;
+  EXPECT_TRUE(storage.init());
+  // state is loaded from section, not from empty log area
+  EXPECT_TRUE(loadState());
+  EXPECT_EQ(counter.counter, 1);
+
+  counter.inc();
+  sd.saveStateToStorage();
+  counter.counter = 0;
+  EXPECT_TRUE(storage.init());
+  EXPECT_TRUE(loadState());
+  EXPECT_EQ(counter.counter, 2);
+}
+
+TEST(StorageStateTests, TooSmallStateLogAreaIsRejected) {
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  CounterElement counter(true);
+  storage.setStateLogArea(256, sizeof(Supla::StateLogRecord));
+  EXPECT_TRUE(storage.init());
+  validateStorage();
+  counter.inc();
+  sd.saveStateToStorage();
+
+  EXPECT_EQ(storage.maxWear(256, sizeof(Supla::StateLogRecord)), 0);
+  counter.counter = 0;
+  EXPECT_TRUE(storage.init());
+  EXPECT_TRUE(loadState());
+  EXPECT_EQ(counter.counter, 1);
+}
+
+namespace {
+
+// Simulates impulse counted in timer interrupt while state is saved
+class CounterChangedDuringSave : public CounterElement {
+ public:
+  CounterChangedDuringSave() : CounterElement(true) {
+  }
+
+  void onSaveState() override {
+    CounterElement::onSaveState();
+    if (incDuringSave) {
+      incDuringSave = false;
+      inc();
+    }
+  }
+
+  bool incDuringSave = false;
+};
+
+class FailingRamStorage : public RamStorage {
+ public:
+  bool finalizeSaveState() override {
+    bool result = RamStorage::finalizeSaveState();
+    return fail ? false : result;
+  }
+
+  bool fail = false;
+};
+
+}  // namespace
+
+TEST(StorageStateTests, ChangeDuringSaveKeepsStateDirty) {
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  CounterChangedDuringSave counter;
+
+  EXPECT_TRUE(storage.init());
+  validateStorage();
+  sd.saveStateToStorage();
+  EXPECT_FALSE(counter.isStateDirty());
+
+  counter.inc();
+  counter.incDuringSave = true;
+  sd.saveStateToStorage();
+  EXPECT_TRUE(counter.isStateDirty());
+
+  counter.saveCount = 0;
+  sd.saveStateToStorage();
+  EXPECT_EQ(counter.saveCount, 1);
+  EXPECT_FALSE(counter.isStateDirty());
+}
+
+TEST(StorageStateTests, FailedSaveKeepsStateDirty) {
+  SuplaDeviceClass sd;
+  FailingRamStorage storage;
+  CounterElement first(true);
+  CounterElement second(true);
+
+  EXPECT_TRUE(storage.init());
+  validateStorage();
+  sd.saveStateToStorage();
+
+  first.inc();
+  storage.fail = true;
+  sd.saveStateToStorage();
+  EXPECT_TRUE(first.isStateDirty());
+  EXPECT_TRUE(second.isStateDirty());
+
+  storage.fail = false;
+  first.saveCount = 0;
+  sd.saveStateToStorage();
+  EXPECT_EQ(first.saveCount, 1);
+  EXPECT_FALSE(first.isStateDirty());
+  EXPECT_FALSE(second.isStateDirty());
+}
+
+TEST(StorageStateTests, RelayStateIsSavedOnlyAfterChange) {
+  ::testing::NiceMock<TimeInterfaceMock> time;
+  SuplaDeviceClass sd;
+  RamStorage storage;
+  Supla::Control::VirtualRelay relay;
+  relay.setDefaultStateRestore();
+
+  EXPECT_TRUE(storage.init());
+  validateStorage();
+  sd.saveStateToStorage();
+  EXPECT_FALSE(relay.isStateDirty());
+
+  relay.turnOn();
+  EXPECT_TRUE(relay.isStateDirty());
+  storage.writtenBytes = 0;
+  sd.saveStateToStorage();
+  EXPECT_GT(storage.writtenBytes, 0);
+  EXPECT_FALSE(relay.isStateDirty());
+
+  storage.writtenBytes = 0;
+  sd.saveStateToStorage();
+  EXPECT_EQ(storage.writtenBytes, 0);
+}
@@ -21,6 +21,7 @@
 #include <timer_mock.h>
 #include <SuplaDevice.h>
 #include <supla/clock/clock.h>
+#include <supla/channel_element.h>
 #include <supla/storage/storage.h>
 #include <element_mock.h>
 #include <board_mock.h>
@@ -250,6 +251,216 @@ TEST_F(SuplaDeviceTestsFullStartup, SuccessfulStartup) {
   EXPECT_EQ(sd.getCurrentStatus(), STATUS_REGISTERED_AND_READY);
 }
 
+class ChannelElementMock : public Supla::ChannelElement {
+ public:
+  ChannelElementMock() {
+    useChannelUpdateIteration();
+  }
+  MOCK_METHOD(bool, iterateConnected, (void *), (override));
+
+  Supla::Channel *getChannelPtr() {
+    return &channel;
+  }
+};
+
+TEST_F(SuplaDeviceTestsFullStartup,
+    ChannelElementIsIteratedOnlyWithPendingUpdate) {
+  ChannelElementMock chEl;
+  bool isConnected = false;
+  EXPECT_CALL(net, isReady()).WillRepeatedly(Return(true));
+  EXPECT_CALL(*client, connected()).WillRepeatedly(ReturnPointee(&isConnected));
+  EXPECT_CALL(*client, connectImp(_, _))
+      .WillRepeatedly(DoAll(Assign(&isConnected, true), Return(1)));
+
+  EXPECT_CALL(net, iterate()).Times(AtLeast(1));
+  EXPECT_CALL(srpc, srpc_iterate(_)).WillRepeatedly(Return(SUPLA_RESULT_TRUE));
+  EXPECT_CALL(el1, iterateAlways()).Times(AtLeast(1));
+  EXPECT_CALL(el2, iterateAlways()).Times(AtLeast(1));
+  EXPECT_CALL(el1, onRegistered());
+  EXPECT_CALL(el2, onRegistered());
+  EXPECT_CALL(srpc, srpc_ds_async_registerdevice_e(_, _)).Times(1);
+  EXPECT_CALL(srpc, srpc_dcs_async_set_activity_timeout(_, _)).Times(1);
+  EXPECT_CALL(srpc, srpc_dcs_async_ping_server(_)).Times(AtLeast(0));
+  EXPECT_CALL(el1, iterateConnected(_)).WillRepeatedly(Return(true));
+  EXPECT_CALL(el2, iterateConnected(_)).WillRepeatedly(Return(true));
+
+  for (int i = 0; i < 5; i++) {
+    sd.iterate();
+    time.advance(1000);
+  }
+
+  TSD_SuplaRegisterDeviceResult register_device_result{};
+  register_device_result.result_code = SUPLA_RESULTCODE_TRUE;
+  register_device_result.activity_timeout = 45;
+  register_device_result.version = 16;
+  register_device_result.version_min = 1;
+
+  sd.getSrpcLayer()->onRegisterResult(&register_device_result);
+  EXPECT_EQ(sd.getCurrentStatus(), STATUS_REGISTERED_AND_READY);
+
+  // nothing to send
+  EXPECT_CALL(chEl, iterateConnected(_)).Times(0);
+  for (int i = 0; i < 5; i++) {
+    sd.iterate();
+    time.advance(100);
+  }
+  ::testing::Mock::VerifyAndClearExpectations(&chEl);
+
+  // value changed, so element is iterated until channel update is sent
+  chEl.getChannelPtr()->setNewValue(true);
+  EXPECT_CALL(chEl, iterateConnected(_))
+      .WillOnce(Return(true))
+      .WillOnce([&chEl](void *) {
+        chEl.getChannelPtr()->clearUpdateReady();
+        return false;
+      });
+  for (int i = 0; i < 5; i++) {
+    sd.iterate();
+    time.advance(100);
+  }
+  EXPECT_EQ(Supla::Channel::getFirstPendingUpdate(), nullptr);
+}
+
+class SimpleChannelElement : public Supla::ChannelElement {
+ public:
+  SimpleChannelElement() {
+    useChannelUpdateIteration();
+  }
+  Supla::Channel *getChannelPtr() {
+    return &channel;
+  }
+};
+
+TEST_F(SuplaDeviceTestsFullStartup, UplinkBatchingSendsChannelsInOneWrite) {
+  SimpleChannelElement ch1;
+  SimpleChannelElement ch2;
+  SimpleChannelElement ch3;
+  bool isConnected = false;
+  EXPECT_CALL(net, isReady()).WillRepeatedly(Return(true));
+  EXPECT_CALL(*client, connected()).WillRepeatedly(ReturnPointee(&isConnected));
+  EXPECT_CALL(*client, connectImp(_, _))
+      .WillRepeatedly(DoAll(Assign(&isConnected, true), Return(1)));
+
+  EXPECT_CALL(net, iterate()).Times(AtLeast(1));
+  EXPECT_CALL(srpc, srpc_iterate(_)).WillRepeatedly(Return(SUPLA_RESULT_TRUE));
+  EXPECT_CALL(el1, iterateAlways()).Times(AtLeast(1));
+  EXPECT_CALL(el2, iterateAlways()).Times(AtLeast(1));
+  EXPECT_CALL(el1, onRegistered());
+  EXPECT_CALL(el2, onRegistered());
+  EXPECT_CALL(srpc, srpc_ds_async_registerdevice_e(_, _)).Times(1);
+  EXPECT_CALL(srpc, srpc_dcs_async_set_activity_timeout(_, _)).Times(1);
+  EXPECT_CALL(srpc, srpc_dcs_async_ping_server(_)).Times(AtLeast(0));
+  EXPECT_CALL(el1, iterateConnected(_)).WillRepeatedly(Return(true));
+  EXPECT_CALL(el2, iterateConnected(_)).WillRepeatedly(Return(true));
+
+  auto srpcLayer = sd.getSrpcLayer();
+  srpcLayer->setUplinkBatching(50, 10);
+
+  for (int i = 0; i < 5; i++) {
+    sd.iterate();
+    time.advance(1000);
+  }
+
+  TSD_SuplaRegisterDeviceResult register_device_result{};
+  register_device_result.result_code = SUPLA_RESULTCODE_TRUE;
+  register_device_result.activity_timeout = 45;
+  register_device_result.version = 16;
+  register_device_result.version_min = 1;
+  srpcLayer->onRegisterResult(&register_device_result);
+
+  // each value update is "serialized" by srpc as 40 bytes packet
+  EXPECT_CALL(srpc, valueChanged(_, _, _, _, _))
+      .Times(3)
+      .WillRepeatedly([srpcLayer](void *,
+                                  unsigned char,
+                                  std::vector<char>,
+                                  unsigned char,
+                                  unsigned _supla_int_t) {
+        char packet[40] = {};
+        return Supla::dataWrite(packet, sizeof(packet), srpcLayer);
+      });
+  EXPECT_CALL(*client, writeImp(_, 120)).WillOnce(Return(120));
+
+  ch1.getChannelPtr()->setNewValue(true);
+  ch2.getChannelPtr()->setNewValue(true);
+  ch3.getChannelPtr()->setNewValue(true);
+
+  // all updates are collected in first iteration, and sent after 50 ms
+  for (int i = 0; i < 10; i++) {
+    sd.iterate();
+    time.advance(10);
+  }
+
+  EXPECT_EQ(srpcLayer->getUplinkBatchSavedWrites(), 2);
+  // batching doesn't change amount of data sent without TLS
+  EXPECT_EQ(srpcLayer->getUplinkBatchEstimatedTlsSavedBytes(), 0);
+  client->setSSLEnabled(true);
+  EXPECT_EQ(srpcLayer->getUplinkBatchEstimatedTlsSavedBytes(),
+            2 * SUPLA_UPLINK_BATCH_TLS_RECORD_OVERHEAD);
+}
+
+TEST_F(SuplaDeviceTestsFullStartup, UplinkBatchingPartialWriteDisconnects) {
+  SimpleChannelElement ch1;
+  SimpleChannelElement ch2;
+  bool isConnected = false;
+  EXPECT_CALL(net, isReady()).WillRepeatedly(Return(true));
+  EXPECT_CALL(*client, connected()).WillRepeatedly(ReturnPointee(&isConnected));
+  EXPECT_CALL(*client, connectImp(_, _))
+      .WillRepeatedly(DoAll(Assign(&isConnected, true), Return(1)));
+
+  EXPECT_CALL(net, iterate()).Times(AtLeast(1));
+  EXPECT_CALL(srpc, srpc_iterate(_)).WillRepeatedly(Return(SUPLA_RESULT_TRUE));
+  EXPECT_CALL(el1, iterateAlways()).Times(AtLeast(1));
+  EXPECT_CALL(el2, iterateAlways()).Times(AtLeast(1));
+  EXPECT_CALL(el1, onRegistered());
+  EXPECT_CALL(el2, onRegistered());
+  EXPECT_CALL(srpc, srpc_ds_async_registerdevice_e(_, _)).Times(1);
+  EXPECT_CALL(srpc, srpc_dcs_async_set_activity_timeout(_, _)).Times(1);
+  EXPECT_CALL(srpc, srpc_dcs_async_ping_server(_)).Times(AtLeast(0));
+  EXPECT_CALL(el1, iterateConnected(_)).WillRepeatedly(Return(true));
+  EXPECT_CALL(el2, iterateConnected(_)).WillRepeatedly(Return(true));
+
+  auto srpcLayer = sd.getSrpcLayer();
+  srpcLayer->setUplinkBatching(50, 10);
+
+  for (int i = 0; i < 5; i++) {
+    sd.iterate();
+    time.advance(1000);
+  }
+
+  TSD_SuplaRegisterDeviceResult register_device_result{};
+  register_device_result.result_code = SUPLA_RESULTCODE_TRUE;
+  register_device_result.activity_timeout = 45;
+  register_device_result.version = 16;
+  register_device_result.version_min = 1;
+  srpcLayer->onRegisterResult(&register_device_result);
+
+  EXPECT_CALL(srpc, valueChanged(_, _, _, _, _))
+      .Times(2)
+      .WillRepeatedly([srpcLayer](void *,
+                                  unsigned char,
+                                  std::vector<char>,
+                                  unsigned char,
+                                  unsigned _supla_int_t) {
+        char packet[40] = {};
+        return Supla::dataWrite(packet, sizeof(packet), srpcLayer);
+      });
+  // only part of the batch is sent
+  EXPECT_CALL(*client, writeImp(_, 80)).WillOnce(Return(50));
+  EXPECT_CALL(*client, stop()).WillOnce(Assign(&isConnected, false));
+
+  ch1.getChannelPtr()->setNewValue(true);
+  ch2.getChannelPtr()->setNewValue(true);
+
+  for (int i = 0; i < 10; i++) {
+    sd.iterate();
+    time.advance(10);
+  }
+
+  EXPECT_EQ(sd.getCurrentStatus(), STATUS_ITERATE_FAIL);
+  EXPECT_EQ(srpcLayer->getUplinkBatchSavedWrites(), 0);
+}
+
 TEST_F(SuplaDeviceTestsFullStartup, NoNetworkShouldCallSetupAgainAndResetDev) {
   EXPECT_CALL(net, isReady()).WillRepeatedly(Return(false));
   EXPECT_CALL(net, setup()).Times(1);
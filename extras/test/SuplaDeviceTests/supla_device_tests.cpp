@@ -359,10 +359,15 @@ TEST_F(SuplaDeviceTests, TwoChannelElementsNoNetworkWithStorage) {
   ElementMock el1;
   ElementMock el2;
   int dummy;
+  // elements which don't write any state are not saved periodically
+  auto writeState = []() {
+    unsigned char state = 0;
+    Supla::Storage::WriteState(&state, sizeof(state));
+  };
   EXPECT_CALL(storage, prepareState(true)).WillOnce(Return(true));
   EXPECT_CALL(storage, init());
-  EXPECT_CALL(el1, onSaveState());
-  EXPECT_CALL(el2, onSaveState());
+  EXPECT_CALL(el1, onSaveState()).WillOnce(writeState);
+  EXPECT_CALL(el2, onSaveState()).WillOnce(writeState);
 
   EXPECT_CALL(storage, finalizeSaveState()).WillOnce(Return(true));
   EXPECT_CALL(storage, prepareState(false));
@@ -0,0 +1,66 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <supla/crc16.h>
+#include <stdlib.h>
+#include <string.h>
+
+TEST(Crc16Tests, KnownAnswers) {
+  const char *check = "123456789";
+  // CRC-16/MODBUS
+  EXPECT_EQ(crc16_update_buf_bitwise(0xFFFF, check, 9), 0x4B37);
+  EXPECT_EQ(crc16_update_buf_table(0xFFFF, check, 9), 0x4B37);
+  EXPECT_EQ(crc16_update_buf_slicing_by_8(0xFFFF, check, 9), 0x4B37);
+  EXPECT_EQ(crc16_update_buf(0xFFFF, check, 9), 0x4B37);
+  // CRC-16/ARC
+  EXPECT_EQ(crc16_update_buf(0, check, 9), 0xBB3D);
+
+  uint16_t crc = 0xFFFF;
+  for (int i = 0; i < 9; i++) {
+    crc = crc16_update(crc, check[i]);
+  }
+  EXPECT_EQ(crc, 0x4B37);
+
+  EXPECT_EQ(crc16_update_buf(0x1234, check, 0), 0x1234);
+}
+
+TEST(Crc16Tests, AllImplementationsMatchBitwise) {
+  unsigned char data[300];
+  srand(1);
+  for (auto &byte : data) {
+    byte = rand() % 256;
+  }
+
+  // all lengths and misaligned starts, so all tail paths are checked
+  for (int start = 0; start < 8; start++) {
+    for (size_t size = 0; size + start <= sizeof(data); size++) {
+      uint16_t expected = crc16_update_buf_bitwise(0xFFFF, data + start, size);
+      ASSERT_EQ(crc16_update_buf_table(0xFFFF, data + start, size), expected);
+      ASSERT_EQ(crc16_update_buf_slicing_by_8(0xFFFF, data + start, size),
+                expected);
+    }
+  }
+
+  // calculation may be split at any point
+  uint16_t whole = crc16_update_buf(0xFFFF, data, sizeof(data));
+  for (size_t split = 0; split <= sizeof(data); split += 13) {
+    uint16_t crc = crc16_update_buf(0xFFFF, data, split);
+    crc = crc16_update_buf(crc, data + split, sizeof(data) - split);
+    EXPECT_EQ(crc, whole);
+  }
+}
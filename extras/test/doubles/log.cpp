@@ -16,6 +16,12 @@
 
 #include <supla-common/log.h>
 
+int supla_log_level = 8;  // LOG_VERBOSE
+
+void supla_log_set_level(int level) {
+  supla_log_level = level;
+}
+
 void supla_log(int __pri, const char *__fmt, ...) {
   return;
 }
@@ -25,6 +25,10 @@ _supla_int_t srpc_ds_async_channel_extendedvalue_changed(
   return 0;
 }
 
+char srpc_input_dataexists(void *_srpc) {
+  return SUPLA_RESULT_FALSE;
+}
+
 _supla_int_t srpc_ds_async_action_trigger(void *_srpc, TDS_ActionTrigger *at) {
   assert(SrpcInterface::instance);
   return SrpcInterface::instance->actionTrigger(at->ChannelNumber,
@@ -170,7 +170,12 @@ bool SuplaDeviceClass::begin(unsigned char protoVersion) {
         "Validating storage state section with current device configuration");
     for (auto element = Supla::Element::begin(); element != nullptr;
          element = element->next()) {
+      Supla::Storage::BeginElementState();
       element->onSaveState();
+      if (Supla::Storage::IsElementStateEmpty()) {
+        // element without state doesn't have to be saved
+        element->setStateDirty(false);
+      }
       delay(0);
     }
     // If state storage validation was successful, perform read state
@@ -544,9 +549,17 @@ bool SuplaDeviceClass::loadDeviceConfig() {
 void SuplaDeviceClass::iterateAlwaysElements(uint64_t _millis) {
   uptime.iterate(_millis);
 
-  // Iterate all elements
-  for (auto element = Supla::Element::begin(); element != nullptr;
-       element = element->next()) {
+  // Iterate elements which require iteration on each loop
+  for (auto element = Supla::Element::beginAlwaysIterate(); element != nullptr;
+       element = element->nextAlwaysIterate()) {
+    element->iterateAlways();
+    delay(0);
+  }
+
+  // Iterate elements with passed deadline
+  for (auto element = Supla::Element::takeDueElements(_millis);
+       element != nullptr;
+       element = element->nextDue()) {
     element->iterateAlways();
     delay(0);
   }
@@ -683,13 +696,41 @@ int SuplaDeviceClass::handleCalcfgFromServer(TSD_DeviceCalCfgRequest *request) {
 }
 
 void SuplaDeviceClass::saveStateToStorage() {
+  bool dirty = false;
+  for (auto element = Supla::Element::begin(); element != nullptr;
+       element = element->next()) {
+    if (element->isStateDirty()) {
+      dirty = true;
+      break;
+    }
+  }
+  if (!dirty) {
+    return;
+  }
+
   Supla::Storage::PrepareState();
   for (auto element = Supla::Element::begin(); element != nullptr;
        element = element->next()) {
-    element->onSaveState();
+    Supla::Storage::BeginElementState();
+    if (element->isStateDirty() || !Supla::Storage::SkipElementState()) {
+      // flag is cleared before state is written, so change made in the
+      // meantime (i.e. impulse counted in timer interrupt) is saved next time
+      if (element->isStateDirtyTracked()) {
+        element->setStateDirty(false);
+      }
+      element->onSaveState();
+    }
     delay(0);
   }
-  Supla::Storage::FinalizeSaveState();
+  if (!Supla::Storage::FinalizeSaveState()) {
+    SUPLA_LOG_WARNING("Failed to save elements state");
+    for (auto element = Supla::Element::begin(); element != nullptr;
+         element = element->next()) {
+      if (element->isStateDirtyTracked()) {
+        element->setStateDirty();
+      }
+    }
+  }
 }
 
 int SuplaDeviceClass::generateHostname(char *buf, int macSize) {
@@ -59,6 +59,19 @@ static const char *SUPLA_TAG = "SUPLA";
 #include <android/log.h>
 #endif /*__ANDROID__*/
 
+#if defined(__linux__) && defined(__GNUC__) && !defined(__ANDROID__)
+// Messages are formatted in fixed, thread local buffer, so logging doesn't
+// allocate memory. Longer messages fall back to heap allocated buffer.
+#define SUPLA_LOG_BUFFER_SIZE 512
+static __thread char supla_log_buffer[SUPLA_LOG_BUFFER_SIZE];
+#endif /*defined(__linux__) && defined(__GNUC__) && !defined(__ANDROID__)*/
+
+int supla_log_level = 8;  // LOG_VERBOSE
+
+void LOG_ICACHE_FLASH supla_log_set_level(int level) {
+  supla_log_level = level;
+}
+
 #ifdef __LOG_CALLBACK
 _supla_log_callback __supla_log_callback = NULL;
 
@@ -254,11 +267,24 @@ void LOG_ICACHE_FLASH supla_log(int __pri, const char *__fmt, ...) {
 
 #if defined(ESP8266) || defined(ARDUINO) || defined(_WIN32) || \
   defined(SUPLA_DEVICE)
-  if (__fmt == NULL) return;
+  if (__fmt == NULL || __pri > supla_log_level) return;
 #else
-  if (__fmt == NULL || (debug_mode == 0 && __pri == LOG_DEBUG)) return;
+  if (__fmt == NULL || __pri > supla_log_level ||
+      (debug_mode == 0 && __pri == LOG_DEBUG))
+    return;
 #endif
 
+#ifdef SUPLA_LOG_BUFFER_SIZE
+  va_start(ap, __fmt);
+  size = vsnprintf(supla_log_buffer, SUPLA_LOG_BUFFER_SIZE, __fmt, ap);
+  va_end(ap);
+  if (size >= 0 && size < SUPLA_LOG_BUFFER_SIZE) {
+    supla_vlog(__pri, supla_log_buffer);
+    return;
+  }
+  size = 0;
+#endif /*SUPLA_LOG_BUFFER_SIZE*/
+
   while (1) {
     va_start(ap, __fmt);
     if (0 == supla_log_string(&buffer, &size, ap, __fmt)) {
@@ -62,6 +62,11 @@ typedef int (*_supla_log_callback)(int __pri, const char *message);
 void LOG_ICACHE_FLASH supla_log_set_callback(_supla_log_callback callback);
 #endif /*__LOG_CALLBACK*/
 
+// Messages with priority above supla_log_level are dropped before they are
+// formatted. Default is LOG_VERBOSE (all messages are passed to supla_vlog).
+extern int supla_log_level;
+
+void LOG_ICACHE_FLASH supla_log_set_level(int level);
 void LOG_ICACHE_FLASH supla_log(int __pri, const char *__fmt, ...);
 void LOG_ICACHE_FLASH supla_write_state_file(const char *file, int __pri,
                                              const char *__fmt, ...);
@@ -109,19 +109,18 @@ void sproto_free(void *spd_ptr) {
   }
 }
 
-unsigned char PROTO_ICACHE_FLASH sproto_buffer_append(
-    void *spd_ptr, char **buffer, unsigned _supla_int_t *buffer_size,
-    unsigned _supla_int_t *buffer_data_size, char *data,
-    unsigned _supla_int_t data_size) {
-  (void)(spd_ptr);
+static unsigned char PROTO_ICACHE_FLASH
+sproto_buffer_reserve(char **buffer, unsigned _supla_int_t *buffer_size,
+                      unsigned _supla_int_t buffer_data_size,
+                      unsigned _supla_int_t data_size) {
   unsigned _supla_int_t size = *buffer_size;
 
   if (size < BUFFER_MIN_SIZE) {
     size = BUFFER_MIN_SIZE;
   }
 
-  if (data_size > size - (*buffer_data_size)) {
-    size += data_size - (size - (*buffer_data_size));
+  if (data_size > size - buffer_data_size) {
+    size += data_size - (size - buffer_data_size);
   }
 
   if (size >= BUFFER_MAX_SIZE) return (SUPLA_RESULT_BUFFER_OVERFLOW);
@@ -139,11 +138,24 @@ unsigned char PROTO_ICACHE_FLASH sproto_buffer_append(
 #endif
 
     *buffer = new_buffer;
+    (*buffer_size) = size;
   }
 
-  memcpy(&(*buffer)[(*buffer_data_size)], data, data_size);
+  return (SUPLA_RESULT_TRUE);
+}
+
+unsigned char PROTO_ICACHE_FLASH sproto_buffer_append(
+    void *spd_ptr, char **buffer, unsigned _supla_int_t *buffer_size,
+    unsigned _supla_int_t *buffer_data_size, char *data,
+    unsigned _supla_int_t data_size) {
+  (void)(spd_ptr);
+  unsigned char result = sproto_buffer_reserve(buffer, buffer_size,
+                                               *buffer_data_size, data_size);
+  if (result != SUPLA_RESULT_TRUE) {
+    return result;
+  }
 
-  (*buffer_size) = size;
+  memcpy(&(*buffer)[(*buffer_data_size)], data, data_size);
   (*buffer_data_size) += data_size;
 
   return (SUPLA_RESULT_TRUE);
@@ -166,20 +178,24 @@ char PROTO_ICACHE_FLASH sproto_out_buffer_append(void *spd_ptr,
 
   if (packet_size > sdp_size) return SUPLA_RESULT_DATA_TOO_LARGE;
 
-  if (SUPLA_RESULT_TRUE ==
-      sproto_buffer_append(spd_ptr, &spd->out.buffer, &spd->out.size,
-                           &spd->out.data_size, (char *)sdp, packet_size)) {
-    return sproto_buffer_append(spd_ptr, &spd->out.buffer, &spd->out.size,
-                                &spd->out.data_size, sproto_tag,
-                                SUPLA_TAG_SIZE);
+  // header, used part of data and tag are copied with a single reservation
+  if (SUPLA_RESULT_TRUE !=
+      sproto_buffer_reserve(&spd->out.buffer, &spd->out.size,
+                            spd->out.data_size,
+                            packet_size + SUPLA_TAG_SIZE)) {
+    return (SUPLA_RESULT_FALSE);
   }
 
-  return (SUPLA_RESULT_FALSE);
+  memcpy(&spd->out.buffer[spd->out.data_size], sdp, packet_size);
+  memcpy(&spd->out.buffer[spd->out.data_size + packet_size], sproto_tag,
+         SUPLA_TAG_SIZE);
+  spd->out.data_size += packet_size + SUPLA_TAG_SIZE;
+
+  return (SUPLA_RESULT_TRUE);
 }
 
 unsigned _supla_int_t PROTO_ICACHE_FLASH sproto_pop_out_data(
     void *spd_ptr, char *buffer, unsigned _supla_int_t buffer_size) {
-  unsigned _supla_int_t a;
   unsigned _supla_int_t b;
 
   TSuplaProtoData *spd = (TSuplaProtoData *)spd_ptr;
@@ -189,13 +205,8 @@ unsigned _supla_int_t PROTO_ICACHE_FLASH sproto_pop_out_data(
   if (spd->out.data_size < buffer_size) buffer_size = spd->out.data_size;
 
   memcpy(buffer, spd->out.buffer, buffer_size);
-
-  b = 0;
-
-  for (a = buffer_size; a < spd->out.data_size; a++) {
-    spd->out.buffer[b] = spd->out.buffer[a];
-    b++;
-  }
+  memmove(spd->out.buffer, &spd->out.buffer[buffer_size],
+          spd->out.data_size - buffer_size);
 
   spd->out.data_size -= buffer_size;
 
@@ -72,6 +72,13 @@
 
 #else
 #include <assert.h>
+
+// Ring buffer queues are used by default on platforms with enough RAM.
+// Define SRPC_QUEUE_WITHOUT_RING_BUFFER to use the old implementation.
+#if !defined(SRPC_QUEUE_RING_BUFFER) && !defined(SRPC_QUEUE_WITHOUT_RING_BUFFER)
+#define SRPC_QUEUE_RING_BUFFER
+#endif /*SRPC_QUEUE_RING_BUFFER*/
+
 #endif
 
 #ifndef SRPC_BUFFER_SIZE
@@ -86,12 +93,27 @@
 #define SRPC_QUEUE_MIN_ALLOC_COUNT 0
 #endif /*SRPC_QUEUE_MIN_ALLOC_COUNT*/
 
+#ifdef SRPC_QUEUE_RING_BUFFER
+// Fixed capacity FIFO. Packet buffers are allocated on first use and kept
+// until srpc_free. Item popped by rr_id from the middle of the queue leaves
+// an empty slot, which is skipped when it reaches the head.
+typedef struct {
+  unsigned char item_count;  // items stored in queue
+  unsigned char head;        // slot with the oldest item
+  unsigned char span;        // slots used from head, including empty ones
+
+  unsigned char used[SRPC_QUEUE_SIZE];
+  unsigned _supla_int_t rr_id[SRPC_QUEUE_SIZE];
+  TSuplaDataPacket *item[SRPC_QUEUE_SIZE];
+} Tsrpc_Queue;
+#else
 typedef struct {
   unsigned char item_count;
   unsigned char alloc_count;
 
   TSuplaDataPacket *item[SRPC_QUEUE_SIZE];
 } Tsrpc_Queue;
+#endif /*SRPC_QUEUE_RING_BUFFER*/
 
 typedef struct {
   void *proto;
@@ -153,8 +175,12 @@ void SRPC_ICACHE_FLASH srpc_queue_free(Tsrpc_Queue *queue) {
     }
   }
 
+#ifdef SRPC_QUEUE_RING_BUFFER
+  memset(queue, 0, sizeof(Tsrpc_Queue));
+#else
   queue->item_count = 0;
   queue->alloc_count = 0;
+#endif /*SRPC_QUEUE_RING_BUFFER*/
 }
 
 void SRPC_ICACHE_FLASH srpc_free(void *_srpc) {
@@ -176,6 +202,100 @@ void SRPC_ICACHE_FLASH srpc_free(void *_srpc) {
   }
 }
 
+#ifdef SRPC_QUEUE_RING_BUFFER
+// Only header and used part of data are copied
+static _supla_int_t srpc_queue_packet_size(TSuplaDataPacket *sdp) {
+  if (sdp->data_size > SUPLA_MAX_DATA_SIZE) {
+    return sizeof(TSuplaDataPacket);
+  }
+  return sizeof(TSuplaDataPacket) - SUPLA_MAX_DATA_SIZE + sdp->data_size;
+}
+
+void SRPC_ICACHE_FLASH srpc_queue_compact(Tsrpc_Queue *queue) {
+  unsigned char a, src, dst;
+  TSuplaDataPacket *item;
+
+  // move items to the beginning of the span, so empty slots (and their
+  // buffers) are moved to the end
+  for (a = 0, dst = 0; a < queue->span; a++) {
+    src = (queue->head + a) % SRPC_QUEUE_SIZE;
+    if (queue->used[src]) {
+      unsigned char dst_idx = (queue->head + dst) % SRPC_QUEUE_SIZE;
+      if (dst_idx != src) {
+        item = queue->item[dst_idx];
+        queue->item[dst_idx] = queue->item[src];
+        queue->item[src] = item;
+        queue->rr_id[dst_idx] = queue->rr_id[src];
+        queue->used[dst_idx] = 1;
+        queue->used[src] = 0;
+      }
+      dst++;
+    }
+  }
+  queue->span = dst;
+}
+
+char SRPC_ICACHE_FLASH srpc_queue_push(Tsrpc_Queue *queue,
+                                       TSuplaDataPacket *sdp) {
+  unsigned char idx;
+
+  if (queue->item_count >= SRPC_QUEUE_SIZE) {
+    return SUPLA_RESULT_FALSE;
+  }
+
+  if (queue->span >= SRPC_QUEUE_SIZE) {
+    srpc_queue_compact(queue);
+  }
+
+  idx = (queue->head + queue->span) % SRPC_QUEUE_SIZE;
+
+  if (queue->item[idx] == NULL) {
+    queue->item[idx] = (TSuplaDataPacket *)malloc(sizeof(TSuplaDataPacket));
+    if (queue->item[idx] == NULL) {
+      return SUPLA_RESULT_FALSE;
+    }
+  }
+
+  memcpy(queue->item[idx], sdp, srpc_queue_packet_size(sdp));
+  queue->rr_id[idx] = sdp->rr_id;
+  queue->used[idx] = 1;
+  queue->span++;
+  queue->item_count++;
+
+  return SUPLA_RESULT_TRUE;
+}
+
+char SRPC_ICACHE_FLASH srpc_queue_pop(Tsrpc_Queue *queue, TSuplaDataPacket *sdp,
+                                      unsigned _supla_int_t rr_id) {
+  unsigned char a, idx;
+
+  for (a = 0; a < queue->span; a++) {
+    idx = (queue->head + a) % SRPC_QUEUE_SIZE;
+    if (queue->used[idx] && (rr_id == 0 || queue->rr_id[idx] == rr_id)) {
+      memcpy(sdp, queue->item[idx], srpc_queue_packet_size(queue->item[idx]));
+      queue->used[idx] = 0;
+      queue->item_count--;
+
+      // drop empty slots from both ends of the span
+      while (queue->span > 0 && !queue->used[queue->head]) {
+        queue->head = (queue->head + 1) % SRPC_QUEUE_SIZE;
+        queue->span--;
+      }
+      while (queue->span > 0 &&
+             !queue->used[(queue->head + queue->span - 1) % SRPC_QUEUE_SIZE]) {
+        queue->span--;
+      }
+      if (queue->span == 0) {
+        queue->head = 0;
+      }
+
+      return SUPLA_RESULT_TRUE;
+    }
+  }
+
+  return SUPLA_RESULT_FALSE;
+}
+#else
 char SRPC_ICACHE_FLASH srpc_queue_push(Tsrpc_Queue *queue,
                                        TSuplaDataPacket *sdp) {
   if (queue->item_count >= SRPC_QUEUE_SIZE) {
@@ -227,6 +347,7 @@ char SRPC_ICACHE_FLASH srpc_queue_pop(Tsrpc_Queue *queue, TSuplaDataPacket *sdp,
 
   return SUPLA_RESULT_FALSE;
 }
+#endif /*SRPC_QUEUE_RING_BUFFER*/
 
 char SRPC_ICACHE_FLASH srpc_in_queue_pop(Tsrpc *srpc, TSuplaDataPacket *sdp,
                                          unsigned _supla_int_t rr_id) {
@@ -253,14 +374,22 @@ char SRPC_ICACHE_FLASH srpc_out_queue_push(Tsrpc *srpc, TSuplaDataPacket *sdp) {
     data_size -= SUPLA_MAX_DATA_SIZE - sdp->data_size;
   }
 #ifndef PACKET_INTEGRITY_BUFFER_DISABLED
-  char *buff = malloc(data_size + SUPLA_TAG_SIZE);
-  if (buff) {
-    memcpy(buff, sdp, data_size);
-    memcpy(&buff[data_size], sproto_tag, SUPLA_TAG_SIZE);
-
-    srpc->params.data_write(buff, data_size + SUPLA_TAG_SIZE,
+  if (sdp->data_size + SUPLA_TAG_SIZE <= SUPLA_MAX_DATA_SIZE) {
+    // tag is put right after the payload, so the whole packet is sent
+    // directly from sdp with a single write
+    memcpy(&sdp->data[sdp->data_size], sproto_tag, SUPLA_TAG_SIZE);
+    srpc->params.data_write((char *)sdp, data_size + SUPLA_TAG_SIZE,
                             srpc->params.user_params);
-    free(buff);
+  } else {
+    char *buff = malloc(data_size + SUPLA_TAG_SIZE);
+    if (buff) {
+      memcpy(buff, sdp, data_size);
+      memcpy(&buff[data_size], sproto_tag, SUPLA_TAG_SIZE);
+
+      srpc->params.data_write(buff, data_size + SUPLA_TAG_SIZE,
+                              srpc->params.user_params);
+      free(buff);
+    }
   }
 #else
   srpc->params.data_write((char *)sdp, data_size, srpc->params.user_params);
@@ -268,6 +397,13 @@ char SRPC_ICACHE_FLASH srpc_out_queue_push(Tsrpc *srpc, TSuplaDataPacket *sdp) {
 #endif /*PACKET_INTEGRITY_BUFFER_DISABLED*/
   return 1;
 #else
+  // When nothing is waiting, packet is serialized directly to the proto out
+  // buffer, skipping the copy to and from the queue.
+  if (srpc->out_queue.item_count == 0 &&
+      sproto_out_dataexists(srpc->proto) != SUPLA_RESULT_TRUE &&
+      sproto_out_buffer_append(srpc->proto, sdp) == SUPLA_RESULT_TRUE) {
+    return SUPLA_RESULT_TRUE;
+  }
   return srpc_queue_push(&srpc->out_queue, sdp);
 #endif /*SRPC_WITHOUT_OUT_QUEUE*/
 }
@@ -17,17 +17,21 @@
 #include <string.h>
 
 #include <supla/log_wrapper.h>
+#include <supla/time.h>
 
 #include "channel.h"
 #include "supla-common/srpc.h"
 #include "tools.h"
 #include "events.h"
 #include "correction.h"
+#include "uplink_filter.h"
 
 namespace Supla {
 
 uint64_t Channel::lastCommunicationTimeMs = 0;
 TDS_SuplaRegisterDevice_E Channel::reg_dev;
+Channel *Channel::firstPendingUpdatePtr = nullptr;
+Channel *Channel::lastPendingUpdatePtr = nullptr;
 
 Channel::Channel() : valueChanged(false), channelConfig(false),
   channelNumber(-1), validityTimeSec(0) {
@@ -47,6 +51,11 @@ Channel::Channel() : valueChanged(false), channelConfig(false),
 }
 
 Channel::~Channel() {
+  removeFromPendingUpdates();
+  if (uplinkFilter) {
+    delete uplinkFilter;
+    uplinkFilter = nullptr;
+  }
   reg_dev.channel_count--;
 }
 
@@ -238,7 +247,10 @@ void Channel::clearUpdateReady() {
 }
 
 void Channel::sendUpdate(void *srpc) {
-  if (valueChanged) {
+  if (isValueUpdateReady()) {
+    if (uplinkFilter) {
+      uplinkFilter->onSent(this, valueChanged, millis());
+    }
     clearUpdateReady();
     srpc_ds_async_channel_value_changed_c(
         srpc, channelNumber, reg_dev.channels[channelNumber].value,
@@ -268,10 +280,130 @@ TSuplaChannelExtendedValue *Channel::getExtValue() {
 
 void Channel::setUpdateReady() {
   valueChanged = true;
+  if (uplinkFilter) {
+    uplinkFilter->onValueChanged();
+  }
+  addToPendingUpdates();
+}
+
+bool Channel::isValueUpdateReady() {
+  if (uplinkFilter) {
+    return uplinkFilter->isSendDue(this, valueChanged, millis());
+  }
+  return valueChanged;
+}
+
+UplinkFilter *Channel::getUplinkFilter() {
+  if (uplinkFilter == nullptr) {
+    uplinkFilter = new UplinkFilter;
+  }
+  return uplinkFilter;
+}
+
+void Channel::setUplinkDeadband(double deadband, bool relative) {
+  getUplinkFilter()->setDeadband(deadband, relative);
+}
+
+void Channel::setUplinkMinIntervalMs(uint32_t intervalMs) {
+  getUplinkFilter()->setMinIntervalMs(intervalMs);
+}
+
+void Channel::setUplinkHeartbeatMs(uint32_t intervalMs) {
+  getUplinkFilter()->setHeartbeatMs(intervalMs);
+  if (intervalMs > 0) {
+    // channel with heartbeat is checked on each iteration
+    addToPendingUpdates();
+  }
+}
+
+uint32_t Channel::getUplinkSentCount() {
+  if (uplinkFilter) {
+    return uplinkFilter->getSentCount();
+  }
+  return 0;
+}
+
+uint32_t Channel::getUplinkSuppressedCount() {
+  if (uplinkFilter) {
+    return uplinkFilter->getSuppressedCount(valueChanged);
+  }
+  return 0;
+}
+
+void Channel::addToPendingUpdates() {
+  if (pendingUpdate) {
+    return;
+  }
+  pendingUpdate = true;
+  nextPendingUpdatePtr = nullptr;
+  if (lastPendingUpdatePtr) {
+    lastPendingUpdatePtr->nextPendingUpdatePtr = this;
+  } else {
+    firstPendingUpdatePtr = this;
+  }
+  lastPendingUpdatePtr = this;
+}
+
+void Channel::removeFromPendingUpdates() {
+  if (!pendingUpdate) {
+    return;
+  }
+  Channel *prev = nullptr;
+  for (auto ptr = firstPendingUpdatePtr; ptr != nullptr;
+       ptr = ptr->nextPendingUpdatePtr) {
+    if (ptr == this) {
+      if (prev) {
+        prev->nextPendingUpdatePtr = nextPendingUpdatePtr;
+      } else {
+        firstPendingUpdatePtr = nextPendingUpdatePtr;
+      }
+      if (lastPendingUpdatePtr == this) {
+        lastPendingUpdatePtr = prev;
+      }
+      break;
+    }
+    prev = ptr;
+  }
+  nextPendingUpdatePtr = nullptr;
+  pendingUpdate = false;
+}
+
+Channel *Channel::getFirstPendingUpdate() {
+  return firstPendingUpdatePtr;
+}
+
+Channel *Channel::getNextPendingUpdate() {
+  return nextPendingUpdatePtr;
+}
+
+void Channel::removeSentPendingUpdates() {
+  Channel *prev = nullptr;
+  auto ptr = firstPendingUpdatePtr;
+  while (ptr != nullptr) {
+    auto next = ptr->nextPendingUpdatePtr;
+    // values held back by uplink filter and channels with heartbeat stay
+    // on the list until they are sent
+    if (ptr->valueChanged || ptr->channelConfig ||
+        (ptr->uplinkFilter && ptr->uplinkFilter->hasHeartbeat())) {
+      prev = ptr;
+    } else {
+      if (prev) {
+        prev->nextPendingUpdatePtr = next;
+      } else {
+        firstPendingUpdatePtr = next;
+      }
+      if (lastPendingUpdatePtr == ptr) {
+        lastPendingUpdatePtr = prev;
+      }
+      ptr->nextPendingUpdatePtr = nullptr;
+      ptr->pendingUpdate = false;
+    }
+    ptr = next;
+  }
 }
 
 bool Channel::isUpdateReady() {
-  return valueChanged || channelConfig;
+  return isValueUpdateReady() || channelConfig;
 }
 
 bool Channel::isExtended() {
@@ -391,6 +523,7 @@ void Channel::setCorrection(double correction, bool forSecondaryValue) {
 
 void Channel::requestChannelConfig() {
   channelConfig = true;
+  addToPendingUpdates();
 }
 
 };  // namespace Supla
@@ -24,6 +24,8 @@
 
 namespace Supla {
 
+class UplinkFilter;
+
 class Channel : public LocalAction {
  public:
   Channel();
@@ -77,11 +79,37 @@ class Channel : public LocalAction {
 
   void requestChannelConfig();
 
+  // Uplink filter limits how often channel value is sent to server. See
+  // UplinkFilter for details. Filter is created on first use.
+  void setUplinkDeadband(double deadband, bool relative = false);
+  void setUplinkMinIntervalMs(uint32_t intervalMs);
+  void setUplinkHeartbeatMs(uint32_t intervalMs);
+  uint32_t getUplinkSentCount();
+  uint32_t getUplinkSuppressedCount();
+
+  // Pending updates list contains channels which called setUpdateReady() or
+  // requestChannelConfig(). Protocol layer iterates only elements which own
+  // channels from this list.
+  static Channel *getFirstPendingUpdate();
+  Channel *getNextPendingUpdate();
+  // Removes channels which don't have anything to send anymore
+  static void removeSentPendingUpdates();
+
   static uint64_t lastCommunicationTimeMs;
   static TDS_SuplaRegisterDevice_E reg_dev;
 
  protected:
   void setUpdateReady();
+  bool isValueUpdateReady();
+  UplinkFilter *getUplinkFilter();
+  void addToPendingUpdates();
+  void removeFromPendingUpdates();
+
+  static Channel *firstPendingUpdatePtr;
+  static Channel *lastPendingUpdatePtr;
+  Channel *nextPendingUpdatePtr = nullptr;
+  bool pendingUpdate = false;
+  UplinkFilter *uplinkFilter = nullptr;
 
   bool valueChanged;
   bool channelConfig;
@@ -15,6 +15,7 @@
 */
 
 #include "channel_element.h"
+#include "condition_rule_set.h"
 #include "events.h"
 
 Supla::Channel *Supla::ChannelElement::getChannel() {
@@ -45,7 +46,12 @@ void Supla::ChannelElement::addAction(int action,
     bool alwaysEnabled) {
   condition->setClient(client);
   condition->setSource(this);
-  channel.addAction(action, condition, Supla::ON_CHANGE, alwaysEnabled);
+  Supla::ConditionRuleSet::addCondition(
+      alwaysEnabled ? &alwaysEnabledConditionRules : &conditionRules,
+      &channel,
+      action,
+      condition,
+      alwaysEnabled);
 }
 
 void Supla::ChannelElement::addAction(int action,
@@ -26,6 +26,7 @@
 namespace Supla {
 
 class Condition;
+class ConditionRuleSet;
 
 class ChannelElement : public Element, public LocalAction {
  public:
@@ -50,6 +51,9 @@ class ChannelElement : public Element, public LocalAction {
 
  protected:
   Channel channel;
+  // rule sets are owned (and deleted) by channel
+  ConditionRuleSet *conditionRules = nullptr;
+  ConditionRuleSet *alwaysEnabledConditionRules = nullptr;
 };
 
 };  // namespace Supla
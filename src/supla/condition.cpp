@@ -37,79 +37,102 @@ Supla::Condition::~Condition() {
 void Supla::Condition::handleAction(int event, int action) {
   if (event == Supla::ON_CHANGE ||
       event == Supla::ON_SECONDARY_CHANNEL_CHANGE) {
-    if (!source->getChannel()) {
-      return;
+    double value = 0;
+    bool isValid = true;
+    if (readValue(&value, &isValid)) {
+      handleValue(event, action, value, isValid);
     }
+  }
+}
 
-    int channelType = source->getChannel()->getChannelType();
+bool Supla::Condition::readValue(double *value, bool *isValid) {
+  if (!source->getChannel()) {
+    return false;
+  }
 
-    // Read channel value
-    double value = 0;
-    bool isValid = true;
+  int channelType = source->getChannel()->getChannelType();
 
-    if (getter) {
-      value = getter->getValue(source, &isValid);
-    } else {
-      switch (channelType) {
-        case SUPLA_CHANNELTYPE_DISTANCESENSOR:
-        case SUPLA_CHANNELTYPE_THERMOMETER:
-        case SUPLA_CHANNELTYPE_WINDSENSOR:
-        case SUPLA_CHANNELTYPE_PRESSURESENSOR:
-        case SUPLA_CHANNELTYPE_RAINSENSOR:
-        case SUPLA_CHANNELTYPE_WEIGHTSENSOR:
-          value = source->getChannel()->getValueDouble();
-          break;
-        case SUPLA_CHANNELTYPE_IMPULSE_COUNTER:
-          value = source->getChannel()->getValueInt64();
-          break;
-        case SUPLA_CHANNELTYPE_HUMIDITYANDTEMPSENSOR:
-        case SUPLA_CHANNELTYPE_HUMIDITYSENSOR:
-          value = useAlternativeValue
-            ? source->getChannel()->getValueDoubleSecond()
-            : source->getChannel()->getValueDoubleFirst();
-          break;
-        case SUPLA_CHANNELTYPE_DIMMER:
-          value = source->getChannel()->getValueBrightness();
-          break;
-        case SUPLA_CHANNELTYPE_RGBLEDCONTROLLER:
-          value = source->getChannel()->getValueColorBrightness();
-          break;
-        case SUPLA_CHANNELTYPE_DIMMERANDRGBLED:
-          value = useAlternativeValue
-            ? source->getChannel()->getValueColorBrightness()
-            : source->getChannel()->getValueBrightness();
-          break;
-          /* case SUPLA_CHANNELTYPE_ELECTRICITY_METER: */
-
-        default:
-          return;
-      }
-
-      // Check channel value validity
-      switch (channelType) {
-        case SUPLA_CHANNELTYPE_DISTANCESENSOR:
-        case SUPLA_CHANNELTYPE_WINDSENSOR:
-        case SUPLA_CHANNELTYPE_PRESSURESENSOR:
-        case SUPLA_CHANNELTYPE_RAINSENSOR:
-        case SUPLA_CHANNELTYPE_WEIGHTSENSOR:
-          isValid = value >= 0;
-          break;
-        case SUPLA_CHANNELTYPE_THERMOMETER:
-          isValid = value >= -273;
-          break;
-        case SUPLA_CHANNELTYPE_HUMIDITYANDTEMPSENSOR:
-        case SUPLA_CHANNELTYPE_HUMIDITYSENSOR:
-          isValid = useAlternativeValue ? value >= 0 : value >= -273;
-          break;
-      }
-    }
-    if (checkConditionFor(value, isValid)) {
-      client->handleAction(event, action);
-    }
+  // Read channel value
+  *value = 0;
+  *isValid = true;
+
+  if (getter) {
+    *value = getter->getValue(source, isValid);
+    return true;
+  }
+
+  switch (channelType) {
+    case SUPLA_CHANNELTYPE_DISTANCESENSOR:
+    case SUPLA_CHANNELTYPE_THERMOMETER:
+    case SUPLA_CHANNELTYPE_WINDSENSOR:
+    case SUPLA_CHANNELTYPE_PRESSURESENSOR:
+    case SUPLA_CHANNELTYPE_RAINSENSOR:
+    case SUPLA_CHANNELTYPE_WEIGHTSENSOR:
+      *value = source->getChannel()->getValueDouble();
+      break;
+    case SUPLA_CHANNELTYPE_IMPULSE_COUNTER:
+      *value = source->getChannel()->getValueInt64();
+      break;
+    case SUPLA_CHANNELTYPE_HUMIDITYANDTEMPSENSOR:
+    case SUPLA_CHANNELTYPE_HUMIDITYSENSOR:
+      *value = useAlternativeValue
+        ? source->getChannel()->getValueDoubleSecond()
+        : source->getChannel()->getValueDoubleFirst();
+      break;
+    case SUPLA_CHANNELTYPE_DIMMER:
+      *value = source->getChannel()->getValueBrightness();
+      break;
+    case SUPLA_CHANNELTYPE_RGBLEDCONTROLLER:
+      *value = source->getChannel()->getValueColorBrightness();
+      break;
+    case SUPLA_CHANNELTYPE_DIMMERANDRGBLED:
+      *value = useAlternativeValue
+        ? source->getChannel()->getValueColorBrightness()
+        : source->getChannel()->getValueBrightness();
+      break;
+      /* case SUPLA_CHANNELTYPE_ELECTRICITY_METER: */
+
+    default:
+      return false;
+  }
+
+  // Check channel value validity
+  switch (channelType) {
+    case SUPLA_CHANNELTYPE_DISTANCESENSOR:
+    case SUPLA_CHANNELTYPE_WINDSENSOR:
+    case SUPLA_CHANNELTYPE_PRESSURESENSOR:
+    case SUPLA_CHANNELTYPE_RAINSENSOR:
+    case SUPLA_CHANNELTYPE_WEIGHTSENSOR:
+      *isValid = *value >= 0;
+      break;
+    case SUPLA_CHANNELTYPE_THERMOMETER:
+      *isValid = *value >= -273;
+      break;
+    case SUPLA_CHANNELTYPE_HUMIDITYANDTEMPSENSOR:
+    case SUPLA_CHANNELTYPE_HUMIDITYSENSOR:
+      *isValid = useAlternativeValue ? *value >= 0 : *value >= -273;
+      break;
+  }
+  return true;
+}
+
+void Supla::Condition::handleValue(int event,
+                                   int action,
+                                   double value,
+                                   bool isValid) {
+  if (checkConditionFor(value, isValid)) {
+    client->handleAction(event, action);
+  }
+}
+
+uint16_t Supla::Condition::getValueId() const {
+  if (getter) {
+    return getter->getValueId();
   }
+  return useAlternativeValue ? 2 : 1;
 }
 
-// Condition objects will be deleted during ActionHandlerClient list cleanup
+// Condition objects will be deleted during ConditionRuleSet cleanup
 bool Supla::Condition::deleteClient() {
   return true;
 }
@@ -41,6 +41,15 @@ class Condition : public ActionHandler {
 
   virtual bool checkConditionFor(double val, bool isValid = true);
 
+  // Reads value from source. Returns false if source's channel type is not
+  // supported.
+  bool readValue(double *value, bool *isValid);
+  // Checks condition for already read value and calls client's action
+  void handleValue(int event, int action, double value, bool isValid);
+  // Conditions with the same non zero id read the same value from the same
+  // source, so value can be read once for all of them.
+  uint16_t getValueId() const;
+
  protected:
   virtual bool condition(double val, bool isValid = true) = 0;
 
@@ -19,6 +19,23 @@
 
 namespace Supla {
 
+// Value ids of electricity meter getters. Lower byte is used for phase.
+enum EmValueId : uint16_t {
+  EmVoltageId = 0x100,
+  EmCurrentId = 0x200,
+  EmTotalCurrentId = 0x300,
+  EmPowerActiveWId = 0x400,
+  EmTotalPowerActiveWId = 0x500,
+  EmPowerApparentVAId = 0x600,
+  EmTotalPowerApparentVAId = 0x700,
+  EmPowerReactiveVarId = 0x800,
+  EmTotalPowerReactiveVarId = 0x900
+};
+
+uint16_t ConditionGetter::getValueId() const {
+  return 0;
+}
+
 TElectricityMeter_Measurement *ConditionGetter::getMeasurement(
       Supla::Element *element, _supla_int_t *measuredValues) {
   if (!element || !element->getChannel() ||
@@ -48,6 +65,10 @@ class VoltageGetter : public ConditionGetter {
  public:
   explicit VoltageGetter(int8_t phase) : phase(phase) {}
 
+  uint16_t getValueId() const override {
+    return EmVoltageId | static_cast<uint8_t>(phase);
+  }
+
   double getValue(Supla::Element *element, bool *isValid) override {
     *isValid = false;
     if (phase < 0 || phase >= 3 /* MAX_PHASES */) {
@@ -74,6 +95,10 @@ class CurrentGetter : public ConditionGetter {
   explicit CurrentGetter(int8_t phase) : phase(phase) {
   }
 
+  uint16_t getValueId() const override {
+    return EmCurrentId | static_cast<uint8_t>(phase);
+  }
+
   double getValue(Supla::Element *element, bool *isValid) override {
     *isValid = false;
     if (phase < 0 || phase >= 3 /* MAX_PHASES */) {
@@ -101,6 +126,10 @@ class CurrentGetter : public ConditionGetter {
 
 class TotalCurrentGetter : public ConditionGetter {
  public:
+  uint16_t getValueId() const override {
+    return EmTotalCurrentId;
+  }
+
   double getValue(Supla::Element *element, bool *isValid) override {
     *isValid = false;
 
@@ -127,6 +156,10 @@ class PowerActiveWGetter : public ConditionGetter {
  public:
   explicit PowerActiveWGetter(int8_t phase) : phase(phase) {}
 
+  uint16_t getValueId() const override {
+    return EmPowerActiveWId | static_cast<uint8_t>(phase);
+  }
+
   double getValue(Supla::Element *element, bool *isValid) override {
     *isValid = false;
     if (phase < 0 || phase >= 3 /* MAX_PHASES */) {
@@ -149,6 +182,10 @@ class PowerActiveWGetter : public ConditionGetter {
 
 class TotalPowerActiveWGetter : public ConditionGetter {
  public:
+  uint16_t getValueId() const override {
+    return EmTotalPowerActiveWId;
+  }
+
   double getValue(Supla::Element *element, bool *isValid) override {
     *isValid = false;
 
@@ -171,6 +208,10 @@ class PowerApparentVAGetter : public ConditionGetter {
  public:
   explicit PowerApparentVAGetter(int8_t phase) : phase(phase) {}
 
+  uint16_t getValueId() const override {
+    return EmPowerApparentVAId | static_cast<uint8_t>(phase);
+  }
+
   double getValue(Supla::Element *element, bool *isValid) override {
     *isValid = false;
     if (phase < 0 || phase >= 3 /* MAX_PHASES */) {
@@ -193,6 +234,10 @@ class PowerApparentVAGetter : public ConditionGetter {
 
 class TotalPowerApparentVAGetter : public ConditionGetter {
  public:
+  uint16_t getValueId() const override {
+    return EmTotalPowerApparentVAId;
+  }
+
   double getValue(Supla::Element *element, bool *isValid) override {
     *isValid = false;
 
@@ -215,6 +260,10 @@ class PowerReactiveVarGetter : public ConditionGetter {
  public:
   explicit PowerReactiveVarGetter(int8_t phase) : phase(phase) {}
 
+  uint16_t getValueId() const override {
+    return EmPowerReactiveVarId | static_cast<uint8_t>(phase);
+  }
+
   double getValue(Supla::Element *element, bool *isValid) override {
     *isValid = false;
     if (phase < 0 || phase >= 3 /* MAX_PHASES */) {
@@ -237,6 +286,10 @@ class PowerReactiveVarGetter : public ConditionGetter {
 
 class TotalPowerReactiveVarGetter : public ConditionGetter {
  public:
+  uint16_t getValueId() const override {
+    return EmTotalPowerReactiveVarId;
+  }
+
   double getValue(Supla::Element *element, bool *isValid) override {
     *isValid = false;
 
@@ -28,6 +28,9 @@ class ConditionGetter {
  public:
   virtual ~ConditionGetter() {}
   virtual double getValue(Supla::Element *element, bool *isValid) = 0;
+  // Getters which return the same non zero id, read the same value.
+  // 0 means that value can't be shared with other getters.
+  virtual uint16_t getValueId() const;
  protected:
   TElectricityMeter_Measurement *getMeasurement(Supla::Element *element,
       _supla_int_t *measuredValues);
@@ -0,0 +1,104 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include "condition_rule_set.h"
+
+#include "condition.h"
+#include "events.h"
+#include "local_action.h"
+
+void Supla::ConditionRuleSet::addCondition(ConditionRuleSet **ruleSet,
+                                           LocalAction *trigger,
+                                           int action,
+                                           Condition *condition,
+                                           bool alwaysEnabled) {
+  if (*ruleSet == nullptr) {
+    *ruleSet = new ConditionRuleSet;
+    trigger->addAction(0, *ruleSet, Supla::ON_CHANGE, alwaysEnabled);
+  }
+  (*ruleSet)->addCondition(action, condition);
+}
+
+Supla::ConditionRuleSet::ConditionRuleSet() {
+}
+
+Supla::ConditionRuleSet::~ConditionRuleSet() {
+  for (int i = 0; i < rulesCount; i++) {
+    if (rules[i].condition->deleteClient()) {
+      delete rules[i].condition;
+    }
+  }
+  delete[] rules;
+  rules = nullptr;
+  rulesCount = 0;
+}
+
+void Supla::ConditionRuleSet::addCondition(int action, Condition *condition) {
+  if (rulesCount == rulesCapacity) {
+    uint16_t newCapacity = rulesCapacity ? rulesCapacity * 2 : 4;
+    Rule *newRules = new Rule[newCapacity];
+    for (int i = 0; i < rulesCount; i++) {
+      newRules[i] = rules[i];
+    }
+    delete[] rules;
+    rules = newRules;
+    rulesCapacity = newCapacity;
+  }
+
+  // keep array sorted by value id. Conditions with the same value id are
+  // kept in order of adding. Value id 0 means not shared value, so
+  // those are kept at the beginning.
+  uint16_t valueId = condition->getValueId();
+  int position = rulesCount;
+  while (position > 0 && rules[position - 1].valueId > valueId) {
+    rules[position] = rules[position - 1];
+    position--;
+  }
+  rules[position].condition = condition;
+  rules[position].valueId = valueId;
+  rules[position].action = action;
+  rulesCount++;
+
+  condition->activateAction(action);
+}
+
+int Supla::ConditionRuleSet::getConditionCount() const {
+  return rulesCount;
+}
+
+void Supla::ConditionRuleSet::handleAction(int event, int) {
+  if (event != Supla::ON_CHANGE &&
+      event != Supla::ON_SECONDARY_CHANNEL_CHANGE) {
+    return;
+  }
+
+  double value = 0;
+  bool isValid = false;
+  bool isRead = false;
+  for (int i = 0; i < rulesCount; i++) {
+    const Rule &rule = rules[i];
+    if (i == 0 || rule.valueId == 0 || rule.valueId != rules[i - 1].valueId) {
+      isRead = rule.condition->readValue(&value, &isValid);
+    }
+    if (isRead) {
+      rule.condition->handleValue(event, rule.action, value, isValid);
+    }
+  }
+}
+
+bool Supla::ConditionRuleSet::deleteClient() {
+  return true;
+}
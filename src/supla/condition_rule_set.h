@@ -0,0 +1,66 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#ifndef SRC_SUPLA_CONDITION_RULE_SET_H_
+#define SRC_SUPLA_CONDITION_RULE_SET_H_
+
+#include <stdint.h>
+
+#include "action_handler.h"
+
+namespace Supla {
+
+class Condition;
+class LocalAction;
+
+// Evaluates all conditions attached to one source element. Rule set is
+// added to source as a single ON_CHANGE client. Conditions are kept in flat
+// array sorted by value id, so value which is used by several conditions
+// (i.e. voltage on phase 1) is read only once per change.
+class ConditionRuleSet : public ActionHandler {
+ public:
+  // Adds condition to *ruleSet. Rule set is created and added to trigger
+  // on first call.
+  static void addCondition(ConditionRuleSet **ruleSet,
+                           LocalAction *trigger,
+                           int action,
+                           Condition *condition,
+                           bool alwaysEnabled);
+
+  ConditionRuleSet();
+  virtual ~ConditionRuleSet();
+
+  void addCondition(int action, Condition *condition);
+  int getConditionCount() const;
+
+  void handleAction(int event, int action) override;
+  bool deleteClient() override;
+
+ protected:
+  struct Rule {
+    Condition *condition;
+    uint16_t valueId;
+    int action;
+  };
+
+  Rule *rules = nullptr;
+  uint16_t rulesCount = 0;
+  uint16_t rulesCapacity = 0;
+};
+
+};  // namespace Supla
+
+#endif  // SRC_SUPLA_CONDITION_RULE_SET_H_
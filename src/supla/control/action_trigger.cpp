@@ -24,6 +24,7 @@
 Supla::Control::ActionTrigger::ActionTrigger() {
   channel.setType(SUPLA_CHANNELTYPE_ACTIONTRIGGER);
   channel.setDefault(SUPLA_CHANNELFNC_ACTIONTRIGGER);
+  useChannelUpdateIteration();
 }
 
 Supla::Control::ActionTrigger::~ActionTrigger() {
@@ -190,6 +191,9 @@ void Supla::Control::ActionTrigger::handleChannelConfig(
       result->ConfigSize == sizeof(TSD_ChannelConfig_ActionTrigger)) {
     TSD_ChannelConfig_ActionTrigger *config =
       reinterpret_cast<TSD_ChannelConfig_ActionTrigger *>(result->Config);
+    if (activeActionsFromServer != config->ActiveActions) {
+      setStateDirty();
+    }
     activeActionsFromServer = config->ActiveActions;
     SUPLA_LOG_DEBUG(
         "AT[%d] received config with active actions: 0x%X",
@@ -369,6 +373,10 @@ void Supla::Control::ActionTrigger::onSaveState() {
   }
 }
 
+bool Supla::Control::ActionTrigger::isStateDirtyTracked() {
+  return true;
+}
+
 void Supla::Control::ActionTrigger::onLoadState() {
   if (storageEnabled) {
     Supla::Storage::ReadState((unsigned char *)&activeActionsFromServer,
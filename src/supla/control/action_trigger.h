@@ -57,6 +57,7 @@ class ActionTrigger : public Element, public ActionHandler {
   void handleChannelConfig(TSD_ChannelConfig *result) override;
   void onLoadState() override;
   void onSaveState() override;
+  bool isStateDirtyTracked() override;
 
   void disableATCapability(uint32_t capToDisable);
   void enableStateStorage();
@@ -77,6 +77,13 @@ void BistableRelay::iterateAlways() {
     busy = false;
     Supla::Io::digitalWrite(channel.getChannelNumber(), pin, pinOffValue());
   }
+
+  if (statusPin >= 0) {
+    scheduleIterateAlways(lastReadTime + 101);
+  }
+  if (busy) {
+    scheduleIterateAlways(disarmTimeMs + 201);
+  }
 }
 
 int BistableRelay::handleNewValueFromServer(
@@ -106,6 +113,7 @@ void BistableRelay::turnOn(_supla_int_t duration) {
   if (duration > 0) {
     durationMs = duration;
     durationTimestamp = millis();
+    scheduleDurationTimeout();
   }
 
   if (isStatusUnknown() || !isOn()) {
@@ -136,6 +144,10 @@ bool BistableRelay::isOn() {
          (statusHighIsOn ? HIGH : LOW);
 }
 
+bool BistableRelay::isStateDirtyTracked() {
+  return false;
+}
+
 bool BistableRelay::isStatusUnknown() {
   return (statusPin < 0);
 }
@@ -144,6 +156,7 @@ void BistableRelay::internalToggle() {
   SUPLA_LOG_INFO("BistableRelay[%d] toggle relay", channel.getChannelNumber());
   busy = true;
   disarmTimeMs = millis();
+  scheduleIterateAlways(disarmTimeMs + 201);
   Supla::Io::digitalWrite(channel.getChannelNumber(), pin, pinOnValue());
 
   // Schedule save in 5 s after state change
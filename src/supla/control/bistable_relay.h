@@ -49,6 +49,9 @@ class BistableRelay : public Relay {
 
   virtual bool isOn();
   bool isStatusUnknown();
+  // Relay state is read from status input, which may change without
+  // turnOn()/turnOff() call, so state is saved on each state save
+  bool isStateDirtyTracked() override;
 
  protected:
   void internalToggle();
@@ -27,6 +27,7 @@ Supla::Control::InternalPinOutput::InternalPinOutput(int pin, bool highIsOn)
       durationMs(0),
       storedTurnOnDurationMs(0),
       durationTimestamp(0) {
+  useDeadlineScheduling();
 }
 
 Supla::Control::InternalPinOutput &
@@ -54,6 +55,7 @@ void Supla::Control::InternalPinOutput::turnOn(_supla_int_t duration) {
   if (storedTurnOnDurationMs) {
     durationMs = storedTurnOnDurationMs;
   }
+  scheduleDurationTimeout();
 
   runAction(Supla::ON_TURN_ON);
   runAction(Supla::ON_CHANGE);
@@ -64,6 +66,7 @@ void Supla::Control::InternalPinOutput::turnOn(_supla_int_t duration) {
 void Supla::Control::InternalPinOutput::turnOff(_supla_int_t duration) {
   durationMs = duration;
   durationTimestamp = millis();
+  scheduleDurationTimeout();
 
   runAction(Supla::ON_TURN_OFF);
   runAction(Supla::ON_CHANGE);
@@ -115,6 +118,14 @@ void Supla::Control::InternalPinOutput::onInit() {
 void Supla::Control::InternalPinOutput::iterateAlways() {
   if (durationMs && millis() - durationTimestamp > durationMs) {
     toggle();
+  } else {
+    scheduleDurationTimeout();
+  }
+}
+
+void Supla::Control::InternalPinOutput::scheduleDurationTimeout() {
+  if (durationMs) {
+    scheduleIterateAlways(durationTimestamp + durationMs + 1);
   }
 }
 
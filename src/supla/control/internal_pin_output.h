@@ -53,6 +53,8 @@ class InternalPinOutput : public Element,
   void iterateAlways();
 
  protected:
+  void scheduleDurationTimeout();
+
   int pin;
   bool highIsOn;
 
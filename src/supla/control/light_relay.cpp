@@ -60,6 +60,7 @@ int LightRelay::handleCalcfgFromServer(TSD_DeviceCalCfgRequest *request) {
       if (config->ResetCounter) {
         turnOnSecondsCumulative = 0;
       }
+      setStateDirty();
 
       return SUPLA_CALCFG_RESULT_DONE;
     }
@@ -95,6 +96,7 @@ void LightRelay::onSaveState() {
 
 void LightRelay::turnOn(_supla_int_t duration) {
   turnOnTimestamp = millis();
+  scheduleIterateAlways(turnOnTimestamp + 1000);
   Relay::turnOn(duration);
 }
 
@@ -106,7 +108,9 @@ void LightRelay::iterateAlways() {
       turnOnTimestamp =
           currentMillis - ((currentMillis - turnOnTimestamp) % 1000);
       turnOnSecondsCumulative += seconds;
+      setStateDirty();
     }
+    scheduleIterateAlways(turnOnTimestamp + 1000);
   }
 
   Relay::iterateAlways();
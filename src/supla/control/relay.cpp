@@ -40,6 +40,8 @@ Relay::Relay(int pin, bool highIsOn, _supla_int_t functions)
       keepTurnOnDurationMs(false) {
   channel.setType(SUPLA_CHANNELTYPE_RELAY);
   channel.setFuncList(functions);
+  useDeadlineScheduling();
+  useChannelUpdateIteration();
 }
 
 uint8_t Relay::pinOnValue() {
@@ -66,6 +68,14 @@ void Relay::onInit() {
 void Relay::iterateAlways() {
   if (durationMs && millis() - durationTimestamp > durationMs) {
     toggle();
+  } else {
+    scheduleDurationTimeout();
+  }
+}
+
+void Relay::scheduleDurationTimeout() {
+  if (durationMs) {
+    scheduleIterateAlways(durationTimestamp + durationMs + 1);
   }
 }
 
@@ -74,6 +84,7 @@ int Relay::handleNewValueFromServer(TSD_SuplaChannelNewValue *newValue) {
   if (newValue->value[0] == 1) {
     if (keepTurnOnDurationMs) {
       storedTurnOnDurationMs = newValue->DurationMS;
+      setStateDirty();
     }
     turnOn(newValue->DurationMS);
     result = 1;
@@ -97,11 +108,13 @@ void Relay::turnOn(_supla_int_t duration) {
   if (keepTurnOnDurationMs) {
     durationMs = storedTurnOnDurationMs;
   }
+  scheduleDurationTimeout();
   Supla::Io::digitalWrite(channel.getChannelNumber(), pin, pinOnValue());
 
   channel.setNewValue(true);
 
   // Schedule save in 5 s after state change
+  setStateDirty();
   Supla::Storage::ScheduleSave(5000);
 }
 
@@ -112,11 +125,13 @@ void Relay::turnOff(_supla_int_t duration) {
             duration);
   durationMs = duration;
   durationTimestamp = millis();
+  scheduleDurationTimeout();
   Supla::Io::digitalWrite(channel.getChannelNumber(), pin, pinOffValue());
 
   channel.setNewValue(false);
 
   // Schedule save in 5 s after state change
+  setStateDirty();
   Supla::Storage::ScheduleSave(5000);
 }
 
@@ -165,6 +180,10 @@ void Relay::onSaveState() {
   Supla::Storage::WriteState((unsigned char *)&enabled, sizeof(enabled));
 }
 
+bool Relay::isStateDirtyTracked() {
+  return true;
+}
+
 void Relay::onLoadState() {
   Supla::Storage::ReadState((unsigned char *)&storedTurnOnDurationMs,
                             sizeof(storedTurnOnDurationMs));
@@ -63,11 +63,19 @@ class Relay : public ChannelElement, public ActionHandler {
   void onInit() override;
   void onLoadState() override;
   void onSaveState() override;
+  // State is marked as dirty in turnOn() and turnOff(). Derived class which
+  // changes relay state in other way has to call setStateDirty() (or return
+  // false here).
+  bool isStateDirtyTracked() override;
   void iterateAlways() override;
   int handleNewValueFromServer(TSD_SuplaChannelNewValue *newValue) override;
   unsigned _supla_int_t getStoredTurnOnDurationMs();
 
  protected:
+  // Schedules iterateAlways() call when turn on/off duration expires. Has to
+  // be called after durationMs and durationTimestamp are modified.
+  void scheduleDurationTimeout();
+
   int pin;
   bool highIsOn;
 
@@ -58,6 +58,7 @@ RGBWBase::RGBWBase()
       minIterationBrightness(5) {
   channel.setType(SUPLA_CHANNELTYPE_DIMMERANDRGBLED);
   channel.setDefault(SUPLA_CHANNELFNC_DIMMERANDRGBLIGHTING);
+  useChannelUpdateIteration();
 }
 
 void RGBWBase::setRGBW(int red,
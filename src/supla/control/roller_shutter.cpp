@@ -54,6 +54,7 @@ RollerShutter::RollerShutter(int pinUp, int pinDown, bool highIsOn)
   channel.setType(SUPLA_CHANNELTYPE_RELAY);
   channel.setDefault(SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER);
   channel.setFuncList(SUPLA_BIT_FUNC_CONTROLLINGTHEROLLERSHUTTER);
+  useChannelUpdateIteration();
 }
 
 void RollerShutter::onInit() {
@@ -43,10 +43,12 @@ void Supla::Control::VirtualRelay::turnOn(_supla_int_t duration) {
   if (keepTurnOnDurationMs) {
     durationMs = storedTurnOnDurationMs;
   }
+  scheduleDurationTimeout();
   state = true;
 
   channel.setNewValue(state);
   // Schedule save in 5 s after state change
+  setStateDirty();
   Supla::Storage::ScheduleSave(5000);
 }
 
@@ -57,10 +59,12 @@ void Supla::Control::VirtualRelay::turnOff(_supla_int_t duration) {
       duration);
   durationMs = duration;
   durationTimestamp = millis();
+  scheduleDurationTimeout();
   state = false;
 
   channel.setNewValue(state);
   // Schedule save in 5 s after state change
+  setStateDirty();
   Supla::Storage::ScheduleSave(5000);
 }
 
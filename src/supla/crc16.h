@@ -19,8 +19,42 @@
 #ifndef SRC_SUPLA_CRC16_H_
 #define SRC_SUPLA_CRC16_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
+// CRC-16 (polynomial 0xA001 reflected, as used by Modbus with 0xFFFF init).
+// Implementation used by crc16_update_buf() is selected at compile time:
+// - SUPLA_CRC16_BITWISE - bit loop, no lookup table (default on AVR and
+//   ESP8266, where const data is copied to RAM),
+// - SUPLA_CRC16_TABLE - 256 entry table, 512 B (default on ESP32),
+// - SUPLA_CRC16_SLICING_BY_8 - 8 tables, 4 KiB, processes 8 bytes per step
+//   (default on other platforms, i.e. Linux).
+#if !defined(SUPLA_CRC16_BITWISE) && !defined(SUPLA_CRC16_TABLE) && \
+    !defined(SUPLA_CRC16_SLICING_BY_8)
+#if defined(ARDUINO_ARCH_AVR) || defined(__AVR__) || \
+    defined(ARDUINO_ARCH_ESP8266) || defined(ESP8266)
+#define SUPLA_CRC16_BITWISE
+#elif defined(ARDUINO_ARCH_ESP32) || defined(ESP_PLATFORM)
+#define SUPLA_CRC16_TABLE
+#else
+#define SUPLA_CRC16_SLICING_BY_8
+#endif
+#endif
+
 uint16_t crc16_update(uint16_t crc, uint8_t a);
 
+// Updates crc with size bytes from data
+uint16_t crc16_update_buf(uint16_t crc, const void *data, size_t size);
+
+// Particular implementations. Table based ones are not available when
+// bitwise implementation is selected, so AVR builds don't keep tables in
+// flash.
+uint16_t crc16_update_buf_bitwise(uint16_t crc, const void *data, size_t size);
+#ifndef SUPLA_CRC16_BITWISE
+uint16_t crc16_update_buf_table(uint16_t crc, const void *data, size_t size);
+uint16_t crc16_update_buf_slicing_by_8(uint16_t crc,
+                                       const void *data,
+                                       size_t size);
+#endif
+
 #endif  // SRC_SUPLA_CRC16_H_
@@ -14,6 +14,8 @@
  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
+#include <string.h>
+
 #include <supla/log_wrapper.h>
 #include <supla/storage/config.h>
 
@@ -22,8 +24,28 @@
 
 namespace Supla {
 Element *Element::firstPtr = nullptr;
-
-Element::Element() : nextPtr(nullptr) {
+Element *Element::channelIndex[SUPLA_CHANNELMAXCOUNT] = {};
+Element *Element::channelOwnerIndex[SUPLA_CHANNELMAXCOUNT] = {};
+Element *Element::firstPeriodicIteratePtr = nullptr;
+Element *Element::firstAlwaysIteratePtr = nullptr;
+bool Element::channelIndexValid = false;
+Element **Element::deadlineHeap = nullptr;
+int Element::deadlineHeapSize = 0;
+int Element::deadlineHeapCapacity = 0;
+
+Element::Element()
+    : nextPtr(nullptr),
+      nextPeriodicIteratePtr(nullptr),
+      nextAlwaysIteratePtr(nullptr),
+      nextDuePtr(nullptr),
+      iterateAlwaysDeadlineMs(0),
+      deadlineHeapIndex(-1),
+      stateDirty(true),
+      deadlineScheduling(false),
+      channelUpdateIteration(false) {
+  // Channel number is not known here yet (channel is created by derived
+  // class), so index is rebuilt lazily on next lookup
+  invalidateChannelIndex();
   if (firstPtr == nullptr) {
     firstPtr = this;
   } else {
@@ -32,6 +54,8 @@ Element::Element() : nextPtr(nullptr) {
 }
 
 Element::~Element() {
+  invalidateChannelIndex();
+  cancelIterateAlways();
   if (begin() == this) {
     firstPtr = next();
     return;
@@ -57,7 +81,255 @@ Element *Element::last() {
   return ptr;
 }
 
+void Element::invalidateChannelIndex() {
+  channelIndexValid = false;
+}
+
+void Element::rebuildChannelIndex() {
+  memset(channelIndex, 0, sizeof(channelIndex));
+  memset(channelOwnerIndex, 0, sizeof(channelOwnerIndex));
+  firstPeriodicIteratePtr = nullptr;
+  firstAlwaysIteratePtr = nullptr;
+  Element *lastPeriodicIterate = nullptr;
+  Element *lastAlwaysIterate = nullptr;
+
+  for (auto element = begin(); element != nullptr; element = element->next()) {
+    int channelNumber = element->getChannelNumber();
+    // first element on the list wins, the same as in linear search
+    if (channelNumber >= 0 && channelNumber < SUPLA_CHANNELMAXCOUNT &&
+        channelIndex[channelNumber] == nullptr) {
+      channelIndex[channelNumber] = element;
+    }
+
+    Channel *channels[] = {element->getChannel(),
+                           element->getSecondaryChannel()};
+    for (auto channel : channels) {
+      if (channel == nullptr) {
+        continue;
+      }
+      channelNumber = channel->getChannelNumber();
+      if (channelNumber >= 0 && channelNumber < SUPLA_CHANNELMAXCOUNT &&
+          channelOwnerIndex[channelNumber] == nullptr) {
+        channelOwnerIndex[channelNumber] = element;
+      }
+    }
+
+    element->nextPeriodicIteratePtr = nullptr;
+    if (!element->isIteratedOnlyOnChannelUpdate()) {
+      if (lastPeriodicIterate) {
+        lastPeriodicIterate->nextPeriodicIteratePtr = element;
+      } else {
+        firstPeriodicIteratePtr = element;
+      }
+      lastPeriodicIterate = element;
+    }
+
+    element->nextAlwaysIteratePtr = nullptr;
+    if (element->isIteratedAlwaysOnDeadline()) {
+      // new element is iterated once, so it can schedule its deadline
+      if (element->deadlineHeapIndex == -1) {
+        element->scheduleIterateAlways(0);
+      }
+    } else {
+      if (lastAlwaysIterate) {
+        lastAlwaysIterate->nextAlwaysIteratePtr = element;
+      } else {
+        firstAlwaysIteratePtr = element;
+      }
+      lastAlwaysIterate = element;
+    }
+  }
+  channelIndexValid = true;
+}
+
+Element *Element::getOwnerOfChannel(int channelNumber) {
+  if (channelNumber < 0 || channelNumber >= SUPLA_CHANNELMAXCOUNT) {
+    return nullptr;
+  }
+  if (!channelIndexValid) {
+    rebuildChannelIndex();
+  }
+  return channelOwnerIndex[channelNumber];
+}
+
+Element *Element::beginPeriodicIterate() {
+  if (!channelIndexValid) {
+    rebuildChannelIndex();
+  }
+  return firstPeriodicIteratePtr;
+}
+
+Element *Element::nextPeriodicIterate() {
+  return nextPeriodicIteratePtr;
+}
+
+Element *Element::beginAlwaysIterate() {
+  if (!channelIndexValid) {
+    rebuildChannelIndex();
+  }
+  return firstAlwaysIteratePtr;
+}
+
+Element *Element::nextAlwaysIterate() {
+  return nextAlwaysIteratePtr;
+}
+
+Element *Element::takeDueElements(uint64_t now) {
+  if (!channelIndexValid) {
+    rebuildChannelIndex();
+  }
+
+  Element *first = nullptr;
+  Element *last = nullptr;
+  while (deadlineHeapSize > 0 &&
+         deadlineHeap[0]->iterateAlwaysDeadlineMs <= now) {
+    Element *element = deadlineHeap[0];
+    deadlineHeapRemove(0);
+    element->nextDuePtr = nullptr;
+    if (last) {
+      last->nextDuePtr = element;
+    } else {
+      first = element;
+    }
+    last = element;
+  }
+  return first;
+}
+
+Element *Element::nextDue() {
+  return nextDuePtr;
+}
+
+bool Element::getNextDeadline(uint64_t *deadlineMs) {
+  if (deadlineHeapSize == 0) {
+    return false;
+  }
+  *deadlineMs = deadlineHeap[0]->iterateAlwaysDeadlineMs;
+  return true;
+}
+
+void Element::scheduleIterateAlways(uint64_t deadlineMs) {
+  if (!isIteratedAlwaysOnDeadline()) {
+    // element is already iterated on each iteration
+    return;
+  }
+  if (deadlineHeapIndex >= 0) {
+    if (deadlineMs < iterateAlwaysDeadlineMs) {
+      iterateAlwaysDeadlineMs = deadlineMs;
+      deadlineHeapUp(deadlineHeapIndex);
+    }
+    return;
+  }
+
+  if (deadlineHeapSize == deadlineHeapCapacity) {
+    int newCapacity = deadlineHeapCapacity ? deadlineHeapCapacity * 2 : 8;
+    Element **newHeap = new Element *[newCapacity];
+    if (newHeap == nullptr) {
+      SUPLA_LOG_ERROR("Failed to allocate deadline scheduler");
+      return;
+    }
+    for (int i = 0; i < deadlineHeapSize; i++) {
+      newHeap[i] = deadlineHeap[i];
+    }
+    delete[] deadlineHeap;
+    deadlineHeap = newHeap;
+    deadlineHeapCapacity = newCapacity;
+  }
+
+  iterateAlwaysDeadlineMs = deadlineMs;
+  deadlineHeapIndex = deadlineHeapSize;
+  deadlineHeap[deadlineHeapSize++] = this;
+  deadlineHeapUp(deadlineHeapIndex);
+}
+
+void Element::useDeadlineScheduling(bool enabled) {
+  if (deadlineScheduling == enabled) {
+    return;
+  }
+  deadlineScheduling = enabled;
+  if (!enabled) {
+    cancelIterateAlways();
+  }
+  invalidateChannelIndex();
+}
+
+void Element::useChannelUpdateIteration(bool enabled) {
+  if (channelUpdateIteration == enabled) {
+    return;
+  }
+  channelUpdateIteration = enabled;
+  invalidateChannelIndex();
+}
+
+void Element::cancelIterateAlways() {
+  if (deadlineHeapIndex >= 0) {
+    deadlineHeapRemove(deadlineHeapIndex);
+  }
+}
+
+void Element::deadlineHeapSwap(int a, int b) {
+  Element *tmp = deadlineHeap[a];
+  deadlineHeap[a] = deadlineHeap[b];
+  deadlineHeap[b] = tmp;
+  deadlineHeap[a]->deadlineHeapIndex = a;
+  deadlineHeap[b]->deadlineHeapIndex = b;
+}
+
+void Element::deadlineHeapUp(int index) {
+  while (index > 0) {
+    int parent = (index - 1) / 2;
+    if (deadlineHeap[parent]->iterateAlwaysDeadlineMs <=
+        deadlineHeap[index]->iterateAlwaysDeadlineMs) {
+      break;
+    }
+    deadlineHeapSwap(parent, index);
+    index = parent;
+  }
+}
+
+void Element::deadlineHeapDown(int index) {
+  while (true) {
+    int smallest = index;
+    int left = 2 * index + 1;
+    int right = left + 1;
+    if (left < deadlineHeapSize &&
+        deadlineHeap[left]->iterateAlwaysDeadlineMs <
+            deadlineHeap[smallest]->iterateAlwaysDeadlineMs) {
+      smallest = left;
+    }
+    if (right < deadlineHeapSize &&
+        deadlineHeap[right]->iterateAlwaysDeadlineMs <
+            deadlineHeap[smallest]->iterateAlwaysDeadlineMs) {
+      smallest = right;
+    }
+    if (smallest == index) {
+      return;
+    }
+    deadlineHeapSwap(index, smallest);
+    index = smallest;
+  }
+}
+
+void Element::deadlineHeapRemove(int index) {
+  Element *element = deadlineHeap[index];
+  deadlineHeapSize--;
+  if (index != deadlineHeapSize) {
+    deadlineHeapSwap(index, deadlineHeapSize);
+    deadlineHeapDown(index);
+    deadlineHeapUp(index);
+  }
+  element->deadlineHeapIndex = -1;
+}
+
 Element *Element::getElementByChannelNumber(int channelNumber) {
+  if (channelNumber >= 0 && channelNumber < SUPLA_CHANNELMAXCOUNT) {
+    if (!channelIndexValid) {
+      rebuildChannelIndex();
+    }
+    return channelIndex[channelNumber];
+  }
+
+  // elements without channel (-1) and out of range values use list scan
   Element *element = begin();
   while (element != nullptr && element->getChannelNumber() != channelNumber) {
     element = element->next();
@@ -78,6 +350,18 @@ void Element::onLoadState() {}
 
 void Element::onSaveState() {}
 
+bool Element::isStateDirtyTracked() {
+  return false;
+}
+
+bool Element::isStateDirty() {
+  return stateDirty;
+}
+
+void Element::setStateDirty(bool dirty) {
+  stateDirty = dirty;
+}
+
 void Element::onRegistered() {}
 
 void Element::iterateAlways() {}
@@ -103,6 +387,14 @@ bool Element::iterateConnected(void *srpc) {
   return response;
 }
 
+bool Element::isIteratedOnlyOnChannelUpdate() {
+  return channelUpdateIteration;
+}
+
+bool Element::isIteratedAlwaysOnDeadline() {
+  return deadlineScheduling;
+}
+
 void Element::onTimer() {}
 
 void Element::onFastTimer() {}
@@ -28,7 +28,29 @@ class Element {
   static Element *begin();
   static Element *last();
   static Element *getElementByChannelNumber(int channelNumber);
+  // Marks channel number -> Element index as outdated. It is called
+  // automatically when element is created or removed. It is rebuilt on next
+  // getElementByChannelNumber call.
+  static void invalidateChannelIndex();
+  // Returns element which has channel with given number as its primary or
+  // secondary channel
+  static Element *getOwnerOfChannel(int channelNumber);
+  // List of elements which have to be iterated by protocol layer on each
+  // iteration (see isIteratedOnlyOnChannelUpdate())
+  static Element *beginPeriodicIterate();
+  // List of elements which iterateAlways() is called on each SuplaDevice
+  // iteration (see isIteratedAlwaysOnDeadline())
+  static Element *beginAlwaysIterate();
+  // Removes from deadline scheduler all elements with deadline <= now and
+  // returns them as a list (see nextDue()). Such elements should have their
+  // iterateAlways() called.
+  static Element *takeDueElements(uint64_t now);
+  // Returns false when no element has scheduled deadline
+  static bool getNextDeadline(uint64_t *deadlineMs);
   Element *next();
+  Element *nextPeriodicIterate();
+  Element *nextAlwaysIterate();
+  Element *nextDue();
 
   // First method called on element in SuplaDevice.begin()
   // Called only if Config Storage class is configured
@@ -49,18 +71,50 @@ class Element {
   // Called only if Storage class is configured
   virtual void onSaveState();
 
+  // Returns true when element marks its state as dirty (setStateDirty()) each
+  // time data written in onSaveState() changes. For such element onSaveState()
+  // is called only when its state is dirty and its slice of state section is
+  // skipped otherwise. State save is not performed at all when no element
+  // has dirty state. Elements which don't write any state are detected
+  // during storage validation in SuplaDevice.begin().
+  // Default: false - onSaveState() is called on each state save.
+  virtual bool isStateDirtyTracked();
+  // Returns true when onSaveState() has to be called on next state save
+  bool isStateDirty();
+  void setStateDirty(bool dirty = true);
+
   // method called each time when device successfully registers to server
   virtual void onRegistered();
 
   // method called on each SuplaDevice iteration (before Network layer
   // iteration). When Device is connected, both iterateAlways() and
   // iterateConnected() are called.
+  // See also isIteratedAlwaysOnDeadline().
   virtual void iterateAlways();
 
   // method called on each Supla::Device iteration when Device is connected and
   // registered to Supla server
   virtual bool iterateConnected(void *srpc);
 
+  // Returns true when iterateConnected() only sends updates of element's
+  // channels. Such element is iterated by protocol layer only when one of its
+  // channels is on Channel's pending updates list.
+  // Element which does anything else in iterateConnected() (i.e. periodic
+  // requests to server) has to return false.
+  // Default: value set with useChannelUpdateIteration() (false unless enabled
+  // by element's class).
+  virtual bool isIteratedOnlyOnChannelUpdate();
+
+  // Returns true when element doesn't have to be iterated on each SuplaDevice
+  // iteration. Such element's iterateAlways() is called only after deadline
+  // scheduled with scheduleIterateAlways() passes (and once after element
+  // is added). Element has to schedule next deadline in iterateAlways() or
+  // in other method which starts time dependent work (i.e. turn on for
+  // some duration).
+  // Default: value set with useDeadlineScheduling() (false unless enabled by
+  // element's class).
+  virtual bool isIteratedAlwaysOnDeadline();
+
   // method called on timer interupt
   // Include all actions that have to be executed periodically regardless of
   // other SuplaDevice activities
@@ -93,8 +147,54 @@ class Element {
   Element &disableChannelState();
 
  protected:
+  static void rebuildChannelIndex();
+
+  // Requests call of iterateAlways() at given millis() timestamp. If element
+  // already has earlier deadline, it is kept. Ignored when element is not
+  // iterated on deadlines.
+  void scheduleIterateAlways(uint64_t deadlineMs);
+  void cancelIterateAlways();
+
+  // Enables/disables calling iterateAlways() only on scheduled deadlines (see
+  // isIteratedAlwaysOnDeadline()). It is enabled in constructors of Relay,
+  // InternalPinOutput, Binary, ElectricityMeter and Si7021Sonoff. Derived
+  // class which overrides iterateAlways() and doesn't schedule its deadlines
+  // has to call useDeadlineScheduling(false) in its constructor.
+  void useDeadlineScheduling(bool enabled = true);
+
+  // Enables/disables calling iterateConnected() only when one of element's
+  // channels has pending update (see isIteratedOnlyOnChannelUpdate()). It is
+  // enabled in constructors of in-tree sensors, relays, RGBW, roller
+  // shutters, ElectricityMeter and ActionTrigger. Derived class which does
+  // periodic work in iterateConnected() has to call
+  // useChannelUpdateIteration(false) in its constructor.
+  void useChannelUpdateIteration(bool enabled = true);
+
+  static void deadlineHeapSwap(int a, int b);
+  static void deadlineHeapUp(int index);
+  static void deadlineHeapDown(int index);
+  static void deadlineHeapRemove(int index);
+
   static Element *firstPtr;
+  static Element *channelIndex[SUPLA_CHANNELMAXCOUNT];
+  static Element *channelOwnerIndex[SUPLA_CHANNELMAXCOUNT];
+  static Element *firstPeriodicIteratePtr;
+  static Element *firstAlwaysIteratePtr;
+  static bool channelIndexValid;
+  // binary min-heap of elements ordered by iterateAlwaysDeadlineMs
+  static Element **deadlineHeap;
+  static int deadlineHeapSize;
+  static int deadlineHeapCapacity;
   Element *nextPtr;
+  Element *nextPeriodicIteratePtr;
+  Element *nextAlwaysIteratePtr;
+  Element *nextDuePtr;
+  uint64_t iterateAlwaysDeadlineMs;
+  int deadlineHeapIndex;
+  // may be set from timer interrupt (i.e. by ImpulseCounter)
+  volatile bool stateDirty;
+  bool deadlineScheduling;
+  bool channelUpdateIteration;
 };
 
 };  // namespace Supla
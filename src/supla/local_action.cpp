@@ -22,26 +22,27 @@ ActionHandlerClient::ActionHandlerClient() {
   if (begin == nullptr) {
     begin = this;
   } else {
-    auto ptr = begin;
-    while (ptr->next) {
-      ptr = ptr->next;
-    }
-    ptr->next = this;
+    end->next = this;
+    prev = end;
   }
+  end = this;
 }
 
 ActionHandlerClient::~ActionHandlerClient() {
-  if (begin == this) {
-    begin = next;
-    return;
+  if (trigger) {
+    trigger->removeClient(this);
   }
 
-  auto ptr = begin;
-  while (ptr->next != this) {
-    ptr = ptr->next;
+  if (prev) {
+    prev->next = next;
+  } else {
+    begin = next;
+  }
+  if (next) {
+    next->prev = prev;
+  } else {
+    end = prev;
   }
-
-  ptr->next = ptr->next->next;
 }
 
 bool ActionHandlerClient::isEnabled() {
@@ -64,23 +65,55 @@ void ActionHandlerClient::setAlwaysEnabled() {
 }
 
 ActionHandlerClient *ActionHandlerClient::begin = nullptr;
+ActionHandlerClient *ActionHandlerClient::end = nullptr;
 
 LocalAction::~LocalAction() {
-  auto ptr = ActionHandlerClient::begin;
+  auto ptr = clientsBegin;
+  clientsBegin = nullptr;
   while (ptr) {
-    if (ptr->trigger == this) {
-      auto tbdptr = ptr;
-      ptr = ptr->next;
-      if (tbdptr->client->deleteClient()) {
-        delete tbdptr->client;
-      }
-      delete tbdptr;
-    } else {
-      ptr = ptr->next;
+    auto tbdptr = ptr;
+    ptr = ptr->nextForTrigger;
+    tbdptr->trigger = nullptr;
+    if (tbdptr->client->deleteClient()) {
+      delete tbdptr->client;
     }
+    delete tbdptr;
   }
 }
 
+void LocalAction::insertClient(ActionHandlerClient *client) {
+  // clients with the same event are kept in order of adding
+  ActionHandlerClient **ptr = &clientsBegin;
+  while (*ptr && (*ptr)->onEvent <= client->onEvent) {
+    ptr = &(*ptr)->nextForTrigger;
+  }
+  client->nextForTrigger = *ptr;
+  *ptr = client;
+}
+
+void LocalAction::removeClient(ActionHandlerClient *client) {
+  ActionHandlerClient **ptr = &clientsBegin;
+  while (*ptr) {
+    if (*ptr == client) {
+      *ptr = client->nextForTrigger;
+      client->nextForTrigger = nullptr;
+      return;
+    }
+    ptr = &(*ptr)->nextForTrigger;
+  }
+}
+
+ActionHandlerClient *LocalAction::findFirstClient(int event) {
+  auto ptr = clientsBegin;
+  while (ptr && ptr->onEvent < event) {
+    ptr = ptr->nextForTrigger;
+  }
+  if (ptr && ptr->onEvent == event) {
+    return ptr;
+  }
+  return nullptr;
+}
+
 void LocalAction::addAction(int action, ActionHandler &client, int event,
     bool alwaysEnabled) {
   auto ptr = new ActionHandlerClient;
@@ -88,6 +121,7 @@ void LocalAction::addAction(int action, ActionHandler &client, int event,
   ptr->client = &client;
   ptr->onEvent = event;
   ptr->action = action;
+  insertClient(ptr);
   ptr->client->activateAction(action);
   if (alwaysEnabled) {
     ptr->setAlwaysEnabled();
@@ -100,12 +134,12 @@ void LocalAction::addAction(int action, ActionHandler *client, int event,
 }
 
 void LocalAction::runAction(int event) {
-  auto ptr = ActionHandlerClient::begin;
-  while (ptr) {
-    if (ptr->trigger == this && ptr->onEvent == event && ptr->isEnabled()) {
+  auto ptr = findFirstClient(event);
+  while (ptr && ptr->onEvent == event) {
+    if (ptr->isEnabled()) {
       ptr->client->handleAction(event, ptr->action);
     }
-    ptr = ptr->next;
+    ptr = ptr->nextForTrigger;
   }
 }
 
@@ -114,14 +148,7 @@ ActionHandlerClient *LocalAction::getClientListPtr() {
 }
 
 bool LocalAction::isEventAlreadyUsed(int event) {
-  auto ptr = ActionHandlerClient::begin;
-  while (ptr) {
-    if (ptr->trigger == this && ptr->onEvent == event) {
-      return true;
-    }
-    ptr = ptr->next;
-  }
-  return false;
+  return findFirstClient(event) != nullptr;
 }
 
 void LocalAction::disableOtherClients(const ActionHandler &client, int event) {
@@ -133,36 +160,27 @@ void LocalAction::enableOtherClients(const ActionHandler &client, int event) {
 }
 
 void LocalAction::disableOtherClients(const ActionHandler *client, int event) {
-  auto ptr = ActionHandlerClient::begin;
-  while (ptr) {
-    if (ptr->trigger == this && ptr->onEvent == event &&
-        ptr->client != client) {
+  auto ptr = findFirstClient(event);
+  while (ptr && ptr->onEvent == event) {
+    if (ptr->client != client) {
       ptr->disable();
     }
-    ptr = ptr->next;
+    ptr = ptr->nextForTrigger;
   }
 }
 
 void LocalAction::enableOtherClients(const ActionHandler *client, int event) {
-  auto ptr = ActionHandlerClient::begin;
-  while (ptr) {
-    if (ptr->trigger == this && ptr->onEvent == event &&
-        ptr->client != client) {
+  auto ptr = findFirstClient(event);
+  while (ptr && ptr->onEvent == event) {
+    if (ptr->client != client) {
       ptr->enable();
     }
-    ptr = ptr->next;
+    ptr = ptr->nextForTrigger;
   }
 }
 
 ActionHandlerClient *LocalAction::getHandlerForFirstClient(int event) {
-  auto ptr = ActionHandlerClient::begin;
-  while (ptr) {
-    if (ptr->trigger == this && ptr->onEvent == event) {
-      return ptr;
-    }
-    ptr = ptr->next;
-  }
-  return nullptr;
+  return findFirstClient(event);
 }
 
 };  // namespace Supla
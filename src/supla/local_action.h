@@ -33,10 +33,15 @@ class ActionHandlerClient {
 
   LocalAction *trigger = nullptr;
   ActionHandler *client = nullptr;
+  // global list of all clients
   ActionHandlerClient *next = nullptr;
+  ActionHandlerClient *prev = nullptr;
+  // list of clients of the same trigger, ordered by onEvent
+  ActionHandlerClient *nextForTrigger = nullptr;
   uint8_t onEvent = 0;
   uint8_t action = 0;
   static ActionHandlerClient *begin;
+  static ActionHandlerClient *end;
 
   bool isEnabled();
 
@@ -70,6 +75,16 @@ class LocalAction {
   virtual void enableOtherClients(const ActionHandler *client, int event);
 
   static ActionHandlerClient *getClientListPtr();
+
+ protected:
+  friend class ActionHandlerClient;
+
+  // Returns first client registered for event, or nullptr
+  ActionHandlerClient *findFirstClient(int event);
+  void insertClient(ActionHandlerClient *client);
+  void removeClient(ActionHandlerClient *client);
+
+  ActionHandlerClient *clientsBegin = nullptr;
 };
 
 };  // namespace Supla
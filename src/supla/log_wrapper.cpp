@@ -31,7 +31,7 @@ void supla_logf(int __pri, const __FlashStringHelper *__fmt, ...) {
   char *buffer = NULL;
   int size = 0;
 
-  if (__fmt == NULL) return;
+  if (__fmt == NULL || __pri > supla_log_level) return;
 
   String fmt(__fmt);
 
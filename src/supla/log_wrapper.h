@@ -52,30 +52,59 @@ void supla_logf(int __pri, const __FlashStringHelper *__fmt, ...);
 #define SUPLA_LOG_ERROR(arg_format, ...) {};
 #endif
 
+// SUPLA_LOG_COMPILE_LEVEL removes logs with priority above given level at
+// compile time, i.e. -DSUPLA_LOG_COMPILE_LEVEL=LOG_INFO removes debug and
+// verbose logs. Arguments of removed logs are not evaluated.
+#ifdef SUPLA_LOG_COMPILE_LEVEL
+#if SUPLA_LOG_COMPILE_LEVEL < LOG_VERBOSE && !defined(SUPLA_LOG_VERBOSE)
+#define SUPLA_LOG_VERBOSE(arg_format, ...) do {} while (0)
+#endif
+#if SUPLA_LOG_COMPILE_LEVEL < LOG_DEBUG && !defined(SUPLA_LOG_DEBUG)
+#define SUPLA_LOG_DEBUG(arg_format, ...) do {} while (0)
+#endif
+#if SUPLA_LOG_COMPILE_LEVEL < LOG_INFO && !defined(SUPLA_LOG_INFO)
+#define SUPLA_LOG_INFO(arg_format, ...) do {} while (0)
+#endif
+#if SUPLA_LOG_COMPILE_LEVEL < LOG_WARNING && !defined(SUPLA_LOG_WARNING)
+#define SUPLA_LOG_WARNING(arg_format, ...) do {} while (0)
+#endif
+#if SUPLA_LOG_COMPILE_LEVEL < LOG_ERR && !defined(SUPLA_LOG_ERROR)
+#define SUPLA_LOG_ERROR(arg_format, ...) do {} while (0)
+#endif
+#endif  // SUPLA_LOG_COMPILE_LEVEL
+
+// Level is checked before call, so disabled logs don't format message and
+// don't evaluate its arguments (see supla_log_set_level)
+#define SUPLA_LOG_AT_LEVEL(level, arg_format, ...)        \
+  do {                                                    \
+    if ((level) <= supla_log_level) {                     \
+      supla_logf((level), F(arg_format), ## __VA_ARGS__); \
+    }                                                     \
+  } while (0)
 
 #ifndef SUPLA_LOG_VERBOSE
 #define SUPLA_LOG_VERBOSE(arg_format, ...) \
-            supla_logf(LOG_VERBOSE, F(arg_format) , ## __VA_ARGS__)
+            SUPLA_LOG_AT_LEVEL(LOG_VERBOSE, arg_format, ## __VA_ARGS__)
 #endif
 
 #ifndef SUPLA_LOG_DEBUG
 #define SUPLA_LOG_DEBUG(arg_format, ...) \
-            supla_logf(LOG_DEBUG, F(arg_format) , ## __VA_ARGS__)
+            SUPLA_LOG_AT_LEVEL(LOG_DEBUG, arg_format, ## __VA_ARGS__)
 #endif
 
 #ifndef SUPLA_LOG_INFO
 #define SUPLA_LOG_INFO(arg_format, ...) \
-            supla_logf(LOG_INFO, F(arg_format) , ## __VA_ARGS__)
+            SUPLA_LOG_AT_LEVEL(LOG_INFO, arg_format, ## __VA_ARGS__)
 #endif
 
 #ifndef SUPLA_LOG_WARNING
 #define SUPLA_LOG_WARNING(arg_format, ...) \
-            supla_logf(LOG_WARNING, F(arg_format) , ## __VA_ARGS__)
+            SUPLA_LOG_AT_LEVEL(LOG_WARNING, arg_format, ## __VA_ARGS__)
 #endif
 
 #ifndef SUPLA_LOG_ERROR
 #define SUPLA_LOG_ERROR(arg_format, ...) \
-            supla_logf(LOG_ERR, F(arg_format) , ## __VA_ARGS__)
+            SUPLA_LOG_AT_LEVEL(LOG_ERR, arg_format, ## __VA_ARGS__)
 #endif
 
 #endif  // SRC_SUPLA_LOG_WRAPPER_H_
@@ -43,6 +43,10 @@ int Supla::Client::connect(IPAddress ip, uint16_t port) {
 }
 
 int Supla::Client::connect(const char *host, uint16_t port) {
+  if (isConnecting()) {
+    return connectImp(host, port);
+  }
+
   if (sslEnabled) {
     if (rootCACert == nullptr) {
       SUPLA_LOG_WARNING(
@@ -59,6 +63,10 @@ int Supla::Client::connect(const char *host, uint16_t port) {
   return connectImp(host, port);
 }
 
+bool Supla::Client::isConnecting() {
+  return false;
+}
+
 size_t Supla::Client::write(uint8_t data) {
   return write(&data, sizeof(data));
 }
@@ -112,6 +120,10 @@ void Supla::Client::setSSLEnabled(bool enabled) {
   sslEnabled = enabled;
 }
 
+bool Supla::Client::isSSLEnabled() const {
+  return sslEnabled;
+}
+
 void Supla::Client::setCACert(const char *rootCA) {
   rootCACert = rootCA;
 }
@@ -153,3 +165,7 @@ void Supla::Client::setDebugLogs(bool debug) {
   debugLogs = debug;
 }
 
+void Supla::Client::setNonBlockingConnect(bool enabled) {
+  nonBlockingConnect = enabled;
+}
+
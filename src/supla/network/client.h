@@ -35,6 +35,10 @@ class Client {
   virtual void stop() = 0;
   virtual uint8_t connected() = 0;
   virtual void setTimeoutMs(uint16_t timeoutMs) = 0;
+  // Returns true when connect() returned 0 because connection is still being
+  // established in background. In such case connect() should be called again
+  // (with the same parameters) on next iteration.
+  virtual bool isConnecting();
 
   int connect(IPAddress ip, uint16_t port);
   int connect(const char *host, uint16_t port);
@@ -51,9 +55,13 @@ class Client {
 
   // SSL configuration
   virtual void setSSLEnabled(bool enabled);
+  bool isSSLEnabled() const;
   void setCACert(const char *rootCA);
 
   void setDebugLogs(bool);
+  // Allows connect() to return before connection is established, when
+  // supported by client. See isConnecting().
+  void setNonBlockingConnect(bool enabled);
 
  protected:
   virtual int connectImp(const char *host, uint16_t port) = 0;
@@ -62,6 +70,7 @@ class Client {
 
   bool sslEnabled = false;
   bool debugLogs = false;
+  bool nonBlockingConnect = false;
   const char *rootCACert = nullptr;
   unsigned int rootCACertSize = 0;
 };
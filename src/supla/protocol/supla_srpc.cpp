@@ -33,11 +33,14 @@ Supla::Protocol::SuplaSrpc::SuplaSrpc(SuplaDeviceClass *sdc, int version)
     : Supla::Protocol::ProtocolLayer(sdc), version(version) {
   client = Supla::ClientBuilder();
   client->setDebugLogs(true);
+  client->setNonBlockingConnect(true);
 }
 
 Supla::Protocol::SuplaSrpc::~SuplaSrpc() {
   delete client;
   client = nullptr;
+  delete[] uplinkBatchBuffer;
+  uplinkBatchBuffer = nullptr;
 }
 
 bool Supla::Protocol::SuplaSrpc::onLoadConfig() {
@@ -96,6 +99,14 @@ bool Supla::Protocol::SuplaSrpc::onLoadConfig() {
       suplaCACert = supla3rdPartyCACert;
     }
 
+    uint32_t batchWindowMs = 0;
+    if (cfg->getUInt32("uplink_batch_window_ms", &batchWindowMs) &&
+        batchWindowMs > 0) {
+      uint8_t batchChannels = 10;
+      cfg->getUInt8("uplink_batch_channels", &batchChannels);
+      setUplinkBatching(batchWindowMs, batchChannels);
+    }
+
     cfg->getUInt8("security_level", &securityLevel);
     if (securityLevel > 2) {
       securityLevel = 0;
@@ -170,6 +181,11 @@ void *Supla::Protocol::SuplaSrpc::getSrpcPtr() {
   return srpc;
 }
 
+bool Supla::Protocol::SuplaSrpc::hasPendingInput() {
+  return srpc != nullptr &&
+         srpc_input_dataexists(srpc) == SUPLA_RESULT_TRUE;
+}
+
 _supla_int_t Supla::dataRead(void *buf, _supla_int_t count, void *userParams) {
   auto srpcLayer = reinterpret_cast<Supla::Protocol::SuplaSrpc*>(userParams);
   return srpcLayer->client->read(reinterpret_cast<uint8_t*>(buf), count);
@@ -177,6 +193,14 @@ _supla_int_t Supla::dataRead(void *buf, _supla_int_t count, void *userParams) {
 
 _supla_int_t Supla::dataWrite(void *buf, _supla_int_t count, void *userParams) {
   auto srpcLayer = reinterpret_cast<Supla::Protocol::SuplaSrpc *>(userParams);
+  if (srpcLayer->appendToUplinkBatch(reinterpret_cast<uint8_t *>(buf),
+                                     count)) {
+    return count;
+  }
+  // packets which are not batched can't overtake already collected ones
+  if (!srpcLayer->flushUplinkBatch()) {
+    return -1;
+  }
   _supla_int_t r =
       srpcLayer->client->write(reinterpret_cast<uint8_t *>(buf), count);
   if (r > 0) {
@@ -508,6 +532,9 @@ void Supla::Protocol::SuplaSrpc::iterate(uint64_t _millis) {
       //      lastConnectionResetCounter = 0;
       SUPLA_LOG_INFO("Connected to Supla Server");
 
+    } else if (client->isConnecting()) {
+      // connection is established in background, continue on next iteration
+      return;
     } else {
       sdc->status(STATUS_SERVER_DISCONNECTED, "Not connected to Supla server");
       SUPLA_LOG_DEBUG("Connection fail (%d). Server: %s",
@@ -563,14 +590,50 @@ void Supla::Protocol::SuplaSrpc::iterate(uint64_t _millis) {
       disconnect();
     }
 
-    // Iterate all elements
-    for (auto element = Supla::Element::begin(); element != nullptr;
-         element = element->next()) {
+    // Iterate elements which have to be called on each iteration
+    for (auto element = Supla::Element::beginPeriodicIterate();
+         element != nullptr;
+         element = element->nextPeriodicIterate()) {
       if (!element->iterateConnected(srpc)) {
-        break;
+        return;
       }
       delay(0);
     }
+
+    // Iterate remaining elements only when their channels have something
+    // to send
+    Supla::Channel::removeSentPendingUpdates();
+    uplinkBatchCollecting = (uplinkBatchBuffer != nullptr);
+    for (auto channel = Supla::Channel::getFirstPendingUpdate();
+         channel != nullptr;
+         channel = channel->getNextPendingUpdate()) {
+      auto element =
+          Supla::Element::getOwnerOfChannel(channel->getChannelNumber());
+      if (element == nullptr || !element->isIteratedOnlyOnChannelUpdate()) {
+        // it was already handled above
+        continue;
+      }
+      if (!element->iterateConnected(srpc)) {
+        if (!uplinkBatchCollecting) {
+          break;
+        }
+        uplinkBatchChannelCount++;
+        if (uplinkBatchChannelCount >= uplinkBatchMaxChannels) {
+          break;
+        }
+        // 100 ms limit between channel updates is applied per batch, so
+        // next channel can be added to the same batch
+        Supla::Channel::lastCommunicationTimeMs = 0;
+      }
+      delay(0);
+    }
+    uplinkBatchCollecting = false;
+
+    if (uplinkBatchPacketCount > 0 &&
+        (uplinkBatchChannelCount >= uplinkBatchMaxChannels ||
+         _millis - uplinkBatchStartMs >= uplinkBatchFlushWindowMs)) {
+      flushUplinkBatch();
+    }
     return;
   } else if (registered == 2) {
     // Server rejected registration
@@ -583,6 +646,7 @@ void Supla::Protocol::SuplaSrpc::iterate(uint64_t _millis) {
 
 void Supla::Protocol::SuplaSrpc::disconnect() {
   registered = 0;
+  clearUplinkBatch();
   client->stop();
 }
 
@@ -626,3 +690,89 @@ uint32_t Supla::Protocol::SuplaSrpc::getConnectionFailTime() {
   // connectionFailCounter is incremented every 10 s
   return connectionFailCounter * 10;
 }
+
+void Supla::Protocol::SuplaSrpc::setUplinkBatching(uint32_t flushWindowMs,
+                                                  uint8_t maxChannels) {
+  clearUplinkBatch();
+  delete[] uplinkBatchBuffer;
+  uplinkBatchBuffer = nullptr;
+  uplinkBatchFlushWindowMs = flushWindowMs;
+  uplinkBatchMaxChannels = maxChannels > 0 ? maxChannels : 1;
+  if (flushWindowMs > 0) {
+    uplinkBatchBuffer = new uint8_t[SUPLA_UPLINK_BATCH_BUFFER_SIZE];
+    SUPLA_LOG_INFO("Uplink batching enabled (window %d ms, max %d channels)",
+                   flushWindowMs,
+                   uplinkBatchMaxChannels);
+  }
+}
+
+bool Supla::Protocol::SuplaSrpc::appendToUplinkBatch(const uint8_t *buf,
+                                                     int size) {
+  if (!uplinkBatchCollecting || uplinkBatchBuffer == nullptr) {
+    return false;
+  }
+  if (uplinkBatchSize + size > SUPLA_UPLINK_BATCH_BUFFER_SIZE) {
+    flushUplinkBatch();
+    if (size > SUPLA_UPLINK_BATCH_BUFFER_SIZE) {
+      return false;
+    }
+  }
+  if (uplinkBatchPacketCount == 0) {
+    uplinkBatchStartMs = millis();
+  }
+  memcpy(uplinkBatchBuffer + uplinkBatchSize, buf, size);
+  uplinkBatchSize += size;
+  uplinkBatchPacketCount++;
+  return true;
+}
+
+bool Supla::Protocol::SuplaSrpc::flushUplinkBatch() {
+  if (uplinkBatchPacketCount == 0) {
+    return true;
+  }
+  int r = client->write(uplinkBatchBuffer, uplinkBatchSize);
+  if (r != uplinkBatchSize) {
+    // partially sent batch breaks packet stream, so connection is reset
+    SUPLA_LOG_WARNING("Uplink batch write failed (%d/%d bytes, %d packets)",
+                      r,
+                      uplinkBatchSize,
+                      uplinkBatchPacketCount);
+    sdc->status(STATUS_ITERATE_FAIL, "Communication failure");
+    // stops iteration over pending channel updates
+    uplinkBatchCollecting = false;
+    disconnect();
+    lastIterateTime = millis();
+    waitForIterate = 5000;
+    return false;
+  }
+  updateLastSentTime();
+  uplinkBatchTotalPackets += uplinkBatchPacketCount;
+  uplinkBatchTotalWrites++;
+  SUPLA_LOG_VERBOSE(
+      "Uplink batch: %d packets (%d bytes) sent in one write, total saved "
+      "writes: %d",
+      uplinkBatchPacketCount,
+      uplinkBatchSize,
+      getUplinkBatchSavedWrites());
+  clearUplinkBatch();
+  // next batch will wait at least 100 ms (see Element::iterateConnected)
+  Supla::Channel::lastCommunicationTimeMs = millis();
+  return true;
+}
+
+void Supla::Protocol::SuplaSrpc::clearUplinkBatch() {
+  uplinkBatchSize = 0;
+  uplinkBatchPacketCount = 0;
+  uplinkBatchChannelCount = 0;
+}
+
+uint32_t Supla::Protocol::SuplaSrpc::getUplinkBatchSavedWrites() {
+  return uplinkBatchTotalPackets - uplinkBatchTotalWrites;
+}
+
+uint32_t Supla::Protocol::SuplaSrpc::getUplinkBatchEstimatedTlsSavedBytes() {
+  if (client == nullptr || !client->isSSLEnabled()) {
+    return 0;
+  }
+  return getUplinkBatchSavedWrites() * SUPLA_UPLINK_BATCH_TLS_RECORD_OVERHEAD;
+}
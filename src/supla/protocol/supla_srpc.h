@@ -23,6 +23,11 @@
 
 #include "protocol_layer.h"
 
+#define SUPLA_UPLINK_BATCH_BUFFER_SIZE 1024
+// Estimated TLS record overhead (header, explicit nonce, AEAD tag) which is
+// saved on each client write that is avoided by batching
+#define SUPLA_UPLINK_BATCH_TLS_RECORD_OVERHEAD 29
+
 namespace Supla {
 
 class Client;
@@ -42,6 +47,9 @@ class SuplaSrpc : public ProtocolLayer {
   uint32_t getConnectionFailTime() override;
 
   void *getSrpcPtr();
+  // Returns true when data received from server is buffered in srpc and
+  // waits for next iterate
+  bool hasPendingInput();
 
   void onVersionError(TSDC_SuplaVersionError *versionError);
   void onRegisterResult(TSD_SuplaRegisterDeviceResult *register_device_result);
@@ -57,10 +65,30 @@ class SuplaSrpc : public ProtocolLayer {
   void setSuplaCACert(const char *);
   void setSupla3rdPartyCACert(const char *);
 
+  // Enables batching of channel updates. Packets generated by elements with
+  // pending channel updates are collected in a buffer and sent to server
+  // with one client write when maxChannels channels were collected, or when
+  // flushWindowMs passed since the first packet in a batch.
+  // flushWindowMs == 0 disables batching (default).
+  void setUplinkBatching(uint32_t flushWindowMs, uint8_t maxChannels = 10);
+  // Sends all collected packets to server. On failed or partial write
+  // connection is closed (collected packets are dropped - all channel values
+  // are sent again during registration) and false is returned.
+  bool flushUplinkBatch();
+  // Returns count of client writes which were avoided by batching
+  uint32_t getUplinkBatchSavedWrites();
+  // Returns estimated count of TLS record overhead bytes avoided by batching.
+  // Batching doesn't change amount of sent data, so without TLS it is 0.
+  uint32_t getUplinkBatchEstimatedTlsSavedBytes();
+
+  // Adds packet to current batch. Returns false if batching is not active
+  bool appendToUplinkBatch(const uint8_t *buf, int size);
+
   Supla::Client *client = nullptr;
 
  protected:
   bool ping();
+  void clearUplinkBatch();
 
   void *srpc = nullptr;
   int version = 0;
@@ -77,6 +105,17 @@ class SuplaSrpc : public ProtocolLayer {
 
   int port = -1;
 
+  uint8_t *uplinkBatchBuffer = nullptr;
+  int uplinkBatchSize = 0;
+  uint32_t uplinkBatchFlushWindowMs = 0;
+  uint8_t uplinkBatchMaxChannels = 0;
+  uint8_t uplinkBatchChannelCount = 0;
+  uint16_t uplinkBatchPacketCount = 0;
+  bool uplinkBatchCollecting = false;
+  uint64_t uplinkBatchStartMs = 0;
+  uint32_t uplinkBatchTotalPackets = 0;
+  uint32_t uplinkBatchTotalWrites = 0;
+
   const char *suplaCACert = nullptr;
   const char *supla3rdPartyCACert = nullptr;
 };
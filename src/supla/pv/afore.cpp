@@ -40,6 +40,8 @@ Afore::Afore(IPAddress ip, int port, const char *loginAndPass)
       dataFetchInProgress(false),
       connectionTimeoutMs(0) {
   refreshRateSec = 15;
+  // data is fetched from inverter in iterateConnected
+  useChannelUpdateIteration(false);
   int len = strlen(loginAndPass);
   if (len > LOGIN_AND_PASSOWORD_MAX_LENGTH) {
     len = LOGIN_AND_PASSOWORD_MAX_LENGTH;
@@ -113,6 +115,10 @@ void Afore::iterateAlways() {
     setPowerActive(0, currentPower);
     updateChannelValues();
   }
+  if (dataFetchInProgress) {
+    // response is read on each iteration
+    scheduleIterateAlways(0);
+  }
 }
 
 bool Afore::iterateConnected(void *srpc) {
@@ -123,6 +129,7 @@ bool Afore::iterateConnected(void *srpc) {
       if (client->connect(ip, port)) {
         retryCounter = 0;
         dataFetchInProgress = true;
+        scheduleIterateAlways(0);
         connectionTimeoutMs = lastReadTime;
 
         client->print("GET /status.html HTTP/1.1\nAuthorization: Basic ");
@@ -48,6 +48,8 @@ Fronius::Fronius(IPAddress ip, int port, int deviceId)
       connectionTimeoutMs(0) {
   refreshRateSec = 15;
   client = Supla::ClientBuilder();
+  // data is fetched from inverter in iterateConnected
+  useChannelUpdateIteration(false);
 }
 
 Fronius::~Fronius() {
@@ -158,6 +160,10 @@ void Fronius::iterateAlways() {
     setFreq(currentFreq);
     updateChannelValues();
   }
+  if (dataFetchInProgress) {
+    // response is read on each iteration
+    scheduleIterateAlways(0);
+  }
 }
 
 bool Fronius::iterateConnected(void *srpc) {
@@ -168,6 +174,7 @@ bool Fronius::iterateConnected(void *srpc) {
       if (client->connect(ip, port)) {
         retryCounter = 0;
         dataFetchInProgress = true;
+        scheduleIterateAlways(0);
         connectionTimeoutMs = lastReadTime;
 
         char buf[200];
@@ -45,6 +45,8 @@ SolarEdge::SolarEdge(const char *apiKeyValue,
   // SolarEdge api allows 300 requests daily, so it is one request per almost 5
   // min
   refreshRateSec = 6 * 60;  // refresh every 6 min
+  // data is fetched from inverter in iterateConnected
+  useChannelUpdateIteration(false);
 
   int len = strlen(apiKeyValue);
   if (len > APIKEY_MAX_LENGTH) {
@@ -297,6 +299,10 @@ void SolarEdge::iterateAlways() {
     temperature = TEMPERATURE_NOT_AVAILABLE;
     updateChannelValues();
   }
+  if (dataFetchInProgress) {
+    // response is read on each iteration
+    scheduleIterateAlways(0);
+  }
 }
 
 bool SolarEdge::iterateConnected(void *srpc) {
@@ -316,6 +322,7 @@ bool SolarEdge::iterateConnected(void *srpc) {
         if (returnCode) {
           retryCounter = 0;
           dataFetchInProgress = true;
+          scheduleIterateAlways(0);
           connectionTimeoutMs = lastReadTime;
           Serial.println(F("Succesful connect"));
 
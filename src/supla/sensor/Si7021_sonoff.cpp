@@ -24,6 +24,7 @@ Si7021Sonoff::Si7021Sonoff(int pin)
       temperature(TEMPERATURE_NOT_AVAILABLE),
       humidity(HUMIDITY_NOT_AVAILABLE),
       retryCount(0) {
+  useDeadlineScheduling();
 }
 
 double Si7021Sonoff::getTemp() {
@@ -40,6 +41,7 @@ void Si7021Sonoff::iterateAlways() {
     read();
     channel.setNewValue(getTemp(), getHumi());
   }
+  scheduleIterateAlways(lastReadTime + 10001);
 }
 
 void Si7021Sonoff::onInit() {
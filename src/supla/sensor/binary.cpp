@@ -23,6 +23,8 @@
 Supla::Sensor::Binary::Binary(int pin, bool pullUp, bool invertLogic)
     : pin(pin), pullUp(pullUp), invertLogic(invertLogic), lastReadTime(0) {
   channel.setType(SUPLA_CHANNELTYPE_SENSORNO);
+  useDeadlineScheduling();
+  useChannelUpdateIteration();
 }
 
 bool Supla::Sensor::Binary::getValue() {
@@ -38,6 +40,7 @@ void Supla::Sensor::Binary::iterateAlways() {
     lastReadTime = millis();
     channel.setNewValue(getValue());
   }
+  scheduleIterateAlways(lastReadTime + 101);
 }
 
 void Supla::Sensor::Binary::onInit() {
@@ -21,6 +21,7 @@ Supla::Sensor::Distance::Distance() {
   channel.setType(SUPLA_CHANNELTYPE_DISTANCESENSOR);
   channel.setDefault(SUPLA_CHANNELFNC_DISTANCESENSOR);
   channel.setNewValue(DISTANCE_NOT_AVAILABLE);
+  useChannelUpdateIteration();
 }
 
 double Supla::Sensor::Distance::getValue() {
@@ -20,6 +20,7 @@
 #include <supla/time.h>
 
 #include "../condition.h"
+#include "../condition_rule_set.h"
 #include "../events.h"
 #include "electricity_meter.h"
 
@@ -33,6 +34,8 @@ Supla::Sensor::ElectricityMeter::ElectricityMeter()
     rawCurrent[i] = 0;
   }
   currentMeasurementAvailable = false;
+  useDeadlineScheduling();
+  useChannelUpdateIteration();
 }
 
 void Supla::Sensor::ElectricityMeter::updateChannelValues() {
@@ -245,6 +248,7 @@ void Supla::Sensor::ElectricityMeter::iterateAlways() {
     readValuesFromDevice();
     updateChannelValues();
   }
+  scheduleIterateAlways(lastReadTime + refreshRateSec * 1000 + 1);
 }
 
 // Implement this method to reset stored energy value (i.e. to set energy
@@ -261,6 +265,7 @@ void Supla::Sensor::ElectricityMeter::setRefreshRate(unsigned int sec) {
   if (refreshRateSec == 0) {
     refreshRateSec = 1;
   }
+  scheduleIterateAlways(lastReadTime + refreshRateSec * 1000 + 1);
 }
 
 // TODO(klew): move those addAction methods to separate parent
@@ -270,7 +275,8 @@ void Supla::Sensor::ElectricityMeter::addAction(int action,
                                                 Supla::Condition *condition) {
   condition->setClient(client);
   condition->setSource(this);
-  LocalAction::addAction(action, condition, Supla::ON_CHANGE);
+  Supla::ConditionRuleSet::addCondition(
+      &conditionRules, this, action, condition, false);
 }
 
 void Supla::Sensor::ElectricityMeter::addAction(int action,
@@ -25,6 +25,10 @@
 #include "../element.h"
 #include "../local_action.h"
 
+namespace Supla {
+class ConditionRuleSet;
+}  // namespace Supla
+
 #define MAX_PHASES 3
 
 namespace Supla {
@@ -147,6 +151,7 @@ class ElectricityMeter : public Element, public LocalAction {
   bool currentMeasurementAvailable;
   uint64_t lastReadTime;
   unsigned int refreshRateSec;
+  ConditionRuleSet *conditionRules = nullptr;
 };
 
 };  // namespace Sensor
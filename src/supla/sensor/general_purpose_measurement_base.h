@@ -27,6 +27,7 @@ class GeneralPurposeMeasurementBase : public ChannelElement {
  public:
   GeneralPurposeMeasurementBase() : lastReadTime(0) {
     channel.setType(SUPLA_CHANNELTYPE_GENERAL_PURPOSE_MEASUREMENT);
+    useChannelUpdateIteration();
   }
 
   virtual double getValue() = 0;
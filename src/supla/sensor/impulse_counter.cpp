@@ -38,6 +38,7 @@ ImpulseCounter::ImpulseCounter(int _impulsePin,
       inputPullup(_inputPullup),
       counter(0) {
   channel.setType(SUPLA_CHANNELTYPE_IMPULSE_COUNTER);
+  useChannelUpdateIteration();
 
   prevState = (detectLowToHigh == true ? LOW : HIGH);
 
@@ -69,6 +70,10 @@ void ImpulseCounter::onSaveState() {
   Supla::Storage::WriteState((unsigned char *)&counter, sizeof(counter));
 }
 
+bool ImpulseCounter::isStateDirtyTracked() {
+  return true;
+}
+
 void ImpulseCounter::onLoadState() {
   unsigned _supla_int64_t data;
   if (Supla::Storage::ReadState((unsigned char *)&data, sizeof(data))) {
@@ -78,6 +83,7 @@ void ImpulseCounter::onLoadState() {
 
 void ImpulseCounter::setCounter(unsigned _supla_int64_t value) {
   counter = value;
+  setStateDirty();
   channel.setNewValue(value);
   SUPLA_LOG_DEBUG(
             "ImpulseCounter[%d] - set counter to %d",
@@ -87,6 +93,7 @@ void ImpulseCounter::setCounter(unsigned _supla_int64_t value) {
 
 void ImpulseCounter::incCounter() {
   counter++;
+  setStateDirty();
   channel.setNewValue(getCounter());
 }
 
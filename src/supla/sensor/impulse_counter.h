@@ -35,6 +35,7 @@ class ImpulseCounter : public ChannelElement, public ActionHandler {
   void onInit();
   void onLoadState();
   void onSaveState();
+  bool isStateDirtyTracked();
   void onFastTimer();
   void handleAction(int event, int action);
 
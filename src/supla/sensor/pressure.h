@@ -31,6 +31,7 @@ class Pressure : public ChannelElement {
     channel.setType(SUPLA_CHANNELTYPE_PRESSURESENSOR);
     channel.setDefault(SUPLA_CHANNELFNC_PRESSURESENSOR);
     channel.setNewValue(PRESSURE_NOT_AVAILABLE);
+    useChannelUpdateIteration();
   }
 
   virtual double getValue() {
@@ -31,6 +31,7 @@ class Rain : public ChannelElement {
     channel.setType(SUPLA_CHANNELTYPE_RAINSENSOR);
     channel.setDefault(SUPLA_CHANNELFNC_RAINSENSOR);
     channel.setNewValue(RAIN_NOT_AVAILABLE);
+    useChannelUpdateIteration();
   }
 
   virtual double getValue() {
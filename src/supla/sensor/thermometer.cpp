@@ -21,6 +21,7 @@
 Supla::Sensor::Thermometer::Thermometer() : lastReadTime(0) {
   channel.setType(SUPLA_CHANNELTYPE_THERMOMETER);
   channel.setDefault(SUPLA_CHANNELFNC_THERMOMETER);
+  useChannelUpdateIteration();
 }
 
 void Supla::Sensor::Thermometer::onInit() {
@@ -22,6 +22,7 @@ namespace Sensor {
 
 VirtualBinary::VirtualBinary() : state(false), lastReadTime(0) {
   channel.setType(SUPLA_CHANNELTYPE_SENSORNO);
+  useChannelUpdateIteration();
 }
 
 bool VirtualBinary::getValue() {
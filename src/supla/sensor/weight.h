@@ -32,6 +32,7 @@ class Weight : public ChannelElement {
     channel.setType(SUPLA_CHANNELTYPE_WEIGHTSENSOR);
     channel.setDefault(SUPLA_CHANNELFNC_WEIGHTSENSOR);
     channel.setNewValue(WEIGHT_NOT_AVAILABLE);
+    useChannelUpdateIteration();
   }
 
   virtual double getValue() {
@@ -31,6 +31,7 @@ class Wind : public ChannelElement {
     channel.setType(SUPLA_CHANNELTYPE_WINDSENSOR);
     channel.setDefault(SUPLA_CHANNELFNC_WINDSENSOR);
     channel.setNewValue(WIND_NOT_AVAILABLE);
+    useChannelUpdateIteration();
   }
 
   virtual double getValue() {
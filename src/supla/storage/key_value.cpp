@@ -27,6 +27,21 @@
 
 #include "key_value.h"
 
+namespace {
+
+// FNV-1a of key limited to SUPLA_STORAGE_KEY_SIZE characters (the same part
+// of key which is compared by KeyValueElement::isKeyEqual)
+uint32_t keyHash(const char* key) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < SUPLA_STORAGE_KEY_SIZE && key[i]; i++) {
+    hash ^= static_cast<uint8_t>(key[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace
+
 namespace Supla {
 KeyValue::~KeyValue() {
   removeAllMemory();
@@ -36,9 +51,21 @@ void KeyValue::removeAllMemory() {
   auto element = first;
   while (element) {
     first = element->getNext();
-    delete element;
+    if (element < elementPool || element >= elementPool + elementPoolSize) {
+      delete element;
+    }
     element = first;
   }
+  last = nullptr;
+  delete[] elementPool;
+  elementPool = nullptr;
+  elementPoolSize = 0;
+  delete[] valueArena;
+  valueArena = nullptr;
+  delete[] index;
+  index = nullptr;
+  indexCapacity = 0;
+  indexedCount = 0;
 }
 
 void KeyValue::removeAll() {
@@ -74,110 +101,142 @@ bool KeyValue::initFromMemory(uint8_t* input, size_t inputSize) {
     return false;
   }
 
+  const size_t headerSize = SUPLA_STORAGE_KEY_SIZE + 1 /* dataType */ +
+                            2 /* size */;
   auto endPtr = input + inputSize;
-  while (input + SUPLA_STORAGE_KEY_SIZE + 1 + 2 < endPtr) {
-    char key[SUPLA_STORAGE_KEY_SIZE + 1] = {};
-    memcpy(key, input, SUPLA_STORAGE_KEY_SIZE);
+
+  // First pass counts records and size of string/blob values, so elements
+  // and values can be allocated at once
+  size_t count = 0;
+  size_t valuesSize = 0;
+  for (auto ptr = input; ptr + headerSize < endPtr;) {
+    uint16_t size;
+    memcpy(&size, ptr + SUPLA_STORAGE_KEY_SIZE + 1, sizeof(size));
+    switch (ptr[SUPLA_STORAGE_KEY_SIZE]) {
+      case DATA_TYPE_UINT8:
+      case DATA_TYPE_INT8: {
+        size = 1;
+        break;
+      }
+      case DATA_TYPE_UINT32:
+      case DATA_TYPE_INT32: {
+        size = 4;
+        break;
+      }
+      case DATA_TYPE_BLOB:
+      case DATA_TYPE_STRING: {
+        valuesSize += size;
+        break;
+      }
+      default: {
+        // invalid record - reported in second pass
+        ptr = endPtr;
+        continue;
+      }
+    }
+    count++;
+    ptr += headerSize + size;
+  }
+
+  if (count > 0) {
+    elementPool = new KeyValueElement[count];
+    elementPoolSize = count;
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+      capacity *= 2;
+    }
+    rebuildIndex(capacity);
+  }
+  if (valuesSize > 0) {
+    valueArena = new uint8_t[valuesSize];
+  }
+
+  size_t poolUsed = 0;
+  uint8_t* arenaPtr = valueArena;
+  while (input + headerSize < endPtr && poolUsed < count) {
+    auto element = &elementPool[poolUsed++];
+    memcpy(element->key, input, SUPLA_STORAGE_KEY_SIZE);
     input += SUPLA_STORAGE_KEY_SIZE;
 
-    auto element = new KeyValueElement(key);
-    switch (*input) {
+    uint8_t dataType = *input;
+    input++;  // dataType
+    uint16_t size;
+    memcpy(&size, input, sizeof(size));
+    input += 2;  // size
+
+    switch (dataType) {
       case DATA_TYPE_UINT8: {
-        input++;     // dataType
-        input += 2;  // skip size
-        if (input < endPtr) {
-          element->setUInt8(*input);
-        } else {
-          delete element;
+        if (input >= endPtr) {
           return false;
         }
+        element->setUInt8(*input);
         input++;
         break;
       }
       case DATA_TYPE_INT8: {
-        input++;     // dataType
-        input += 2;  // skip size
-        if (input < endPtr) {
-          element->setInt8(static_cast<int8_t>(*input));
-        } else {
-          delete element;
+        if (input >= endPtr) {
           return false;
         }
+        element->setInt8(static_cast<int8_t>(*input));
         input++;
         break;
       }
       case DATA_TYPE_UINT32: {
-        input++;     // dataType
-        input += 2;  // skip size
-        if (input + 3 < endPtr) {
-          uint32_t value;
-          memcpy(&value, input, sizeof(value));
-          element->setUInt32(value);
-        } else {
-          delete element;
+        if (input + 3 >= endPtr) {
           return false;
         }
+        uint32_t value;
+        memcpy(&value, input, sizeof(value));
+        element->setUInt32(value);
         input += 4;
         break;
       }
       case DATA_TYPE_INT32: {
-        input++;     // dataType
-        input += 2;  // skip size
-        if (input + 3 < endPtr) {
-          int32_t value;
-          memcpy(&value, input, sizeof(value));
-          element->setInt32(value);
-        } else {
-          delete element;
+        if (input + 3 >= endPtr) {
           return false;
         }
+        int32_t value;
+        memcpy(&value, input, sizeof(value));
+        element->setInt32(value);
         input += 4;
         break;
       }
       case DATA_TYPE_BLOB: {
-        input++;  // dataType
-        uint16_t size;
-        memcpy(&size, input, sizeof(size));
-        input += 2;  // size
-        if (input + size - 1 < endPtr) {
-          char* buffer = new char[size];
-          memcpy(buffer, input, size);
-          element->setBlob(buffer, size);
-          delete[] buffer;
-        } else {
-          delete element;
+        if (input + size > endPtr) {
           return false;
         }
+        if (size > 0) {
+          memcpy(arenaPtr, input, size);
+        }
+        element->setExternalValue(DATA_TYPE_BLOB, arenaPtr, size);
+        arenaPtr += size;
         input += size;
         break;
       }
       case DATA_TYPE_STRING: {
-        input++;  // dataType
-        uint16_t size;
-        memcpy(&size, input, sizeof(size));
-        input += 2;  // size
-        if (input + size - 1 < endPtr) {
-          char* buffer = new char[size];
-          memcpy(buffer, input, size);
-          element->setString(buffer);
-          delete[] buffer;
-        } else {
-          delete element;
+        if (size == 0 || input + size > endPtr) {
           return false;
         }
+        memcpy(arenaPtr, input, size);
+        arenaPtr[size - 1] = '\0';
+        unsigned int stringSize = strlen(reinterpret_cast<char*>(arenaPtr)) + 1;
+        element->setExternalValue(DATA_TYPE_STRING, arenaPtr, stringSize);
+        arenaPtr += size;
         input += size;
         break;
       }
       default: {
-        delete element;
         return false;
       }
     }
+
     if (!first) {
       first = element;
     } else {
-      first->add(element);
+      last->next = element;
     }
+    last = element;
+    addToIndex(element);
   }
 
   if (input < endPtr) {
@@ -197,12 +256,14 @@ size_t KeyValue::serializeToMemory(uint8_t* output, size_t outputMaxSize) {
 }
 
 KeyValueElement* KeyValue::find(const char* key) {
-  auto element = first;
-  while (element) {
-    if (element->isKeyEqual(key)) {
-      return element;
+  if (indexCapacity == 0) {
+    return nullptr;
+  }
+  size_t mask = indexCapacity - 1;
+  for (size_t i = keyHash(key) & mask; index[i]; i = (i + 1) & mask) {
+    if (index[i]->isKeyEqual(key)) {
+      return index[i];
     }
-    element = element->getNext();
   }
   return nullptr;
 }
@@ -211,12 +272,52 @@ KeyValueElement* KeyValue::findOrCreate(const char* key) {
   auto element = find(key);
   if (!element) {
     element = new KeyValueElement(key);
-    element->add(first);
+    element->next = first;
     first = element;
+    if (!last) {
+      last = element;
+    }
+    addToIndex(element);
   }
   return element;
 }
 
+void KeyValue::addToIndex(KeyValueElement* element) {
+  if (find(element->key)) {
+    // duplicated key - the first element in list is used
+    return;
+  }
+  // load factor is kept below 0.5, so probe sequences are short
+  if ((indexedCount + 1) * 2 > indexCapacity) {
+    rebuildIndex(indexCapacity == 0 ? 16 : indexCapacity * 2);
+  }
+  insertToIndex(element);
+}
+
+void KeyValue::insertToIndex(KeyValueElement* element) {
+  size_t mask = indexCapacity - 1;
+  size_t i = keyHash(element->key) & mask;
+  while (index[i]) {
+    i = (i + 1) & mask;
+  }
+  index[i] = element;
+  indexedCount++;
+}
+
+void KeyValue::rebuildIndex(size_t newCapacity) {
+  auto oldIndex = index;
+  auto oldCapacity = indexCapacity;
+  index = new KeyValueElement*[newCapacity]();
+  indexCapacity = newCapacity;
+  indexedCount = 0;
+  for (size_t i = 0; i < oldCapacity; i++) {
+    if (oldIndex[i]) {
+      insertToIndex(oldIndex[i]);
+    }
+  }
+  delete[] oldIndex;
+}
+
 bool KeyValue::setString(const char* key, const char* value) {
   auto element = findOrCreate(key);
   return element->setString(value);
@@ -316,6 +417,17 @@ KeyValueElement::KeyValueElement(const char* keyName) {
 }
 
 KeyValueElement::~KeyValueElement() {
+  releaseValue();
+}
+
+void KeyValueElement::releaseValue() {
+  if (externalValue) {
+    externalValue = false;
+    size = 0;
+    data.uint8ptr = nullptr;
+    return;
+  }
+
   if (size > 0 && data.charPtr && dataType == DATA_TYPE_STRING) {
     delete[] data.charPtr;
     size = 0;
@@ -329,6 +441,16 @@ KeyValueElement::~KeyValueElement() {
   }
 }
 
+void KeyValueElement::setExternalValue(enum DataType type,
+                                       uint8_t* buffer,
+                                       unsigned int size) {
+  releaseValue();
+  dataType = type;
+  externalValue = true;
+  this->size = size;
+  data.uint8ptr = buffer;
+}
+
 bool KeyValueElement::isKeyEqual(const char* keyToCheck) {
   return strncmp(key, keyToCheck, SUPLA_STORAGE_KEY_SIZE) == 0;
 }
@@ -365,7 +487,7 @@ bool KeyValueElement::setString(const char* value) {
     return false;
   }
   if (newSize != size) {
-    delete[] data.charPtr;
+    releaseValue();
     size = newSize;
     data.charPtr = new char[size];
   }
@@ -402,7 +524,7 @@ bool KeyValueElement::setBlob(const char* value, size_t blobSize) {
     return false;
   }
   if (blobSize != size) {
-    delete[] data.uint8ptr;
+    releaseValue();
     size = blobSize;
     data.uint8ptr = new uint8_t[size];
   }
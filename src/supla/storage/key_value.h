@@ -29,6 +29,9 @@
 namespace Supla {
 class KeyValueElement;
 
+// Keys are kept in a list (which defines serialization order) and indexed by
+// open addressing hash table. Elements loaded by initFromMemory() and their
+// string/blob values are allocated in single blocks instead of per key.
 class KeyValue : public Config {
  public:
   ~KeyValue();
@@ -61,7 +64,21 @@ class KeyValue : public Config {
  protected:
   KeyValueElement* find(const char* key);
   KeyValueElement* findOrCreate(const char* key);
+  // Adds element to hash index, unless element with the same key is already
+  // there. Index is grown when needed.
+  void addToIndex(KeyValueElement* element);
+  void insertToIndex(KeyValueElement* element);
+  void rebuildIndex(size_t newCapacity);
+
   KeyValueElement* first = nullptr;
+  KeyValueElement* last = nullptr;
+  KeyValueElement** index = nullptr;
+  size_t indexCapacity = 0;
+  size_t indexedCount = 0;
+  // Blocks allocated by initFromMemory()
+  KeyValueElement* elementPool = nullptr;
+  size_t elementPoolSize = 0;
+  uint8_t* valueArena = nullptr;
 };
 
 enum DataType {
@@ -104,10 +121,18 @@ class KeyValueElement {
   bool setUInt32(const uint32_t value);
 
  protected:
+  friend class KeyValue;
+  KeyValueElement() = default;
+  // Uses memory owned by KeyValue (value arena) for string/blob value. It is
+  // used until value with different size is set.
+  void setExternalValue(enum DataType type, uint8_t* buffer, unsigned int size);
+  void releaseValue();
+
   KeyValueElement* next = nullptr;
   char key[SUPLA_STORAGE_KEY_SIZE] = {};
   enum DataType dataType = DATA_TYPE_NOT_SET;
   unsigned int size = 0;  // set only for blob and string
+  bool externalValue = false;
   union {
     uint8_t* uint8ptr = nullptr;
     char* charPtr;
@@ -20,6 +20,7 @@
 #include <supla/log_wrapper.h>
 #include <supla/time.h>
 
+#include "../crc16.h"
 #include "config.h"
 #include "storage.h"
 
@@ -27,6 +28,18 @@
 
 namespace Supla {
 
+namespace {
+
+const unsigned char stateLogTag[] = {'S', 'L'};
+
+uint16_t stateLogRecordFieldsCrc(const StateLogRecord &record) {
+  uint16_t crc =
+      crc16_update_buf(0xFFFF, &record.sequence, sizeof(record.sequence));
+  return crc16_update_buf(crc, &record.size, sizeof(record.size));
+}
+
+}  // namespace
+
 Storage *Storage::instance = nullptr;
 Config *Storage::configInstance = nullptr;
 
@@ -94,6 +107,26 @@ void Storage::ScheduleSave(uint64_t delayMs) {
   }
 }
 
+void Storage::BeginElementState() {
+  if (Instance()) {
+    Instance()->beginElementState();
+  }
+}
+
+bool Storage::SkipElementState() {
+  if (Instance()) {
+    return Instance()->skipElementState();
+  }
+  return false;
+}
+
+bool Storage::IsElementStateEmpty() {
+  if (Instance()) {
+    return Instance()->isElementStateEmpty();
+  }
+  return true;
+}
+
 void Storage::SetConfigInstance(Config *instance) {
   configInstance = instance;
 }
@@ -114,23 +147,63 @@ Storage::Storage(unsigned int storageStartingOffset)
       newSectionSize(0),
       sectionsCount(0),
       dryRun(false),
+      elementStateCrcValid(true),
+      elementSliceOffsets(nullptr),
+      elementSlicesCount(0),
+      elementSlicesCapacity(0),
+      currentElementSlice(0),
+      currentElementSliceStart(0),
+      elementSlicesEnd(0),
+      elementSlicesValid(false),
+      stateLogOffset(0),
+      stateLogSize(0),
+      stateLogRecordOffset(0),
+      stateLogRecordSize(0),
+      stateLogSequence(0),
+      stateLogRecordValid(false),
+      stateLogWriteOffset(0),
+      stateLogWriting(false),
       saveStatePeriod(1000),
       lastWriteTimestamp(0) {
   instance = this;
 }
 
 Storage::~Storage() {
+  delete[] elementSliceOffsets;
   instance = nullptr;
 }
 
 bool Storage::prepareState(bool performDryRun) {
   dryRun = performDryRun;
   newSectionSize = 0;
+  currentElementSlice = 0;
+  if (dryRun) {
+    elementSlicesCount = 0;
+    elementSlicesValid = false;
+  }
+  if (stateLogSize > 0) {
+    // read from the newest record, new record for write is selected on
+    // first write
+    stateLogWriting = false;
+    currentStateOffset = stateLogRecordOffset + sizeof(StateLogRecord);
+    return true;
+  }
   currentStateOffset = elementStateOffset + sizeof(SectionPreamble);
   return true;
 }
 
 bool Storage::readState(unsigned char *buf, int size) {
+  if (stateLogSize > 0) {
+    if (!stateLogRecordValid ||
+        stateLogRecordOffset + sizeof(StateLogRecord) + stateLogRecordSize <
+            currentStateOffset + size) {
+      SUPLA_LOG_DEBUG("Warning! Attempt to read state outside of log record");
+      return false;
+    }
+    currentStateOffset += readStorage(currentStateOffset, buf, size);
+    return true;
+  }
+
   if (elementStateOffset + sizeof(SectionPreamble) + elementStateSize <
       currentStateOffset + size) {
     SUPLA_LOG_DEBUG(
@@ -148,6 +221,37 @@ bool Storage::writeState(const unsigned char *buf, int size) {
     return true;
   }
 
+  if (stateLogSize > 0) {
+    if (dryRun) {
+      return true;
+    }
+    if (!stateLogWriting) {
+      // new record is written after the newest one, or at the beginning of
+      // the area if it doesn't fit
+      unsigned int offset = stateLogOffset;
+      if (stateLogRecordValid) {
+        offset =
+            stateLogRecordOffset + sizeof(StateLogRecord) + stateLogRecordSize;
+      }
+      unsigned int expectedSize =
+          elementSlicesValid ? elementSlicesEnd : newSectionSize;
+      if (offset + sizeof(StateLogRecord) + expectedSize >
+          stateLogOffset + stateLogSize) {
+        offset = stateLogOffset;
+      }
+      stateLogWriteOffset = offset;
+      stateLogWriting = true;
+      currentStateOffset =
+          offset + sizeof(StateLogRecord) + newSectionSize - size;
+    }
+    if (currentStateOffset + size > stateLogOffset + stateLogSize) {
+      SUPLA_LOG_WARNING("Storage: element state doesn't fit in log area");
+      return false;
+    }
+    currentStateOffset += updateStorage(currentStateOffset, buf, size);
+    return true;
+  }
+
   if (elementStateSize > 0 &&
       elementStateOffset + sizeof(SectionPreamble) + elementStateSize <
           currentStateOffset + size) {
@@ -157,6 +261,7 @@ bool Storage::writeState(const unsigned char *buf, int size) {
         "Storage: rewriting element state section. All data will be lost.");
     elementStateSize = 0;
     elementStateOffset = 0;
+    elementSlicesValid = false;
     return false;
   }
 
@@ -199,9 +304,87 @@ bool Storage::writeState(const unsigned char *buf, int size) {
   return true;
 }
 
+void Storage::beginElementState() {
+  currentElementSliceStart = newSectionSize;
+  if (dryRun) {
+    if (elementSlicesCount >= elementSlicesCapacity) {
+      int newCapacity =
+          elementSlicesCapacity == 0 ? 8 : elementSlicesCapacity * 2;
+      uint16_t *newOffsets = new uint16_t[newCapacity];
+      if (elementSliceOffsets) {
+        memcpy(newOffsets,
+               elementSliceOffsets,
+               elementSlicesCount * sizeof(uint16_t));
+        delete[] elementSliceOffsets;
+      }
+      elementSliceOffsets = newOffsets;
+      elementSlicesCapacity = newCapacity;
+    }
+    elementSliceOffsets[elementSlicesCount++] = newSectionSize;
+    return;
+  }
+
+  if (currentElementSlice >= elementSlicesCount ||
+      elementSliceOffsets[currentElementSlice] != newSectionSize) {
+    // previous element wrote different amount of data than during dry run
+    elementSlicesValid = false;
+  }
+  currentElementSlice++;
+}
+
+bool Storage::skipElementState() {
+  // each log record contains whole state, so nothing can be skipped
+  if (dryRun || stateLogSize > 0 || !elementSlicesValid ||
+      elementStateOffset == 0 ||
+      elementStateSize != elementSlicesEnd || currentElementSlice == 0 ||
+      currentElementSlice > elementSlicesCount) {
+    return false;
+  }
+
+  unsigned int sliceEnd = elementSlicesEnd;
+  if (currentElementSlice < elementSlicesCount) {
+    sliceEnd = elementSliceOffsets[currentElementSlice];
+  }
+  unsigned int sliceSize =
+      sliceEnd - elementSliceOffsets[currentElementSlice - 1];
+  newSectionSize += sliceSize;
+  currentStateOffset += sliceSize;
+  return true;
+}
+
+bool Storage::isElementStateEmpty() {
+  return newSectionSize == currentElementSliceStart;
+}
+
 bool Storage::finalizeSaveState() {
   if (dryRun) {
     dryRun = false;
+    // Slices are valid for current device configuration, even if stored
+    // section doesn't match it - it will be rewritten on first save
+    elementSlicesValid = true;
+    elementSlicesEnd = newSectionSize;
+    if (stateLogSize > 0) {
+      // two records are needed, so interrupted write doesn't destroy the
+      // previous one
+      if (2 * (sizeof(StateLogRecord) + newSectionSize) > stateLogSize) {
+        SUPLA_LOG_WARNING(
+            "Storage: state log area size %d doesn't fit two records of "
+            "state size %d",
+            stateLogSize,
+            newSectionSize);
+      }
+      if (!stateLogRecordValid) {
+        SUPLA_LOG_DEBUG("Storage: no valid element state log record");
+        return false;
+      }
+      if (stateLogRecordSize != newSectionSize) {
+        SUPLA_LOG_DEBUG(
+            "Element state log record size doesn't match current device "
+            "configuration");
+        return false;
+      }
+      return true;
+    }
     if (elementStateSize != newSectionSize) {
       SUPLA_LOG_DEBUG(
                 "Element state section size doesn't match current device "
@@ -210,15 +393,27 @@ bool Storage::finalizeSaveState() {
       elementStateSize = 0;
       return false;
     }
+    if (!elementStateCrcValid) {
+      SUPLA_LOG_WARNING("Element state section CRC is invalid");
+      return false;
+    }
     return true;
   }
 
+  if (stateLogSize > 0) {
+    return finalizeStateLogRecord();
+  }
+
   SectionPreamble preamble;
   preamble.type = STORAGE_SECTION_TYPE_ELEMENT_STATE;
   preamble.size = newSectionSize;
-  preamble.crc1 = 0;
-  preamble.crc2 = 0;
-  // TODO(klew): add crc calculation
+  preamble.crc1 = calculateStateCrc(newSectionSize);
+  preamble.crc2 = preamble.crc1;
+  elementStateCrcValid = true;
+  if (newSectionSize != elementSlicesEnd) {
+    elementSlicesValid = false;
+  }
+  elementStateSize = newSectionSize;
 
   updateStorage(
       elementStateOffset, (unsigned char *)&preamble, sizeof(preamble));
@@ -227,6 +422,83 @@ bool Storage::finalizeSaveState() {
   return true;
 }
 
+bool Storage::finalizeStateLogRecord() {
+  if (newSectionSize != elementSlicesEnd) {
+    elementSlicesValid = false;
+  }
+  if (!stateLogWriting) {
+    // nothing was written
+    return newSectionSize == 0;
+  }
+  stateLogWriting = false;
+  if (stateLogWriteOffset + sizeof(StateLogRecord) + newSectionSize >
+      stateLogOffset + stateLogSize) {
+    return false;
+  }
+
+  StateLogRecord record;
+  memcpy(record.tag, stateLogTag, sizeof(record.tag));
+  record.sequence = stateLogSequence + 1;
+  record.size = newSectionSize;
+  record.crc = calculateCrc(stateLogWriteOffset + sizeof(StateLogRecord),
+                            newSectionSize,
+                            stateLogRecordFieldsCrc(record));
+
+  // header is written after data, so interrupted write leaves the previous
+  // record valid
+  updateStorage(
+      stateLogWriteOffset, (unsigned char *)&record, sizeof(record));
+  commit();
+
+  stateLogRecordOffset = stateLogWriteOffset;
+  stateLogRecordSize = newSectionSize;
+  stateLogSequence = record.sequence;
+  stateLogRecordValid = true;
+  return true;
+}
+
+void Storage::loadStateLog() {
+  stateLogRecordValid = false;
+  stateLogSequence = 0;
+  unsigned int offset = stateLogOffset;
+  unsigned int end = stateLogOffset + stateLogSize;
+  while (offset + sizeof(StateLogRecord) <= end) {
+    StateLogRecord record = {};
+    readStorage(offset, (unsigned char *)&record, sizeof(record), false);
+    if (memcmp(record.tag, stateLogTag, sizeof(record.tag)) ||
+        offset + sizeof(record) + record.size > end) {
+      break;
+    }
+    // record with invalid CRC (i.e. interrupted write) is skipped, but
+    // following ones are still checked
+    uint16_t crc = calculateCrc(offset + sizeof(record),
+                                record.size,
+                                stateLogRecordFieldsCrc(record));
+    if (crc == record.crc &&
+        (!stateLogRecordValid || record.sequence > stateLogSequence)) {
+      stateLogRecordValid = true;
+      stateLogRecordOffset = offset;
+      stateLogRecordSize = record.size;
+      stateLogSequence = record.sequence;
+    }
+    offset += sizeof(record) + record.size;
+  }
+
+  if (stateLogRecordValid) {
+    SUPLA_LOG_DEBUG("Storage: state log record %d at %d (size %d)",
+                    static_cast<int>(stateLogSequence),
+                    stateLogRecordOffset,
+                    stateLogRecordSize);
+  } else {
+    SUPLA_LOG_DEBUG("Storage: state log area is empty");
+  }
+}
+
+void Storage::setStateLogArea(unsigned int offset, unsigned int size) {
+  stateLogOffset = offset;
+  stateLogSize = size;
+}
+
 bool Storage::init() {
   SUPLA_LOG_DEBUG("Storage initialization");
   unsigned int currentOffset = storageStartingOffset;
@@ -257,10 +529,6 @@ bool Storage::init() {
     SUPLA_LOG_DEBUG("Storage: Number of sections %d", preamble.sectionsCount);
   }
 
-  if (preamble.sectionsCount == 0) {
-    return true;
-  }
-
   for (int i = 0; i < preamble.sectionsCount; i++) {
     SUPLA_LOG_DEBUG("Reading section: %d", i);
     SectionPreamble section;
@@ -293,6 +561,18 @@ bool Storage::init() {
       case STORAGE_SECTION_TYPE_ELEMENT_STATE: {
         elementStateOffset = sectionOffset;
         elementStateSize = section.size;
+        // crc == 0 is used by older versions, which didn't calculate CRC
+        if (section.crc1 != 0 || section.crc2 != 0) {
+          uint16_t crc = calculateStateCrc(section.size);
+          if (crc != section.crc1 && crc != section.crc2) {
+            SUPLA_LOG_WARNING(
+                "Storage: element state section CRC mismatch (0x%04X != "
+                "0x%04X). State will not be loaded",
+                crc,
+                section.crc1);
+            elementStateCrcValid = false;
+          }
+        }
         break;
       }
       default: {
@@ -303,6 +583,36 @@ bool Storage::init() {
     currentOffset += section.size;
   }
 
+  if (stateLogSize > 0) {
+    if (isStateLogAreaValid(currentOffset)) {
+      loadStateLog();
+    } else {
+      // state is kept in element state section instead
+      stateLogSize = 0;
+    }
+  }
+
+  return true;
+}
+
+bool Storage::isStateLogAreaValid(unsigned int sectionsEnd) const {
+  if (stateLogOffset < sectionsEnd &&
+      stateLogOffset + stateLogSize > storageStartingOffset) {
+    SUPLA_LOG_ERROR(
+        "Storage: state log area (%d, size %d) overlaps storage sections "
+        "(%d - %d). State log disabled",
+        stateLogOffset,
+        stateLogSize,
+        storageStartingOffset,
+        sectionsEnd);
+    return false;
+  }
+  if (stateLogSize < 2 * sizeof(StateLogRecord)) {
+    SUPLA_LOG_ERROR(
+        "Storage: state log area size %d is too small. State log disabled",
+        stateLogSize);
+    return false;
+  }
   return true;
 }
 
@@ -324,6 +634,24 @@ int Storage::updateStorage(unsigned int offset,
   return size;
 }
 
+uint16_t Storage::calculateStateCrc(unsigned int size) {
+  return calculateCrc(elementStateOffset + sizeof(SectionPreamble), size);
+}
+
+uint16_t Storage::calculateCrc(unsigned int offset,
+                               unsigned int size,
+                               uint16_t crc) {
+  unsigned char buf[32];
+  while (size > 0) {
+    int chunk = size > sizeof(buf) ? sizeof(buf) : size;
+    readStorage(offset, buf, chunk, false);
+    crc = crc16_update_buf(crc, buf, chunk);
+    offset += chunk;
+    size -= chunk;
+  }
+  return crc;
+}
+
 void Storage::setStateSavePeriod(uint64_t periodMs) {
   if (periodMs < 1000) {
     saveStatePeriod = 1000;
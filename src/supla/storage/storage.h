@@ -38,6 +38,16 @@ class Storage {
   static bool WriteState(const unsigned char *, int);
   static bool PrepareState(bool dryRun = false);
   static bool FinalizeSaveState();
+  // Marks beginning of next element's data in state section. It has to be
+  // called before each element's onSaveState() (or SkipElementState()).
+  static void BeginElementState();
+  // Skips current element's data in state section, so data stored previously
+  // is kept. Returns false when element's slice can't be skipped (i.e. section
+  // is not written yet, or layout changed) - onSaveState() has to be called
+  // then.
+  static bool SkipElementState();
+  // Returns true when current element didn't write any data to state section
+  static bool IsElementStateEmpty();
   static bool SaveStateAllowed(uint64_t);
   static void ScheduleSave(uint64_t delayMs);
   static void SetConfigInstance(Config *instance);
@@ -49,12 +59,27 @@ class Storage {
   // Changes default state save period time
   virtual void setStateSavePeriod(uint64_t periodMs);
 
+  // Enables log structured element state area. Each state save appends new
+  // record (with sequence number and CRC) after the previous one, wrapping
+  // to the beginning of the area when there is no space left, so writes are
+  // spread over whole area instead of single element state section.
+  // On init, record with the highest sequence number and valid CRC is used.
+  // Offset is absolute and area should not overlap with storage sections
+  // (i.e. place it after config). Area should fit at least two records, so
+  // interrupted write doesn't destroy the previous one. It has to be called
+  // before init(). Area which overlaps sections found by init() is rejected
+  // and state is then kept in element state section.
+  void setStateLogArea(unsigned int offset, unsigned int size);
+
   virtual bool init();
   virtual bool readState(unsigned char *, int);
   virtual bool writeState(const unsigned char *, int);
 
   virtual bool prepareState(bool performDryRun);
   virtual bool finalizeSaveState();
+  virtual void beginElementState();
+  virtual bool skipElementState();
+  virtual bool isElementStateEmpty();
   virtual bool saveStateAllowed(uint64_t);
   virtual void scheduleSave(uint64_t delayMs);
 
@@ -64,6 +89,18 @@ class Storage {
   virtual int readStorage(unsigned int, unsigned char *, int, bool = true) = 0;
   virtual int writeStorage(unsigned int, const unsigned char *, int) = 0;
   virtual int updateStorage(unsigned int, const unsigned char *, int);
+  // Calculates CRC of element state section data
+  uint16_t calculateStateCrc(unsigned int size);
+  uint16_t calculateCrc(unsigned int offset,
+                        unsigned int size,
+                        uint16_t crc = 0xFFFF);
+
+  // Checks that state log area doesn't overlap sections which end at
+  // sectionsEnd and fits at least two record headers
+  bool isStateLogAreaValid(unsigned int sectionsEnd) const;
+  // Finds the newest valid record in state log area
+  void loadStateLog();
+  bool finalizeStateLogRecord();
 
   unsigned int storageStartingOffset;
   unsigned int deviceConfigOffset;
@@ -79,6 +116,29 @@ class Storage {
   unsigned int newSectionSize;
   int sectionsCount;
   bool dryRun;
+  bool elementStateCrcValid;
+
+  // Offsets of elements' data relative to state section data beginning,
+  // recorded during dry run. Used to skip elements with not changed state.
+  uint16_t *elementSliceOffsets;
+  int elementSlicesCount;
+  int elementSlicesCapacity;
+  int currentElementSlice;
+  unsigned int currentElementSliceStart;
+  unsigned int elementSlicesEnd;
+  bool elementSlicesValid;
+
+  // Log structured state area (disabled when stateLogSize == 0)
+  unsigned int stateLogOffset;
+  unsigned int stateLogSize;
+  // The newest valid record
+  unsigned int stateLogRecordOffset;
+  unsigned int stateLogRecordSize;
+  uint32_t stateLogSequence;
+  bool stateLogRecordValid;
+  // Record which is currently written
+  unsigned int stateLogWriteOffset;
+  bool stateLogWriting;
 
   uint64_t saveStatePeriod;
   uint64_t lastWriteTimestamp;
@@ -100,6 +160,15 @@ struct SectionPreamble {
   uint16_t crc1;
   uint16_t crc2;
 };
+
+// Header of element state record in log structured state area. CRC is
+// calculated over sequence, size and record data.
+struct StateLogRecord {
+  unsigned char tag[2];
+  uint32_t sequence;
+  uint16_t size;
+  uint16_t crc;
+};
 #pragma pack(pop)
 
 };  // namespace Supla
@@ -0,0 +1,128 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#include "uplink_filter.h"
+
+#include <math.h>
+
+#include "channel.h"
+
+void Supla::UplinkFilter::setDeadband(double deadband, bool relative) {
+  this->deadband = deadband < 0 ? 0 : deadband;
+  relativeDeadband = relative;
+}
+
+void Supla::UplinkFilter::setMinIntervalMs(uint32_t intervalMs) {
+  minIntervalMs = intervalMs;
+}
+
+void Supla::UplinkFilter::setHeartbeatMs(uint32_t intervalMs) {
+  heartbeatMs = intervalMs;
+}
+
+bool Supla::UplinkFilter::hasHeartbeat() const {
+  return heartbeatMs > 0;
+}
+
+bool Supla::UplinkFilter::isSendDue(Channel *channel,
+                                    bool valueChanged,
+                                    uint64_t now) const {
+  if (heartbeatMs > 0 && now - lastSentMs >= heartbeatMs) {
+    return true;
+  }
+  if (!valueChanged) {
+    return false;
+  }
+  if (!sentOnce) {
+    return true;
+  }
+  if (minIntervalMs > 0 && now - lastSentMs < minIntervalMs) {
+    return false;
+  }
+  return exceedsDeadband(channel);
+}
+
+void Supla::UplinkFilter::onValueChanged() {
+  changeCount++;
+}
+
+void Supla::UplinkFilter::onSent(Channel *channel,
+                                 bool valueChanged,
+                                 uint64_t now) {
+  sentCount++;
+  if (valueChanged) {
+    sentChangeCount++;
+  }
+  lastSentMs = now;
+  sentOnce = true;
+  lastSentValuesCount = readValues(channel, lastSentValues);
+}
+
+uint32_t Supla::UplinkFilter::getSentCount() const {
+  return sentCount;
+}
+
+uint32_t Supla::UplinkFilter::getSuppressedCount(bool valueChanged) const {
+  uint32_t notSent = changeCount - sentChangeCount;
+  if (valueChanged && notSent > 0) {
+    notSent--;
+  }
+  return notSent;
+}
+
+int Supla::UplinkFilter::readValues(Channel *channel, double values[2]) {
+  switch (channel->getChannelType()) {
+    case SUPLA_CHANNELTYPE_DISTANCESENSOR:
+    case SUPLA_CHANNELTYPE_THERMOMETER:
+    case SUPLA_CHANNELTYPE_WINDSENSOR:
+    case SUPLA_CHANNELTYPE_PRESSURESENSOR:
+    case SUPLA_CHANNELTYPE_RAINSENSOR:
+    case SUPLA_CHANNELTYPE_WEIGHTSENSOR:
+      values[0] = channel->getValueDouble();
+      return 1;
+    case SUPLA_CHANNELTYPE_IMPULSE_COUNTER:
+      values[0] = channel->getValueInt64();
+      return 1;
+    case SUPLA_CHANNELTYPE_HUMIDITYANDTEMPSENSOR:
+    case SUPLA_CHANNELTYPE_HUMIDITYSENSOR:
+      values[0] = channel->getValueDoubleFirst();
+      values[1] = channel->getValueDoubleSecond();
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+bool Supla::UplinkFilter::exceedsDeadband(Channel *channel) const {
+  if (deadband <= 0) {
+    return true;
+  }
+  double values[2] = {};
+  int count = readValues(channel, values);
+  if (count == 0 || count != lastSentValuesCount) {
+    return true;
+  }
+  for (int i = 0; i < count; i++) {
+    double limit = deadband;
+    if (relativeDeadband) {
+      limit = fabs(lastSentValues[i]) * deadband / 100.0;
+    }
+    if (fabs(values[i] - lastSentValues[i]) > limit) {
+      return true;
+    }
+  }
+  return false;
+}
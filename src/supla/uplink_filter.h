@@ -0,0 +1,74 @@
+/*
+ Copyright (C) AC SOFTWARE SP. Z O.O.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*/
+
+#ifndef SRC_SUPLA_UPLINK_FILTER_H_
+#define SRC_SUPLA_UPLINK_FILTER_H_
+
+#include <stdint.h>
+
+namespace Supla {
+
+class Channel;
+
+// Decides when channel value should be sent to server. Local value (and
+// ON_CHANGE actions) is not affected, only the uplink is filtered:
+// - deadband: value is sent only if it differs from last sent value by more
+//   than deadband (absolute, or in percent of last sent value). Deadband is
+//   applied to numeric channel types only (thermometers, humidity, impulse
+//   counters, etc.), other types are sent on any change,
+// - min interval: changed value is not sent earlier than minIntervalMs after
+//   previous send. Latest value is sent when interval passes,
+// - heartbeat: value is sent at least once per heartbeatMs, even without
+//   change.
+class UplinkFilter {
+ public:
+  void setDeadband(double deadband, bool relative = false);
+  void setMinIntervalMs(uint32_t intervalMs);
+  void setHeartbeatMs(uint32_t intervalMs);
+  bool hasHeartbeat() const;
+
+  bool isSendDue(Channel *channel, bool valueChanged, uint64_t now) const;
+  void onValueChanged();
+  void onSent(Channel *channel, bool valueChanged, uint64_t now);
+
+  uint32_t getSentCount() const;
+  // Value changes which were not sent (because of deadband, or because they
+  // were replaced by newer value during min interval). Pending value which
+  // still may be sent is not counted.
+  uint32_t getSuppressedCount(bool valueChanged) const;
+
+ protected:
+  // Returns number of numeric values of channel (0-2), 0 if deadband can't
+  // be applied for channel type
+  static int readValues(Channel *channel, double values[2]);
+  bool exceedsDeadband(Channel *channel) const;
+
+  double deadband = 0;
+  double lastSentValues[2] = {};
+  uint64_t lastSentMs = 0;
+  uint32_t minIntervalMs = 0;
+  uint32_t heartbeatMs = 0;
+  uint32_t changeCount = 0;
+  uint32_t sentCount = 0;
+  uint32_t sentChangeCount = 0;
+  uint8_t lastSentValuesCount = 0;
+  bool relativeDeadband = false;
+  bool sentOnce = false;
+};
+
+};  // namespace Supla
+
+#endif  // SRC_SUPLA_UPLINK_FILTER_H_